@@ -65,8 +65,22 @@ static int watch_dbus_addr(const char *addr, int watchit,
                            void *user_data);
 static DBusHandlerResult bluez_change(DBusConnection *c,
                                       DBusMessage *msg, void *data);
+static void bluez_owner_changed(const char *name, const char *before,
+                                const char *after, void *data);
 static DBusConnection *sys_conn;
 
+/* shared name owner tracking of the dbus plugin, if available */
+OHM_IMPORTABLE(int, add_watch, (DBusBusType type,
+                                const char *name,
+                                void (*handler)(const char *, const char *,
+                                                const char *, void *),
+                                void *data));
+OHM_IMPORTABLE(int, del_watch, (DBusBusType type,
+                                const char *name,
+                                void (*handler)(const char *, const char *,
+                                                const char *, void *),
+                                void *data));
+
 enum bt_state { BT_STATE_NONE,
     BT_STATE_CONNECTING,
     BT_STATE_CONNECTED,
@@ -1281,6 +1295,25 @@ static int watch_dbus_addr(const char *addr, int watchit,
 {
     char      match[1024];
     DBusError err;
+    char     *signature;
+
+    if (add_watch == NULL) {
+        signature = (char *)add_watch_SIGNATURE;
+        if (ohm_module_find_method("dbus.add_watch", &signature,
+                                   (void *)&add_watch)) {
+            signature = (char *)del_watch_SIGNATURE;
+            if (!ohm_module_find_method("dbus.del_watch", &signature,
+                                        (void *)&del_watch))
+                add_watch = NULL;
+        }
+    }
+
+    if (add_watch != NULL) {
+        if (watchit)
+            return add_watch(DBUS_BUS_SYSTEM, addr, bluez_owner_changed, NULL);
+        else
+            return del_watch(DBUS_BUS_SYSTEM, addr, bluez_owner_changed, NULL);
+    }
     
     snprintf(match, sizeof(match),
              "type='signal',"
@@ -1346,15 +1379,28 @@ static DBusHandlerResult bluez_change(DBusConnection *c,
         strcmp(name, BLUEZ_DBUS_NAME))
         return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
     
-    if (!after[0]) {                              /* bluez gone */
-        OHM_INFO("BlueZ is down.");
+    bluez_owner_changed(name, before, after, data);
+
+    return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+
+static void bluez_owner_changed(const char *name, const char *before,
+                                const char *after, void *data)
+{
+    (void)name;
+    (void)data;
+
+    if (!after[0]) {
+        if (!before[0])                           /* bluez not running */
+            return;
+
+        OHM_INFO("BlueZ is down.");               /* bluez gone */
         bt_delete_all_facts();
         dres_all();
     }
     else
         OHM_INFO("BlueZ is up.");
-
-    return DBUS_HANDLER_RESULT_HANDLED;
 }
 
 
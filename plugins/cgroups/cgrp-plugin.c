@@ -28,6 +28,15 @@ USA.
 int DBG_EVENT, DBG_PROCESS, DBG_CLASSIFY, DBG_NOTIFY, DBG_ACTION;
 int DBG_SYSMON, DBG_CONFIG, DBG_CURVE, DBG_LEADER;
 
+/* binary trace of the hot paths */
+trcring_t cgrp_trace;
+
+static const char *trace_events[TRACE_MAX] = {
+    [TRACE_EVENT]    = "process-event",
+    [TRACE_PRIORITY] = "set-priority",
+    [TRACE_OOM]      = "adjust-oom",
+};
+
 OHM_DEBUG_PLUGIN(cgroups,
     OHM_DEBUG_FLAG("event"   , "process events"        , &DBG_EVENT),
     OHM_DEBUG_FLAG("process" , "process watch"         , &DBG_PROCESS),
@@ -74,6 +83,7 @@ plugin_init(OhmPlugin *plugin)
     if (!OHM_DEBUG_INIT(cgroups))
         OHM_WARNING("cgrp: failed to register for debugging");
 
+    trcring_init(&cgrp_trace, plugin, "cgroups", trace_events, TRACE_MAX);
     
     if (signaling_register == NULL || signaling_unregister == NULL) {
         OHM_ERROR("cgrp: signaling interface not available");
@@ -181,6 +191,8 @@ plugin_exit(OhmPlugin *plugin)
     partition_exit(ctx);
     ctrl_del(ctx->controls);
     fact_exit(ctx);
+
+    trcring_exit(&cgrp_trace);
 }
 
 
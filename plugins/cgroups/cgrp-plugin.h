@@ -35,6 +35,7 @@ USA.
 #include "cgrp-basic-types.h"
 #include "mm.h"
 #include "list.h"
+#include "trcring.h"
 
 #define PLUGIN_PREFIX   cgroups
 #define PLUGIN_NAME    "cgroups"
@@ -719,6 +720,15 @@ typedef struct {
 extern int DBG_EVENT, DBG_PROCESS, DBG_CLASSIFY, DBG_NOTIFY, DBG_ACTION;
 extern int DBG_SYSMON, DBG_CONFIG, DBG_CURVE, DBG_LEADER;
 
+typedef enum {
+    TRACE_EVENT = 0,                        /* event type, pid, tgid */
+    TRACE_PRIORITY,                         /* pid, priority, preserve */
+    TRACE_OOM,                              /* pid, requested, mapped */
+    TRACE_MAX
+} cgrp_trace_event_t;
+
+extern trcring_t cgrp_trace;
+
 /* cgrp-process.c */
 int  proc_init(cgrp_context_t *);
 void proc_exit(cgrp_context_t *);
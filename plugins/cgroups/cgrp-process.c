@@ -540,6 +540,9 @@ netlink_cb(GIOChannel *chnl, GIOCondition mask, gpointer data)
                 continue;
             }
 
+            TRC_RECORD(&cgrp_trace, TRACE_EVENT,
+                       event.any.type, event.any.pid, event.any.tgid);
+
             classify_event(ctx, &event);
         }
     }
@@ -1283,6 +1286,8 @@ process_set_priority(cgrp_context_t *ctx,
         break;
     }
 
+    TRC_RECORD(&cgrp_trace, TRACE_PRIORITY, process->pid, priority, preserve);
+
     OHM_DEBUG(DBG_ACTION, "%u/%u (%s), %sing priority (req: %d)",
               process->tgid, process->pid, process->name,
               preserve ? "preserv" : "overrid", priority);
@@ -1493,6 +1498,8 @@ process_adjust_oom(cgrp_context_t *ctx,
     else if (mapped > 15)
         mapped = 15;
 
+    TRC_RECORD(&cgrp_trace, TRACE_OOM, process->pid, oom_adj, mapped);
+
     OHM_DEBUG(DBG_ACTION, "%u/%u (%s), adjusting OOM score %d/%d:%d",
               process->tgid, process->pid, process->name,
               oom_adj, process->oom_adj, mapped);
@@ -24,12 +24,18 @@ USA.
 #include <string.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <time.h>
 
+#include <glib.h>
+#include <glib-object.h>
 #include <ohm/ohm-fact.h>
+#include <ohm/ohm-plugin-log.h>
+#include <ohm/ohm-plugin-debug.h>
 
-#include "plugin.h"
 #include "fsif.h"
 
+#define INDEX_KEY_LEN  64
+
 
 typedef enum {
     watch_unknown = 0,
@@ -42,14 +48,22 @@ typedef enum {
 #error "unmatching enumerations fact_watch_insert and watch_type_e"
 #endif
 
+/*
+ * update watches are also linked per watched field (fields) or in the
+ * list of watches for any field (anyfld), newest first just like entries
+ */
 typedef struct watch_fact_s {
     struct watch_fact_s   *next;
     char                  *factname;
+    GQuark                 quark;
     struct watch_entry_s  *entries;
+    GHashTable            *fields;
+    struct watch_entry_s  *anyfld;
 } watch_fact_t;
 
 typedef struct watch_entry_s {
     struct watch_entry_s  *next;
+    struct watch_entry_s  *fnext;
     int                    id;
     fsif_field_t          *selist;
     char                  *fldname;
@@ -60,17 +74,47 @@ typedef struct watch_entry_s {
     void                  *usrdata;
 } watch_entry_t;
 
+/*
+ * secondary index of the facts of a name by the value of one field;
+ * values map to a list of facts, facts map back to their current value
+ */
+typedef struct index_s {
+    struct index_s        *next;
+    char                  *factname;
+    char                  *fldname;
+    GQuark                 factquark;
+    GQuark                 fldquark;
+    GHashTable            *entries;
+    GHashTable            *keys;
+    GHashTable            *unkeyed;  /* facts with no usable key value */
+} index_t;
+
 static OhmFactStore  *fs;
 static int            watch_id = 1;
 static watch_fact_t  *wfact_inserts;
 static watch_fact_t  *wfact_removes;
 static watch_fact_t  *wfact_updates;
+static GHashTable    *wfact_index[3];
+static fsif_stats_t   stats;
+static index_t       *indices;
+static int            dbg_none;
+static int           *dbg_fs = &dbg_none;
+
+#define DBG_FS (*dbg_fs)
 
 static OhmFact      *find_entry(char *, fsif_field_t *);
+static index_t      *find_index(char *, fsif_field_t *, fsif_field_t **);
+static char         *index_key(GValue *, char *, int);
+static char         *selector_key(fsif_field_t *, char *, int);
+static void          index_add(index_t *, OhmFact *, GValue *);
+static void          index_del(index_t *, OhmFact *);
+static void          index_free(index_t *);
 static int           matching_entry(OhmFact *, fsif_field_t *);
 static int           get_field(OhmFact *, fsif_fldtype_t, char *, void *);
 static void          set_field(OhmFact *, fsif_fldtype_t, char *, void *);
 static watch_fact_t *find_watch(char *, watch_type_e);
+static watch_fact_t *find_watch_by_quark(GQuark, watch_type_e);
+static watch_fact_t *create_watch(char *, watch_type_e);
 static fsif_field_t *copy_selector(fsif_field_t *);
 #if 0
 static void          free_selector(fsif_field_t *);
@@ -96,11 +140,14 @@ static guint         removed_id;
  *  @{
  */
 
-void fsif_init(OhmPlugin *plugin)
+void fsif_init(OhmPlugin *plugin, int *debug)
 {
     (void)plugin;
 
-    ENTER;
+    if (debug != NULL)
+        dbg_fs = debug;
+
+    memset(&stats, 0, sizeof(stats));
 
     fs = ohm_fact_store_get_fact_store();
 
@@ -112,12 +159,12 @@ void fsif_init(OhmPlugin *plugin)
 
     removed_id  = g_signal_connect(G_OBJECT(fs), "removed" ,
                                    G_CALLBACK(removed_cb) , NULL);
-
-    LEAVE;
 }
 
 void fsif_exit(OhmPlugin *plugin)
 {
+    index_t *ix;
+
     (void)plugin;
 
     fs = ohm_fact_store_get_fact_store();
@@ -134,6 +181,67 @@ void fsif_exit(OhmPlugin *plugin)
         g_signal_handler_disconnect(G_OBJECT(fs), removed_id);
         removed_id = 0;
     }
+
+    while ((ix = indices) != NULL) {
+        indices = ix->next;
+        index_free(ix);
+    }
+
+    OHM_DEBUG(DBG_FS, "field updates: %lu seen, %lu rejected, %lu filtered, "
+              "%lu delivered", stats.updates, stats.rejected, stats.filtered,
+              stats.delivered);
+}
+
+void fsif_get_statistics(fsif_stats_t *st)
+{
+    if (st != NULL)
+        *st = stats;
+}
+
+int fsif_add_index(char *factname, char *fldname)
+{
+    index_t *ix;
+    GSList  *list;
+    OhmFact *fact;
+
+    if (!factname || !fldname)
+        return FALSE;
+
+    for (ix = indices;  ix != NULL;  ix = ix->next) {
+        if (!strcmp(factname, ix->factname) && !strcmp(fldname, ix->fldname))
+            return TRUE;
+    }
+
+    if (fs == NULL)
+        fs = ohm_fact_store_get_fact_store();
+
+    if ((ix = malloc(sizeof(*ix))) == NULL)
+        return FALSE;
+
+    memset(ix, 0, sizeof(*ix));
+    ix->factname = strdup(factname);
+    ix->fldname  = strdup(fldname);
+    ix->factquark = g_quark_from_string(factname);
+    ix->fldquark  = g_quark_from_string(fldname);
+    ix->entries  = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    ix->keys     = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                         NULL, g_free);
+    ix->unkeyed  = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    for (list  = ohm_fact_store_get_facts_by_name(fs, factname);
+         list != NULL;
+         list  = g_slist_next(list))
+    {
+        fact = (OhmFact *)list->data;
+        index_add(ix, fact, ohm_fact_get(fact, fldname));
+    }
+
+    ix->next = indices;
+    indices  = ix;
+
+    OHM_DEBUG(DBG_FS, "index added for '%s:%s'", factname, fldname);
+
+    return TRUE;
 }
 
 int fsif_add_factstore_entry(char *name, fsif_field_t *fldlist)
@@ -142,12 +250,12 @@ int fsif_add_factstore_entry(char *name, fsif_field_t *fldlist)
     fsif_field_t *fld;
 
     if (!name || !fldlist) {
-        OHM_ERROR("resource: [%s] invalid arument", __FUNCTION__);
+        OHM_ERROR("[%s] invalid arument", __FUNCTION__);
         return FALSE;
     }
 
     if ((fact = ohm_fact_new(name)) == NULL) {
-        OHM_ERROR("resource: [%s] Can't create new fact", __FUNCTION__);
+        OHM_ERROR("[%s] Can't create new fact", __FUNCTION__);
         return FALSE;
     }
 
@@ -158,7 +266,7 @@ int fsif_add_factstore_entry(char *name, fsif_field_t *fldlist)
     if (ohm_fact_store_insert(fs, fact))
         OHM_DEBUG(DBG_FS, "factstore entry %s created", name);
     else {
-        OHM_ERROR("resource: [%s] Can't add %s to factsore",
+        OHM_ERROR("[%s] Can't add %s to factsore",
                   __FUNCTION__, name);
         return FALSE;
     }
@@ -176,7 +284,7 @@ int fsif_delete_factstore_entry(char *name, fsif_field_t *selist)
     selstr = print_selector(selist, selb, sizeof(selb));
 
     if ((fact = find_entry(name, selist)) == NULL) {
-        OHM_ERROR("resource: [%s] Failed to delete '%s%s' entry: "
+        OHM_ERROR("[%s] Failed to delete '%s%s' entry: "
                   "no entry found", __FUNCTION__, name, selstr);
         success = FALSE;
     }
@@ -193,6 +301,30 @@ int fsif_delete_factstore_entry(char *name, fsif_field_t *selist)
     return success;
 }
 
+int fsif_destroy_factstore_entry(fsif_entry_t *fact)
+{
+    char  *dump;
+    int    success;
+
+    if (fact == NULL)
+        success = FALSE;
+    else {
+        dump = ohm_structure_to_string(OHM_STRUCTURE(fact));
+
+        ohm_fact_store_remove(fs, fact);
+
+        g_object_unref(fact);
+
+        OHM_DEBUG(DBG_FS, "factstore entry deleted: %s", dump);
+
+        g_free(dump);
+        
+        success = TRUE;
+    }
+ 
+    return success;
+}
+
 int fsif_update_factstore_entry(char         *name,
                                 fsif_field_t *selist,
                                 fsif_field_t *fldlist)
@@ -207,7 +339,7 @@ int fsif_update_factstore_entry(char         *name,
     selstr = print_selector(selist, selb, sizeof(selb));
 
     if ((fact = find_entry(name, selist)) == NULL) {
-        OHM_ERROR("resource: [%s] Failed to update '%s%s' entry: "
+        OHM_ERROR("[%s] Failed to update '%s%s' entry: "
                   "no entry found", __FUNCTION__, name, selstr);
         return FALSE;
     }
@@ -226,6 +358,23 @@ int fsif_update_factstore_entry(char         *name,
 }
 
 
+fsif_entry_t *fsif_get_entry(char *name, fsif_field_t *selist)
+{
+    OhmFact  *fact;
+    char     *selstr;
+    char      selb[256];
+    char     *result;
+
+    selstr = print_selector(selist, selb, sizeof(selb));
+    fact   = find_entry(name, selist);
+    result = (fact != NULL) ? "" : "not ";
+
+    OHM_DEBUG(DBG_FS, "factstore lookup %s%s %ssucceeded", name,selstr, result);
+
+    return fact;
+}
+
+
 void fsif_get_field_by_entry(fsif_entry_t   *entry,
                              fsif_fldtype_t  type,
                              char           *name,
@@ -237,6 +386,17 @@ void fsif_get_field_by_entry(fsif_entry_t   *entry,
 }
 
 
+void fsif_set_field_by_entry(fsif_entry_t   *entry,
+                             fsif_fldtype_t  type,
+                             char           *name,
+                             void           *vptr)
+{
+    if (entry != NULL && name != NULL && vptr != NULL) {
+        set_field(entry, type, name, vptr);
+    }
+}
+
+
 int fsif_get_field_by_name(const char     *name,
                            fsif_fldtype_t  type,
                            char           *field,
@@ -265,30 +425,17 @@ int fsif_add_fact_watch(char                 *factname,
                         void                 *usrdata)
 {
     watch_fact_t   *wfact;
-    watch_fact_t  **wfact_head;
     watch_entry_t  *wentry;
 
     if (!factname || !callback)
         return -1;
     
-    switch(type) {
-    case fact_watch_insert:    wfact_head = &wfact_inserts;    break;
-    case fact_watch_remove:    wfact_head = &wfact_removes;    break;
-    default:                   return -1;
-    }
-
-
-    if ((wfact = find_watch(factname, type)) == NULL) {
-        if ((wfact = malloc(sizeof(*wfact))) == NULL)
-            return -1;
-        else {
-            memset(wfact, 0, sizeof(*wfact));
-            wfact->next     = *wfact_head;
-            wfact->factname = strdup(factname);
+    if (type != fact_watch_insert && type != fact_watch_remove)
+        return -1;
 
-            *wfact_head = wfact;
-        }
-    }
+    if ((wfact = find_watch(factname, (watch_type_e)type)) == NULL &&
+        (wfact = create_watch(factname, (watch_type_e)type)) == NULL)
+        return -1;
 
     if ((wentry = malloc(sizeof(*wentry))) == NULL)
         return -1;
@@ -316,21 +463,14 @@ int fsif_add_field_watch(char                  *factname,
 {
     watch_fact_t  *wfact;
     watch_entry_t *wentry;
+    gpointer       key;
 
     if (!factname || !callback)
         return -1;
 
-    if ((wfact = find_watch(factname, watch_update)) == NULL) {
-        if ((wfact = malloc(sizeof(*wfact))) == NULL)
-            return -1;
-        else {
-            memset(wfact, 0, sizeof(*wfact));
-            wfact->next     = wfact_updates;
-            wfact->factname = strdup(factname);
-
-            wfact_updates = wfact;
-        }
-    }
+    if ((wfact = find_watch(factname, watch_update)) == NULL &&
+        (wfact = create_watch(factname, watch_update)) == NULL)
+        return -1;
 
     if ((wentry = malloc(sizeof(*wentry))) == NULL)
         return -1;
@@ -344,6 +484,17 @@ int fsif_add_field_watch(char                  *factname,
         wentry->usrdata              = usrdata;
         
         wfact->entries = wentry;
+
+        if (fldname == NULL) {
+            wentry->fnext  = wfact->anyfld;
+            wfact->anyfld  = wentry;
+        }
+        else {
+            key = GUINT_TO_POINTER(g_quark_from_string(fldname));
+
+            wentry->fnext = g_hash_table_lookup(wfact->fields, key);
+            g_hash_table_insert(wfact->fields, key, wentry);
+        }
     }
 
     OHM_DEBUG(DBG_FS, "field watch point %d added for '%s%s%s'", wentry->id,
@@ -361,6 +512,37 @@ static OhmFact *find_entry(char *name, fsif_field_t *selist)
 {
     OhmFact            *fact;
     GSList             *list;
+    index_t            *ix;
+    fsif_field_t       *se;
+    char                keyb[INDEX_KEY_LEN];
+    char               *key;
+    GHashTableIter      it;
+    gpointer            unkeyed;
+
+    if ((ix = find_index(name, selist, &se)) != NULL) {
+        key = selector_key(se, keyb, sizeof(keyb));
+
+        for (list  = g_hash_table_lookup(ix->entries, key);
+             list != NULL;
+             list  = g_slist_next(list))
+        {
+            fact = (OhmFact *)list->data;
+
+            if (matching_entry(fact, selist))
+                return fact;
+        }
+
+        /* the facts that could not be keyed are not in the index */
+        g_hash_table_iter_init(&it, ix->unkeyed);
+        while (g_hash_table_iter_next(&it, &unkeyed, NULL)) {
+            fact = (OhmFact *)unkeyed;
+
+            if (matching_entry(fact, selist))
+                return fact;
+        }
+
+        return NULL;
+    }
 
     for (list  = ohm_fact_store_get_facts_by_name(fs, name);
          list != NULL;
@@ -376,6 +558,143 @@ static OhmFact *find_entry(char *name, fsif_field_t *selist)
     return NULL;
 }
 
+static index_t *find_index(char          *name,
+                           fsif_field_t  *selist,
+                           fsif_field_t **field)
+{
+    index_t      *ix;
+    fsif_field_t *se;
+    char          keyb[INDEX_KEY_LEN];
+
+    if (selist == NULL)
+        return NULL;
+
+    for (ix = indices;  ix != NULL;  ix = ix->next) {
+        if (strcmp(name, ix->factname))
+            continue;
+
+        for (se = selist;   se->type != fldtype_invalid;   se++) {
+            if (!strcmp(se->name, ix->fldname) &&
+                selector_key(se, keyb, sizeof(keyb)) != NULL)
+            {
+                *field = se;
+                return ix;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static char *index_key(GValue *gv, char *buf, int len)
+{
+    if (gv == NULL)
+        return NULL;
+
+    switch (G_VALUE_TYPE(gv)) {
+    case G_TYPE_STRING: return (char *)g_value_get_string(gv);
+    case G_TYPE_LONG:   snprintf(buf, len, "%ld", g_value_get_long(gv));  break;
+    case G_TYPE_INT:    snprintf(buf, len, "%ld", (long)g_value_get_int(gv));
+                        break;
+    case G_TYPE_ULONG:  snprintf(buf, len, "%lu", g_value_get_ulong(gv)); break;
+    case G_TYPE_UINT64: snprintf(buf, len, "%llu",
+                                 (unsigned long long)g_value_get_uint64(gv));
+                        break;
+    default:            return NULL;
+    }
+
+    return buf;
+}
+
+static char *selector_key(fsif_field_t *se, char *buf, int len)
+{
+    fsif_value_t *v = &se->value;
+
+    switch (se->type) {
+    case fldtype_string:  return v->string;
+    case fldtype_integer: snprintf(buf, len, "%ld" , v->integer);     break;
+    case fldtype_unsignd: snprintf(buf, len, "%lu" , v->unsignd);     break;
+    case fldtype_time:    snprintf(buf, len, "%llu", v->time);        break;
+    default:              return NULL;
+    }
+
+    return buf;
+}
+
+static void index_add(index_t *ix, OhmFact *fact, GValue *gv)
+{
+    GSList *list;
+    char    keyb[INDEX_KEY_LEN];
+    char   *key;
+
+    index_del(ix, fact);
+
+    if ((key = index_key(gv, keyb, sizeof(keyb))) == NULL) {
+        /* not indexable, lookups have to check it one by one */
+        g_hash_table_insert(ix->unkeyed, g_object_ref(fact), NULL);
+        return;
+    }
+
+    list = g_hash_table_lookup(ix->entries, key);
+    list = g_slist_prepend(list, g_object_ref(fact));
+
+    g_hash_table_replace(ix->entries, g_strdup(key), list);
+    g_hash_table_insert(ix->keys, fact, g_strdup(key));
+}
+
+static void index_del(index_t *ix, OhmFact *fact)
+{
+    GSList *list;
+    char   *key;
+
+    if (g_hash_table_remove(ix->unkeyed, fact)) {
+        g_object_unref(fact);
+        return;
+    }
+
+    if ((key = g_hash_table_lookup(ix->keys, fact)) == NULL)
+        return;
+
+    list = g_hash_table_lookup(ix->entries, key);
+    list = g_slist_remove(list, fact);
+
+    if (list != NULL)
+        g_hash_table_replace(ix->entries, g_strdup(key), list);
+    else
+        g_hash_table_remove(ix->entries, key);
+
+    g_hash_table_remove(ix->keys, fact);
+
+    g_object_unref(fact);
+}
+
+static void index_free(index_t *ix)
+{
+    GHashTableIter  it;
+    gpointer        fact;
+    gpointer        list;
+
+    g_hash_table_iter_init(&it, ix->keys);
+    while (g_hash_table_iter_next(&it, &fact, NULL))
+        g_object_unref(fact);
+
+    g_hash_table_iter_init(&it, ix->unkeyed);
+    while (g_hash_table_iter_next(&it, &fact, NULL))
+        g_object_unref(fact);
+
+    g_hash_table_iter_init(&it, ix->entries);
+    while (g_hash_table_iter_next(&it, NULL, &list))
+        g_slist_free((GSList *)list);
+
+    g_hash_table_destroy(ix->entries);
+    g_hash_table_destroy(ix->keys);
+    g_hash_table_destroy(ix->unkeyed);
+
+    free(ix->factname);
+    free(ix->fldname);
+    free(ix);
+}
+
 static int matching_entry(OhmFact *fact, fsif_field_t *selist)
 {
     fsif_field_t       *se;
@@ -434,7 +753,7 @@ static int get_field(OhmFact *fact, fsif_fldtype_t type,char *name,void *vptr)
     GValue  *gv;
 
     if (!fact || !name || !(gv = ohm_fact_get(fact, name))) {
-        OHM_ERROR("resource: [%s] Cant find field %s",
+        OHM_ERROR("[%s] Cant find field %s",
                   __FUNCTION__, name?name:"<null>");
         goto return_empty_value;
     }
@@ -484,7 +803,8 @@ static int get_field(OhmFact *fact, fsif_fldtype_t type,char *name,void *vptr)
     return TRUE;
 
  type_mismatch:
-    OHM_ERROR("resource: [%s] Type mismatch when fetching field '%s'",
+    /* expected: the delay plugin probes timer arguments as string first */
+    OHM_DEBUG(DBG_FS, "[%s] Type mismatch when fetching field '%s'",
               __FUNCTION__,name);
 
  return_empty_value:
@@ -511,7 +831,7 @@ static void set_field(OhmFact *fact, fsif_fldtype_t type,char *name,void *vptr)
     case fldtype_unsignd:   gv = ohm_value_from_unsigned(v->unsignd);   break;
     case fldtype_floating:  gv = ohm_value_from_double(v->floating);    break;
     case fldtype_time:      gv = ohm_value_from_time(v->time);          break;
-    default:          OHM_ERROR("resource: invalid type for %s", name); return;
+    default:          OHM_ERROR("invalid type for %s", name); return;
     }
 
     ohm_fact_set(fact, name, gv);
@@ -519,27 +839,58 @@ static void set_field(OhmFact *fact, fsif_fldtype_t type,char *name,void *vptr)
 
 static watch_fact_t *find_watch(char *name, watch_type_e type)
 {
-    watch_fact_t *wfact;
+    GQuark quark;
 
-    if (name != NULL) {
+    /* a name that was never interned can't have a watch */
+    if (name == NULL || !(quark = g_quark_try_string(name)))
+        return NULL;
 
-        switch (type) {
-        case watch_insert:   wfact = wfact_inserts;   break;
-        case watch_remove:   wfact = wfact_removes;   break;
-        case watch_update:   wfact = wfact_updates;   break;
-        default:             return NULL;
-        }
+    return find_watch_by_quark(quark, type);
+}
 
-        while (wfact != NULL) {
+static watch_fact_t *find_watch_by_quark(GQuark quark, watch_type_e type)
+{
+    if (type <= watch_unknown || type > watch_update ||
+        wfact_index[type - 1] == NULL)
+        return NULL;
 
-            if (!strcmp(name, wfact->factname))
-                return wfact;
+    return g_hash_table_lookup(wfact_index[type - 1], GUINT_TO_POINTER(quark));
+}
 
-            wfact = wfact->next;
-        }
+static watch_fact_t *create_watch(char *name, watch_type_e type)
+{
+    watch_fact_t **wfact_head;
+    watch_fact_t  *wfact;
+    GHashTable   **index;
+
+    switch (type) {
+    case watch_insert:   wfact_head = &wfact_inserts;   break;
+    case watch_remove:   wfact_head = &wfact_removes;   break;
+    case watch_update:   wfact_head = &wfact_updates;   break;
+    default:             return NULL;
     }
 
-    return NULL;
+    index = &wfact_index[type - 1];
+
+    if (*index == NULL)
+        *index = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    if ((wfact = malloc(sizeof(*wfact))) == NULL)
+        return NULL;
+
+    memset(wfact, 0, sizeof(*wfact));
+    wfact->next     = *wfact_head;
+    wfact->factname = strdup(name);
+    wfact->quark    = g_quark_from_string(name);
+
+    if (type == watch_update)
+        wfact->fields = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    *wfact_head = wfact;
+
+    g_hash_table_insert(*index, GUINT_TO_POINTER(wfact->quark), wfact);
+
+    return wfact;
 }
 
 
@@ -591,7 +942,7 @@ static fsif_field_t *copy_selector(fsif_field_t *selist)
                     break;
                     
                 default:
-                    OHM_ERROR("resource: [%s] unsupported type", __FUNCTION__);
+                    OHM_ERROR("[%s] unsupported type", __FUNCTION__);
                     memset(&cp->value, 0, sizeof(cp->value));
                     break;
                 } /* switch */
@@ -725,15 +1076,24 @@ static void inserted_cb(void *data, OhmFact *fact)
     char          *name;
     watch_fact_t  *wfact;
     watch_entry_t *wentry;
+    index_t       *ix;
+    GQuark         quark;
     
     if (fact == NULL) {
-        OHM_ERROR("resource: %s() called with null fact pointer",__FUNCTION__);
+        OHM_ERROR("%s() called with null fact pointer",__FUNCTION__);
         return;
     }
         
     name = (char *)ohm_structure_get_name(OHM_STRUCTURE(fact));
 
-    if ((wfact = find_watch(name, watch_insert)) != NULL) {
+    quark = g_quark_try_string(name);
+
+    for (ix = indices;  ix != NULL;  ix = ix->next) {
+        if (ix->factquark == quark)
+            index_add(ix, fact, ohm_fact_get(fact, ix->fldname));
+    }
+
+    if (quark && (wfact = find_watch_by_quark(quark, watch_insert)) != NULL) {
 
         OHM_DEBUG(DBG_FS, "fact watch point: fact '%s' inserted", name);
 
@@ -752,15 +1112,24 @@ static void removed_cb(void *data, OhmFact *fact)
     char          *name;
     watch_fact_t  *wfact;
     watch_entry_t *wentry;
+    index_t       *ix;
+    GQuark         quark;
     
     if (fact == NULL) {
-        OHM_ERROR("resource: %s() called with null fact pointer",__FUNCTION__);
+        OHM_ERROR("%s() called with null fact pointer",__FUNCTION__);
         return;
     }
         
     name = (char *)ohm_structure_get_name(OHM_STRUCTURE(fact));
 
-    if ((wfact = find_watch(name, watch_remove)) != NULL) {
+    quark = g_quark_try_string(name);
+
+    for (ix = indices;  ix != NULL;  ix = ix->next) {
+        if (ix->factquark == quark)
+            index_del(ix, fact);
+    }
+
+    if (quark && (wfact = find_watch_by_quark(quark, watch_remove)) != NULL) {
 
         OHM_DEBUG(DBG_FS, "fact watch point: fact '%s' removed", name);
 
@@ -778,78 +1147,115 @@ static void updated_cb(void *data,OhmFact *fact,GQuark fldquark,gpointer value)
 
     GValue        *gval = (GValue *)value;
     char          *name;
+    GQuark         quark;
     watch_fact_t  *wfact;
     watch_entry_t *wentry;
+    watch_entry_t *fwatch;
+    watch_entry_t *awatch;
+    index_t       *ix;
     fsif_field_t   fld;
     char           valb[256];
     char          *valstr;
     
     if (fact == NULL) {
-        OHM_ERROR("resource: %s() called with null fact pointer",__FUNCTION__);
+        OHM_ERROR("%s() called with null fact pointer",__FUNCTION__);
         return;
     }
         
-    name = (char *)ohm_structure_get_name(OHM_STRUCTURE(fact));
+    stats.updates++;
 
-    if (value != NULL && (wfact = find_watch(name, watch_update)) != NULL) {
+    name  = (char *)ohm_structure_get_name(OHM_STRUCTURE(fact));
+    quark = g_quark_try_string(name);
 
-        for (wentry = wfact->entries;  wentry != NULL;  wentry = wentry->next){
+    for (ix = indices;  ix != NULL;  ix = ix->next) {
+        if (ix->fldquark == fldquark && ix->factquark == quark)
+            index_add(ix, fact, gval);
+    }
 
-            fld.name = (char *)g_quark_to_string(fldquark);
+    if (value == NULL || !quark ||
+        (wfact = find_watch_by_quark(quark, watch_update)) == NULL)
+    {
+        stats.rejected++;
+        return;
+    }
 
-            if (matching_entry(fact, wentry->selist) &&
-                (!wentry->fldname || !strcmp(fld.name, wentry->fldname))) {
-                
-                switch (G_VALUE_TYPE(gval)) {
+    fwatch = g_hash_table_lookup(wfact->fields, GUINT_TO_POINTER(fldquark));
+    awatch = wfact->anyfld;
+
+    if (fwatch == NULL && awatch == NULL) {
+        stats.rejected++;
+        return;
+    }
+
+    /*
+     * merge the watches of this field with the ones for any field, newest
+     * first, and deliver to the first one with a matching selector
+     */
+    while (fwatch != NULL || awatch != NULL) {
+        if (awatch == NULL || (fwatch != NULL && fwatch->id > awatch->id)) {
+            wentry = fwatch;
+            fwatch = fwatch->fnext;
+        }
+        else {
+            wentry = awatch;
+            awatch = awatch->fnext;
+        }
+
+        if (!matching_entry(fact, wentry->selist))
+            continue;
+
+        fld.name = (char *)g_quark_to_string(fldquark);
+
+        switch (G_VALUE_TYPE(gval)) {
                     
-                case G_TYPE_STRING:
-                    fld.type = fldtype_string;
-                    fld.value.string = (char *)g_value_get_string(gval);
-                    break;
+        case G_TYPE_STRING:
+            fld.type = fldtype_string;
+            fld.value.string = (char *)g_value_get_string(gval);
+            break;
                     
-                case G_TYPE_LONG:
-                    fld.type = fldtype_integer;
-                    fld.value.integer = g_value_get_long(gval);
-                    break;
+        case G_TYPE_LONG:
+            fld.type = fldtype_integer;
+            fld.value.integer = g_value_get_long(gval);
+            break;
 
-                case G_TYPE_INT:
-                    fld.type = fldtype_integer;
-                    fld.value.integer = g_value_get_int(gval);
-                    break;
+        case G_TYPE_INT:
+            fld.type = fldtype_integer;
+            fld.value.integer = g_value_get_int(gval);
+            break;
                     
-                case G_TYPE_ULONG:
-                    fld.type = fldtype_unsignd;
-                    fld.value.unsignd = g_value_get_ulong(gval);
-                    break;
+        case G_TYPE_ULONG:
+            fld.type = fldtype_unsignd;
+            fld.value.unsignd = g_value_get_ulong(gval);
+            break;
                     
-                case G_TYPE_DOUBLE:
-                    fld.type = fldtype_floating;
-                    fld.value.floating = g_value_get_double(gval);
-                    break;
+        case G_TYPE_DOUBLE:
+            fld.type = fldtype_floating;
+            fld.value.floating = g_value_get_double(gval);
+            break;
                     
-                case G_TYPE_UINT64:
-                    fld.type = fldtype_time;
-                    fld.value.time = g_value_get_uint64(gval);
-                    break;
+        case G_TYPE_UINT64:
+            fld.type = fldtype_time;
+            fld.value.time = g_value_get_uint64(gval);
+            break;
                     
-                default:
-                    OHM_ERROR("resource: [%s] Unsupported data type (%d) "
-                              "for field '%s'",
-                              __FUNCTION__, G_VALUE_TYPE(gval), fld.name);
-                    return;
-                }
+        default:
+            OHM_ERROR("[%s] Unsupported data type (%d) for field '%s'",
+                      __FUNCTION__, G_VALUE_TYPE(gval), fld.name);
+            return;
+        }
                 
-                valstr = print_value(fld.type, (void *)&fld.value,
-                                     valb, sizeof(valb)); 
-                OHM_DEBUG(DBG_FS, "field watch point: field '%s:%s' "
-                          "changed to '%s'", name, fld.name, valstr);
+        valstr = print_value(fld.type, (void *)&fld.value, valb, sizeof(valb));
+        OHM_DEBUG(DBG_FS, "field watch point: field '%s:%s' changed to '%s'",
+                  name, fld.name, valstr);
 
-                wentry->callback.field_watch(fact, name, &fld,wentry->usrdata);
+        stats.delivered++;
+
+        wentry->callback.field_watch(fact, name, &fld, wentry->usrdata);
                 
-                return;
-            } /* if matching_entry */
-        } /* for */
-    } /* if find_watch */
+        return;
+    }
+
+    stats.filtered++;
 }
 
 static char *time_str(unsigned long long t, char *buf , int len)
@@ -18,20 +18,15 @@ USA.
 *************************************************************************/
 
 
-#ifndef __OHM_RESOURCE_FSIF_H__
-#define __OHM_RESOURCE_FSIF_H__
+#ifndef __OHM_FSIF_H__
+#define __OHM_FSIF_H__
 
 /*
- * FIXME:
- * The 'delay' and the 'timer' plugin share the similar fsif.[hc]
- * However, do to the rush, they are currently duplicated (ie. the same
- * code is duplicated in both directory.
- * Before we fix this pls. pay attention to kepp them identical (ie. make
- * identical changes to both copy)
- *
+ * Factstore access layer shared by the resource, media, playback and
+ * delay plugins. It is built as a convenience library and linked into
+ * each of them, so every plugin has its own watches and indices.
  */
 
-
 #include <sys/time.h>
 
 typedef enum {
@@ -67,6 +62,13 @@ typedef struct {
     fsif_value_t    value;
 } fsif_field_t;
 
+typedef struct {
+    unsigned long   updates;    /* field updates seen */
+    unsigned long   rejected;   /* no watch for the fact or the field */
+    unsigned long   filtered;   /* watched field, but no selector matched */
+    unsigned long   delivered;  /* field watch callbacks invoked */
+} fsif_stats_t;
+
 /* hack to avoid multiple includes */
 typedef struct _OhmPlugin OhmPlugin;
 typedef struct _OhmFact   fsif_entry_t;
@@ -76,19 +78,24 @@ typedef void (*fsif_field_watch_cb_t)(fsif_entry_t *, char *, fsif_field_t *,
 typedef void (*fsif_fact_watch_cb_t)(fsif_entry_t *, char *, fsif_fact_watch_e,
                                      void *);
 
-void fsif_init(OhmPlugin *);
+void fsif_init(OhmPlugin *, int *);
 void fsif_exit(OhmPlugin *);
+int  fsif_add_index(char *, char *);
 int  fsif_add_factstore_entry(char *, fsif_field_t *);
 int  fsif_delete_factstore_entry(char *, fsif_field_t *);
+int  fsif_destroy_factstore_entry(fsif_entry_t *);
 int  fsif_update_factstore_entry(char *, fsif_field_t *,fsif_field_t *);
+fsif_entry_t *fsif_get_entry(char *, fsif_field_t *);
 void fsif_get_field_by_entry(fsif_entry_t *, fsif_fldtype_t, char *, void *);
+void fsif_set_field_by_entry(fsif_entry_t *, fsif_fldtype_t, char *, void *);
 int  fsif_get_field_by_name(const char *, fsif_fldtype_t, char *, void *);
 int  fsif_add_fact_watch(char *,fsif_fact_watch_e,fsif_fact_watch_cb_t,void *);
 int  fsif_add_field_watch(char *, fsif_field_t *, char *,
                           fsif_field_watch_cb_t, void *);
+void fsif_get_statistics(fsif_stats_t *);
 
 
-#endif /* __OHM_RESOURCE_FSIF_H__ */
+#endif /* __OHM_FSIF_H__ */
 
 /* 
  * Local Variables:
@@ -0,0 +1,236 @@
+/*************************************************************************
+Copyright (C) 2010 Nokia Corporation.
+
+These OHM Modules are free software; you can redistribute
+it and/or modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation
+version 2.1 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301
+USA.
+*************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <glib.h>
+#include <ohm/ohm-plugin.h>
+#include <ohm/ohm-plugin-log.h>
+
+#include "trcring.h"
+
+#define TRCRING_MAX  (1 << 20)
+
+OHM_IMPORTABLE(int, add_command, (char *name, void (*handler)(char *)));
+
+static trcring_t *rings;
+static char      *command;
+
+static void console_init(const char *);
+static void console_command(char *);
+
+
+/*
+ * The size of the ring comes from the 'trace-ring' parameter of the plugin.
+ * It is rounded up to a power of two; zero or no parameter disables it.
+ */
+int trcring_init(trcring_t   *ring,
+                 OhmPlugin   *plugin,
+                 const char  *name,
+                 const char **events,
+                 int          nevent)
+{
+    const char *size_str;
+    char       *e;
+    long        size;
+    uint32_t    dim;
+
+    if (ring == NULL || name == NULL)
+        return FALSE;
+
+    memset(ring, 0, sizeof(*ring));
+    ring->name   = name;
+    ring->events = events;
+    ring->nevent = nevent;
+
+    if ((size_str = ohm_plugin_get_param(plugin, "trace-ring")) == NULL)
+        return TRUE;
+
+    size = strtol(size_str, &e, 10);
+
+    if (*e != '\0' || size < 0 || size > TRCRING_MAX) {
+        OHM_ERROR("%s: invalid trace-ring size '%s'", name, size_str);
+        return FALSE;
+    }
+
+    if (size == 0)
+        return TRUE;
+
+    for (dim = 1;  dim < (uint32_t)size;  dim <<= 1)
+        ;
+
+    if ((ring->entries = calloc(dim, sizeof(trcring_entry_t))) == NULL) {
+        OHM_ERROR("%s: can't allocate trace ring of %u entries", name, dim);
+        return FALSE;
+    }
+
+    ring->size = dim;
+    ring->next = rings;
+    rings = ring;
+
+    console_init(name);
+
+    OHM_INFO("%s: tracing to a ring of %u entries", name, dim);
+
+    return TRUE;
+}
+
+void trcring_exit(trcring_t *ring)
+{
+    trcring_t **r;
+
+    if (ring == NULL)
+        return;
+
+    for (r = &rings;  *r != NULL;  r = &(*r)->next) {
+        if (*r == ring) {
+            *r = ring->next;
+            break;
+        }
+    }
+
+    free(ring->entries);
+
+    ring->entries = NULL;
+    ring->size    = 0;
+    ring->count   = 0;
+}
+
+void trcring_record(trcring_t *ring,
+                    uint32_t   event,
+                    uint32_t   a0,
+                    uint32_t   a1,
+                    uint32_t   a2)
+{
+    trcring_entry_t *entry;
+    struct timespec  ts;
+
+    entry = ring->entries + (ring->count++ & (ring->size - 1));
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    entry->stamp  = (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+    entry->event  = event;
+    entry->arg[0] = a0;
+    entry->arg[1] = a1;
+    entry->arg[2] = a2;
+}
+
+void trcring_dump(trcring_t *ring, FILE *fp)
+{
+    trcring_entry_t *entry;
+    uint32_t         first;
+    uint32_t         i;
+    uint64_t         start;
+    const char      *name;
+    char             buf[32];
+
+    if (ring == NULL || ring->entries == NULL) {
+        fprintf(fp, "trace ring is disabled\n");
+        return;
+    }
+
+    first = ring->count > ring->size ? ring->count - ring->size : 0;
+    start = ring->entries[first & (ring->size - 1)].stamp;
+
+    fprintf(fp, "%s: %u events recorded, showing the last %u\n",
+            ring->name, ring->count, ring->count - first);
+
+    for (i = first;  i != ring->count;  i++) {
+        entry = ring->entries + (i & (ring->size - 1));
+
+        if (entry->event < (uint32_t)ring->nevent && ring->events != NULL)
+            name = ring->events[entry->event];
+        else {
+            snprintf(buf, sizeof(buf), "event #%u", entry->event);
+            name = buf;
+        }
+
+        fprintf(fp, "%10llu %-20s %u %u %u\n",
+                (unsigned long long)(entry->stamp - start), name,
+                entry->arg[0], entry->arg[1], entry->arg[2]);
+    }
+}
+
+void trcring_clear(trcring_t *ring)
+{
+    if (ring != NULL && ring->entries != NULL) {
+        memset(ring->entries, 0, ring->size * sizeof(trcring_entry_t));
+        ring->count = 0;
+    }
+}
+
+
+static void console_init(const char *name)
+{
+    char *signature;
+
+    if (command != NULL)
+        return;
+
+    signature = (char *)add_command_SIGNATURE;
+
+    if (!ohm_module_find_method("dres.add_command", &signature,
+                                (void *)&add_command))
+        return;
+
+    command = g_strdup_printf("%s-trace", name);
+
+    if (add_command(command, console_command) < 0) {
+        OHM_INFO("%s: failed to register console command", name);
+        g_free(command);
+        command = NULL;
+    }
+}
+
+static void console_command(char *cmd)
+{
+    trcring_t *ring;
+
+    if (!strcmp(cmd, "help")) {
+        printf("%s help     show this help\n", command);
+        printf("%s dump     dump the trace ring\n", command);
+        printf("%s clear    clear the trace ring\n", command);
+    }
+    else if (!strcmp(cmd, "dump")) {
+        for (ring = rings;  ring != NULL;  ring = ring->next)
+            trcring_dump(ring, stdout);
+    }
+    else if (!strcmp(cmd, "clear")) {
+        for (ring = rings;  ring != NULL;  ring = ring->next)
+            trcring_clear(ring);
+    }
+    else {
+        printf("%s: unknown command '%s'\n", command, cmd);
+    }
+}
+
+
+/* 
+ * Local Variables:
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ * vim:set expandtab shiftwidth=4:
+ */
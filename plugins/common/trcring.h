@@ -0,0 +1,98 @@
+/*************************************************************************
+Copyright (C) 2010 Nokia Corporation.
+
+These OHM Modules are free software; you can redistribute
+it and/or modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation
+version 2.1 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301
+USA.
+*************************************************************************/
+
+
+#ifndef __OHM_TRCRING_H__
+#define __OHM_TRCRING_H__
+
+/*
+ * Debug helpers for hot paths. TRC_DEBUG checks the debug flag before any
+ * of its arguments are evaluated, so expensive formatting (resmsg_res_str
+ * and friends) is only done when somebody is listening. The trace ring
+ * records events as binary records without any formatting and is dumped
+ * on demand from the console. Defining OHM_TRACE_DISABLED compiles both
+ * of them away.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <ohm/ohm-plugin.h>
+#include <ohm/ohm-plugin-debug.h>
+
+#define TRCRING_ARGS  3
+
+typedef struct {
+    uint64_t        stamp;              /* usecs, monotonic clock */
+    uint32_t        event;              /* index to the event names */
+    uint32_t        arg[TRCRING_ARGS];  /* event specific arguments */
+} trcring_entry_t;
+
+typedef struct trcring_s {
+    struct trcring_s *next;
+    const char       *name;             /* for the dumps */
+    const char      **events;           /* event names */
+    int               nevent;
+    uint32_t          size;             /* power of two, 0 if disabled */
+    uint32_t          count;            /* number of events ever recorded */
+    trcring_entry_t  *entries;
+} trcring_t;
+
+
+#ifdef OHM_TRACE_DISABLED
+
+#define TRC_ENABLED(flag)                   0
+#define TRC_DEBUG(flag, fmt, args...)       do { } while (0)
+#define TRC_RECORD(ring, ev, a0, a1, a2)    do { } while (0)
+
+#else
+
+#define TRC_ENABLED(flag)  OHM_DEBUG_ENABLED(flag)
+
+#define TRC_DEBUG(flag, fmt, args...) do {                              \
+        if (TRC_ENABLED(flag))                                          \
+            OHM_DEBUG(flag, fmt, ## args);                              \
+    } while (0)
+
+#define TRC_RECORD(ring, ev, a0, a1, a2) do {                           \
+        if ((ring)->entries != NULL)                                    \
+            trcring_record((ring), (ev), (uint32_t)(a0),                \
+                           (uint32_t)(a1), (uint32_t)(a2));             \
+    } while (0)
+
+#endif
+
+
+int  trcring_init(trcring_t *, OhmPlugin *, const char *,
+                  const char **, int);
+void trcring_exit(trcring_t *);
+void trcring_record(trcring_t *, uint32_t, uint32_t, uint32_t, uint32_t);
+void trcring_dump(trcring_t *, FILE *);
+void trcring_clear(trcring_t *);
+
+
+#endif	/* __OHM_TRCRING_H__ */
+
+/* 
+ * Local Variables:
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ * vim:set expandtab shiftwidth=4:
+ */
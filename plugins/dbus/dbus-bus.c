@@ -92,6 +92,7 @@ bus_create(DBusBusType type)
     if (ALLOC_OBJ(bus) != NULL) {
         bus->type = type;
         list_init(&bus->notify);
+        list_init(&bus->watchq);
     }
     
     return bus;
@@ -25,11 +25,12 @@ USA.
 static OhmPlugin *dbus_plugin;                /* this plugin */
 
 /* debug flags */
-int DBG_SIGNAL, DBG_METHOD;
+int DBG_SIGNAL, DBG_METHOD, DBG_WATCH;
 
 OHM_DEBUG_PLUGIN(dbus,
     OHM_DEBUG_FLAG("signals", "DBUS signal routing", &DBG_SIGNAL),
-    OHM_DEBUG_FLAG("methods", "DBUS method routing", &DBG_METHOD));
+    OHM_DEBUG_FLAG("methods", "DBUS method routing", &DBG_METHOD),
+    OHM_DEBUG_FLAG("watches", "DBUS name watches"  , &DBG_WATCH));
 
 
 static void plugin_exit(OhmPlugin *plugin);
@@ -245,6 +246,16 @@ OHM_EXPORTABLE(int, del_watch, (DBusBusType type,
 }
 
 
+/********************
+ * name_owner
+ ********************/
+OHM_EXPORTABLE(const char *, name_owner, (DBusBusType type, const char *name))
+{
+    /* only known for watched names, NULL if unknown or not owned */
+    return watch_owner(type, name);
+}
+
+
 /*****************************************************************************
  *                            *** OHM plugin glue ***                        *
  *****************************************************************************/
@@ -255,13 +266,14 @@ OHM_PLUGIN_DESCRIPTION(PLUGIN_NAME,
                        OHM_LICENSE_LGPL, /* OHM_LICENSE_LGPL */
                        plugin_init, plugin_exit, NULL);
 
-OHM_PLUGIN_PROVIDES_METHODS(PLUGIN_PREFIX, 6,
+OHM_PLUGIN_PROVIDES_METHODS(PLUGIN_PREFIX, 7,
                             OHM_EXPORT(add_method, "add_method"),
                             OHM_EXPORT(del_method, "del_method"),
                             OHM_EXPORT(add_signal, "add_signal"),
                             OHM_EXPORT(del_signal, "del_signal"),
                             OHM_EXPORT(add_watch , "add_watch"),
-                            OHM_EXPORT(del_watch , "del_watch")
+                            OHM_EXPORT(del_watch , "del_watch"),
+                            OHM_EXPORT(name_owner, "name_owner")
 #if 0
                             OHM_EXPORT(register_name, "register_name"),
                             OHM_EXPORT(release_name , "release_name")
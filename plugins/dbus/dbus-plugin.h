@@ -41,6 +41,8 @@ typedef struct {
     DBusBusType     type;                  /* DBUS_BUS_{SYSTEM, SESSION} */
     DBusConnection *conn;                  /* connection if it is up */
     hash_table_t   *watches;               /* watched names */
+    list_hook_t     watchq;                /* watches to set up */
+    guint           watchq_src;            /* idle source for watchq */
     hash_table_t   *objects;               /* exported objects */
     hash_table_t   *signals;               /* signals we listen for */
     list_hook_t     notify;                /* bus event watchers */
@@ -104,6 +106,8 @@ int watch_del(DBusBusType type, const char *name,
               void (*handler)(const char *, const char *, const char *, void *),
               void *data);
 
+const char *watch_owner(DBusBusType type, const char *name);
+
 void watch_bus_up(bus_t *bus);
 
 
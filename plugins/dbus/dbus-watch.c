@@ -23,15 +23,46 @@ USA.
 #include "dbus-plugin.h"
 #include "list.h"
 
+extern int DBG_WATCH;                          /* debug flag for watches */
+
+/*
+ * Name owner tracking.
+ *
+ * Every watched name has a watchlist which caches the current owner of
+ * the name. New watchlists are queued and processed in batches from the
+ * mainloop: the match rules for all queued names are installed without
+ * blocking and the initial owners are queried asynchronously. Since the
+ * bus processes our requests in order, no owner change can fall between
+ * installing the match rule and the owner query.
+ *
+ * Once the owner of a name is known, every watch gets notified about it
+ * once with an empty previous owner (and an empty current owner if the
+ * name has no owner). After that watches get notified about every owner
+ * change of the name.
+ */
+
+enum {
+    OWNER_UNKNOWN = 0,                  /* not queried yet */
+    OWNER_QUERYING,                     /* owner query in progress */
+    OWNER_KNOWN,                        /* owner (or lack of it) known */
+};
 
 typedef struct {
-    char        *name;
-    list_hook_t  watches;
+    bus_t           *bus;               /* bus we are watching on */
+    char            *name;
+    char            *owner;             /* cached owner, NULL if none */
+    int              state;             /* OWNER_* */
+    int              matched;           /* whether match rule is installed */
+    int              busy;              /* being notified */
+    DBusPendingCall *query;             /* pending owner query */
+    list_hook_t      watches;
+    list_hook_t      queue;             /* to bus->watchq */
 } watchlist_t;
 
 typedef struct {
     void       (*handler)(const char *, const char *, const char *, void *);
     void        *data;
+    int          notified;              /* got the current owner */
     list_hook_t  hook;
 } watch_t;
 
@@ -44,6 +75,12 @@ static int watchlist_add_filter(bus_t *bus);
 static void watchlist_del_filter(bus_t *bus);
 static int watchlist_add_match(bus_t *bus, watchlist_t *watchlist);
 static int watchlist_del_match(bus_t *bus, watchlist_t *watchlist);
+static int watchlist_query(bus_t *bus, watchlist_t *watchlist);
+static void watchlist_notify(bus_t *bus, watchlist_t *watchlist,
+                             const char *previous, const char *current,
+                             int all);
+static void watchlist_schedule(bus_t *bus, watchlist_t *watchlist);
+static void watch_unschedule(bus_t *bus);
 
 static void session_bus_event(bus_t *bus, int event, void *data);
 
@@ -91,7 +128,7 @@ watch_init(void)
         return FALSE;
     }
 #endif
-    
+
     return TRUE;
 }
 
@@ -108,6 +145,7 @@ watch_exit(void)
     session = bus_by_type(DBUS_BUS_SESSION);
 
     if (system != NULL) {
+        watch_unschedule(system);
         watchlist_del_filter(system);
         if (system->watches) {
             hash_table_destroy(system->watches);
@@ -115,6 +153,7 @@ watch_exit(void)
         }
     }
     if (session != NULL) {
+        watch_unschedule(session);
         watchlist_del_filter(session);
         bus_watch_del(session, session_bus_event, NULL);
         if (session->watches) {
@@ -149,7 +188,7 @@ watch_add(DBusBusType type, const char *name,
 
     if ((bus = bus_by_type(type)) == NULL)
         return FALSE;
-    
+
     if (ALLOC_OBJ(watch) == NULL)
         return FALSE;
 
@@ -162,8 +201,13 @@ watch_add(DBusBusType type, const char *name,
         watch_purge(watch);
         return FALSE;
     }
-        
+
     list_append(&watchlist->watches, &watch->hook);
+
+    /* a known owner is passed on to the new watch in the next batch */
+    if (watchlist->state == OWNER_KNOWN)
+        watchlist_schedule(bus, watchlist);
+
     return TRUE;
 }
 
@@ -183,18 +227,24 @@ watch_del(DBusBusType type, const char *name,
 
     if ((bus = bus_by_type(type)) == NULL)
         return FALSE;
-    
+
     if ((watchlist = watchlist_lookup(bus, name)) != NULL) {
         list_foreach(&watchlist->watches, p, n) {
             watch = list_entry(p, watch_t, hook);
             if (watch->handler == handler && watch->data == data) {
-                
+
+                /* removed once the notification is over */
+                if (watchlist->busy) {
+                    watch->handler = NULL;
+                    return TRUE;
+                }
+
                 list_delete(&watch->hook);
                 watch_purge(watch);
-                
+
                 if (list_empty(&watchlist->watches))
                     watchlist_del(bus, watchlist);
-                
+
                 return TRUE;
             }
         }
@@ -204,6 +254,26 @@ watch_del(DBusBusType type, const char *name,
 }
 
 
+/********************
+ * watch_owner
+ ********************/
+const char *
+watch_owner(DBusBusType type, const char *name)
+{
+    bus_t       *bus;
+    watchlist_t *watchlist;
+
+    if ((bus = bus_by_type(type)) == NULL || bus->watches == NULL)
+        return NULL;
+
+    if ((watchlist = watchlist_lookup(bus, name)) == NULL ||
+        watchlist->state != OWNER_KNOWN)
+        return NULL;
+
+    return watchlist->owner;
+}
+
+
 /********************
  * watchlist_add
  ********************/
@@ -216,18 +286,19 @@ watchlist_add(bus_t *bus, const char *name)
         return NULL;
 
     list_init(&watchlist->watches);
+    list_init(&watchlist->queue);
+    watchlist->bus = bus;
     if ((watchlist->name = STRDUP(name)) == NULL)
         goto failed;
-    
+
     if (!hash_table_insert(bus->watches, watchlist->name, watchlist))
         goto failed;
-    
-    watchlist_add_match(bus, watchlist);
+
+    watchlist_schedule(bus, watchlist);
     return watchlist;
 
  failed:
     watchlist_purge(watchlist);
-    FREE(watchlist);
     return NULL;
 }
 
@@ -238,7 +309,9 @@ watchlist_add(bus_t *bus, const char *name)
 static int
 watchlist_del(bus_t *bus, watchlist_t *watchlist)
 {
-    watchlist_del_match(bus, watchlist);
+    if (watchlist->matched)
+        watchlist_del_match(bus, watchlist);
+
     return hash_table_remove(bus->watches, watchlist->name);
 }
 
@@ -270,8 +343,71 @@ watchlist_purge(void *ptr)
             watch_purge(watch);
         }
 
+        list_delete(&watchlist->queue);
+
+        if (watchlist->query != NULL) {
+            dbus_pending_call_cancel(watchlist->query);
+            dbus_pending_call_unref(watchlist->query);
+        }
+
+        FREE(watchlist->owner);
         FREE(watchlist->name);
+        FREE(watchlist);
+    }
+}
+
+
+/********************
+ * watchlist_set_owner
+ ********************/
+static void
+watchlist_set_owner(watchlist_t *watchlist, const char *owner)
+{
+    FREE(watchlist->owner);
+    watchlist->owner = (owner && *owner) ? STRDUP(owner) : NULL;
+    watchlist->state = OWNER_KNOWN;
+}
+
+
+/********************
+ * watchlist_notify
+ ********************/
+static void
+watchlist_notify(bus_t *bus, watchlist_t *watchlist,
+                 const char *previous, const char *current, int all)
+{
+    watch_t     *watch;
+    list_hook_t *p, *n;
+
+    watchlist->busy++;
+
+    list_foreach(&watchlist->watches, p, n) {
+        watch = list_entry(p, watch_t, hook);
+
+        if (watch->handler == NULL || (!all && watch->notified))
+            continue;
+
+        watch->notified = TRUE;
+        watch->handler(watchlist->name, previous, current, watch->data);
     }
+
+    watchlist->busy--;
+
+    if (watchlist->busy)
+        return;
+
+    /* remove the watches deleted by the handlers */
+    list_foreach(&watchlist->watches, p, n) {
+        watch = list_entry(p, watch_t, hook);
+
+        if (watch->handler == NULL) {
+            list_delete(&watch->hook);
+            watch_purge(watch);
+        }
+    }
+
+    if (list_empty(&watchlist->watches))
+        watchlist_del(bus, watchlist);
 }
 
 
@@ -282,12 +418,13 @@ static char *
 watch_rule(char *buf, size_t size, const char *name)
 {
     snprintf(buf, size,
+             "type='signal',"
              "sender='org.freedesktop.DBus',"
              "path='/org/freedesktop/DBus',"
              "interface='org.freedesktop.DBus',"
              "member='NameOwnerChanged',"
              "arg0='%s'", name);
-    
+
     return buf;
 }
 
@@ -298,20 +435,22 @@ watch_rule(char *buf, size_t size, const char *name)
 static int
 watchlist_add_match(bus_t *bus, watchlist_t *watchlist)
 {
-    DBusError err;
-    char      rule[1024];
+    char rule[1024];
 
     if (!bus->conn)
-        return TRUE;                         /* will retry once connected */
+        return FALSE;                        /* will retry once connected */
+
+    /*
+     * Notes:
+     *   We do not block for the reply. The owner query we send right
+     *   after this will tell if the name went away before the rule got
+     *   installed, so there is no window for missing the owner change.
+     */
 
     watch_rule(rule, sizeof(rule), watchlist->name);
-    dbus_bus_add_match(bus->conn, rule, &err);
+    dbus_bus_add_match(bus->conn, rule, NULL);
 
-    if (dbus_error_is_set(&err)) {
-        OHM_ERROR("dbus: failed to add match \"%s\" (%s)", rule, err.message);
-        dbus_error_free(&err);
-        return FALSE;
-    }
+    watchlist->matched = TRUE;
 
     return TRUE;
 }
@@ -325,6 +464,8 @@ watchlist_del_match(bus_t *bus, watchlist_t *watchlist)
 {
     char rule[1024];
 
+    watchlist->matched = FALSE;
+
     if (!bus->conn)
         return TRUE;
 
@@ -335,6 +476,157 @@ watchlist_del_match(bus_t *bus, watchlist_t *watchlist)
 }
 
 
+/********************
+ * owner_reply
+ ********************/
+static void
+owner_reply(DBusPendingCall *pending, void *data)
+{
+    watchlist_t *watchlist = (watchlist_t *)data;
+    DBusMessage *reply;
+    const char  *owner;
+
+    owner = "";
+    reply = dbus_pending_call_steal_reply(pending);
+
+    dbus_pending_call_unref(watchlist->query);
+    watchlist->query = NULL;
+
+    if (reply != NULL) {
+        if (dbus_message_get_type(reply) != DBUS_MESSAGE_TYPE_ERROR)
+            dbus_message_get_args(reply, NULL,
+                                  DBUS_TYPE_STRING, &owner,
+                                  DBUS_TYPE_INVALID);
+        else if (!dbus_message_is_error(reply, DBUS_ERROR_NAME_HAS_NO_OWNER))
+            OHM_WARNING("dbus: failed to query owner of %s", watchlist->name);
+    }
+
+    OHM_DEBUG(DBG_WATCH, "%s is owned by %s", watchlist->name,
+              *owner ? owner : "nobody");
+
+    watchlist_set_owner(watchlist, owner);
+    watchlist_notify(watchlist->bus, watchlist, "", owner, FALSE);
+
+    if (reply != NULL)
+        dbus_message_unref(reply);
+}
+
+
+/********************
+ * watchlist_query
+ ********************/
+static int
+watchlist_query(bus_t *bus, watchlist_t *watchlist)
+{
+    DBusMessage *msg;
+    int          success;
+
+    if (watchlist->query != NULL)
+        return TRUE;
+
+    msg = dbus_message_new_method_call("org.freedesktop.DBus",
+                                       "/org/freedesktop/DBus",
+                                       "org.freedesktop.DBus",
+                                       "GetNameOwner");
+    if (msg == NULL)
+        return FALSE;
+
+    success = dbus_message_append_args(msg,
+                                       DBUS_TYPE_STRING, &watchlist->name,
+                                       DBUS_TYPE_INVALID) &&
+        dbus_connection_send_with_reply(bus->conn, msg, &watchlist->query, -1);
+
+    dbus_message_unref(msg);
+
+    if (!success || watchlist->query == NULL) {
+        OHM_ERROR("dbus: failed to query owner of %s", watchlist->name);
+        watchlist->query = NULL;
+        return FALSE;
+    }
+
+    if (!dbus_pending_call_set_notify(watchlist->query, owner_reply,
+                                      watchlist, NULL)) {
+        dbus_pending_call_cancel(watchlist->query);
+        dbus_pending_call_unref(watchlist->query);
+        watchlist->query = NULL;
+        return FALSE;
+    }
+
+    watchlist->state = OWNER_QUERYING;
+
+    return TRUE;
+}
+
+
+/********************
+ * watch_flush
+ ********************/
+static gboolean
+watch_flush(gpointer data)
+{
+    bus_t       *bus = (bus_t *)data;
+    watchlist_t *watchlist;
+    int          nmatch;
+
+    bus->watchq_src = 0;
+
+    if (!bus->conn)
+        return FALSE;                        /* retried once connected */
+
+    nmatch = 0;
+
+    /* the handlers we call may add or delete watches, so always take
+     * the current head of the queue */
+    while (!list_empty(&bus->watchq)) {
+        watchlist = list_entry(bus->watchq.next, watchlist_t, queue);
+        list_delete(&watchlist->queue);
+
+        if (!watchlist->matched) {
+            watchlist_add_match(bus, watchlist);
+            watchlist_query(bus, watchlist);
+            nmatch++;
+        }
+        else if (watchlist->state == OWNER_KNOWN)
+            watchlist_notify(bus, watchlist, "", watchlist->owner ?: "", FALSE);
+    }
+
+    if (nmatch > 0) {
+        OHM_DEBUG(DBG_WATCH, "installed %d name watch%s on %s bus", nmatch,
+                  nmatch == 1 ? "" : "es",
+                  bus->type == DBUS_BUS_SYSTEM ? "system" : "session");
+    }
+
+    return FALSE;
+}
+
+
+/********************
+ * watchlist_schedule
+ ********************/
+static void
+watchlist_schedule(bus_t *bus, watchlist_t *watchlist)
+{
+    if (list_empty(&watchlist->queue))
+        list_append(&bus->watchq, &watchlist->queue);
+
+    if (!bus->watchq_src && bus->conn != NULL)
+        bus->watchq_src = g_idle_add(watch_flush, bus);
+}
+
+
+/********************
+ * watch_unschedule
+ ********************/
+static void
+watch_unschedule(bus_t *bus)
+{
+    if (bus->watchq_src) {
+        g_source_remove(bus->watchq_src);
+        bus->watchq_src = 0;
+    }
+}
+
+
 /********************
  * watch_dispatch
  ********************/
@@ -345,8 +637,6 @@ watch_dispatch(DBusConnection *c, DBusMessage *msg, void *data)
     bus_t       *bus;
     const char  *name, *previous, *current;
     watchlist_t *watchlist;
-    watch_t     *watch;
-    list_hook_t *p, *n;
 
     (void)data;
 
@@ -354,7 +644,7 @@ watch_dispatch(DBusConnection *c, DBusMessage *msg, void *data)
         !dbus_message_is_signal(msg,
                                 "org.freedesktop.DBus", "NameOwnerChanged"))
         return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
-    
+
     dbus_error_init(&err);
     if (!dbus_message_get_args(msg, &err,
                                DBUS_TYPE_STRING, &name,
@@ -368,12 +658,10 @@ watch_dispatch(DBusConnection *c, DBusMessage *msg, void *data)
     }
 
     if ((watchlist = watchlist_lookup(bus, name)) != NULL) {
-        list_foreach(&watchlist->watches, p, n) {
-            watch = list_entry(p, watch_t, hook);
-            watch->handler(name, previous, current, watch->data);
-        }
+        watchlist_set_owner(watchlist, current);
+        watchlist_notify(bus, watchlist, previous, current, TRUE);
     }
-    
+
     return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
 }
 
@@ -410,10 +698,20 @@ add_match(gpointer key, gpointer value, gpointer data)
 {
     watchlist_t *watchlist = (watchlist_t *)value;
     bus_t       *bus       = (bus_t *)data;
-    
+
     (void)key;
 
-    watchlist_add_match(bus, watchlist);
+    /* a new connection, everything needs to be set up again */
+    if (watchlist->query != NULL) {
+        dbus_pending_call_cancel(watchlist->query);
+        dbus_pending_call_unref(watchlist->query);
+        watchlist->query = NULL;
+    }
+
+    watchlist->matched = FALSE;
+    watchlist->state   = OWNER_UNKNOWN;
+
+    watchlist_schedule(bus, watchlist);
 }
 
 
@@ -424,7 +722,7 @@ static void
 session_bus_event(bus_t *bus, int event, void *data)
 {
     (void)data;
-    
+
     if (event == BUS_EVENT_CONNECTED) {
         watchlist_add_filter(bus);
         hash_table_foreach(bus->watches, add_match, bus);
@@ -432,11 +730,10 @@ session_bus_event(bus_t *bus, int event, void *data)
 }
 
 
-/* 
+/*
  * Local Variables:
  * c-basic-offset: 4
  * indent-tabs-mode: nil
  * End:
  * vim:set expandtab shiftwidth=4:
  */
-
@@ -59,7 +59,7 @@ static void plugin_init(OhmPlugin *plugin)
 
     OHM_INFO("delay: init ...");
 
-    fsif_init(plugin);
+    fsif_init(plugin, &DBG_FS);
     request_init(plugin);
     timer_init(plugin);
 }
@@ -75,7 +75,6 @@ static void plugin_exit(OhmPlugin *plugin)
 
 
 
-#include "fsif.c"
 #include "request.c"
 #include "timer.c"
 
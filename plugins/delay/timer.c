@@ -31,6 +31,8 @@ static int  timer_event_cb(void *);
 static void timer_init(OhmPlugin *plugin)
 {
     (void)plugin;
+
+    fsif_add_index(FACTSTORE_TIMER, TIMER_ID);
 }
 
 static int timer_add(char *id, unsigned int delay, char *cb_name,
@@ -52,7 +52,7 @@ static void plugin_init(OhmPlugin *plugin)
     OHM_DEBUG_INIT(media);
 
     dbusif_init(plugin);
-    fsif_init(plugin);
+    fsif_init(plugin, &DBG_FS);
     dresif_init(plugin);
     privacy_init(plugin);
     mute_init(plugin);
@@ -75,6 +75,7 @@ static int close_array(DBusMessageIter *, DBusMessageIter *);
 
 static int get_name_owner(const char *);
 static void name_queried(DBusPendingCall *, void *);
+static void client_queried(DBusPendingCall *, void *);
 static DBusHandlerResult name_changed(DBusConnection *, DBusMessage *, void *);
 
 static DBusHandlerResult proxy_method(DBusConnection *, DBusMessage *, void *);
@@ -407,25 +408,49 @@ void dbusif_monitor_client(const char *address, int monitor)
         "path='"      DBUS_ADMIN_PATH                "',"
         "arg0='"      "%s"                           "'";
 
-    char filter[256];
-    DBusError err;
+    char             filter[256];
+    DBusMessage     *msg;
+    DBusPendingCall *pend;
+    int              success;
 
     if (address != NULL) {
         snprintf(filter, sizeof(filter), fmt, address);
 
         if (monitor) {
-            dbus_error_init(&err);
-
             OHM_DEBUG(DBG_DBUS, "start monitoring client \"%s\"", address);
 
             /* setup_dbus_proxy_methods() already added the
                name_changed() filter */
 
-            dbus_bus_add_match(conn, filter, &err);
-
-            if (dbus_error_is_set(&err)) {
-                OHM_ERROR("Can't add match \"&s\": %s", filter, err.message);
-                dbus_error_free(&err);
+            /*
+             * We do not block for the AddMatch reply. The owner query
+             * right after it is handled by the bus in order, so a client
+             * that is gone before the match is in place gets noticed by
+             * client_queried().
+             */
+
+            dbus_bus_add_match(conn, filter, NULL);
+
+            msg = dbus_message_new_method_call(DBUS_ADMIN_SERVICE,
+                                               DBUS_ADMIN_PATH,
+                                               DBUS_ADMIN_INTERFACE,
+                                               DBUS_GET_NAME_OWNER_METHOD);
+            if (msg != NULL) {
+                pend    = NULL;
+                success = dbus_message_append_args(msg,
+                                                   DBUS_TYPE_STRING, &address,
+                                                   DBUS_TYPE_INVALID) &&
+                    dbus_connection_send_with_reply(conn, msg, &pend,
+                                                    timeout)          &&
+                    pend != NULL                                      &&
+                    dbus_pending_call_set_notify(pend, client_queried,
+                                                 strdup(address), free);
+
+                if (!success)
+                    OHM_ERROR("notification: failed to query client '%s'",
+                              address);
+
+                dbus_message_unref(msg);
             }
         }
         else {
@@ -985,6 +1010,23 @@ static void name_queried(DBusPendingCall *pend, void *data)
     dbus_pending_call_unref(pend);
 }
 
+static void client_queried(DBusPendingCall *pend, void *data)
+{
+    char        *client = (char *)data;
+    DBusMessage *reply;
+
+    if ((reply = dbus_pending_call_steal_reply(pend)) != NULL) {
+        if (dbus_message_is_error(reply, DBUS_ERROR_NAME_HAS_NO_OWNER)) {
+            OHM_DEBUG(DBG_DBUS, "client \"%s\" was already gone", client);
+            proxy_client_is_down(client);
+        }
+
+        dbus_message_unref(reply);
+    }
+
+    dbus_pending_call_unref(pend);
+}
+
 static DBusHandlerResult name_changed(DBusConnection *conn,
                                       DBusMessage    *msg,
                                       void           *ud)
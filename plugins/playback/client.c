@@ -33,6 +33,9 @@ static void client_init(OhmPlugin *plugin)
     cl_head.next = (void *)&cl_head;
     cl_head.prev = (void *)&cl_head;
 
+    fsif_add_index(FACTSTORE_PLAYBACK, "dbusid");
+    fsif_add_index(FACTSTORE_PLAYBACK, "pid");
+
     (void)plugin;
 }
 
@@ -55,6 +55,7 @@ static DBusHandlerResult notify(DBusConnection *,DBusMessage *, void*);
 static DBusHandlerResult method(DBusConnection *, DBusMessage *, void *);
 
 
+static void client_queried(DBusPendingCall *, void *);
 static void get_property_cb(DBusPendingCall *, void *);
 static void free_get_property_cb_data(void *);
 static void set_property_cb(DBusPendingCall *, void *);
@@ -365,8 +366,10 @@ dbusif_new_session(DBusConnection *c, DBusMessage *msg, void *data)
 
 static int dbusif_watch_client(const char *id, int watchit)
 {
-    char       filter[1024];
-    DBusError  err;
+    char             filter[1024];
+    DBusMessage     *msg;
+    DBusPendingCall *pend;
+    int              success;
 
     filter_signal(filter, sizeof(filter),
                   DBUS_ADMIN_INTERFACE, DBUS_ADMIN_INTERFACE,
@@ -376,28 +379,40 @@ static int dbusif_watch_client(const char *id, int watchit)
     
     /*
      * Notes:
-     *   We block when adding filters, to minimize (= eliminate ?) the time
-     *   window for the client to crash after it has let us know about itself
-     *   but before we managed to install the filter. According to the docs
-     *   we do not re-enter the main loop and all other messages than the
-     *   reply to AddMatch will get queued and processed once we're back in the
-     *   main loop. On the watch removal path we do not care about errors and
-     *   we do not want to block either.
+     *   We do not block for the reply to AddMatch. Instead we query the
+     *   owner of the name right after it. The bus handles our requests in
+     *   order, so if the client crashed before the match rule got in place
+     *   the reply to the query lets us know about it. On the watch removal
+     *   path we do not care about errors.
      */
 
-    if (watchit) {
-        dbus_error_init(&err);
-        dbus_bus_add_match(sess_conn, filter, &err);
+    if (!watchit) {
+        dbus_bus_remove_match(sess_conn, filter, NULL);
+        return TRUE;
+    }
 
-        if (dbus_error_is_set(&err)) {
-            OHM_ERROR("Can't add match \"%s\": %s", filter, err.message);
-            dbus_error_free(&err);
-            return FALSE;
-        }
+    dbus_bus_add_match(sess_conn, filter, NULL);
+
+    msg = dbus_message_new_method_call(DBUS_ADMIN_INTERFACE, DBUS_ADMIN_PATH,
+                                       DBUS_ADMIN_INTERFACE, "GetNameOwner");
+    if (msg == NULL)
+        return FALSE;
+
+    pend    = NULL;
+    success = dbus_message_append_args(msg, DBUS_TYPE_STRING, &id,
+                                       DBUS_TYPE_INVALID) &&
+              dbus_connection_send_with_reply(sess_conn, msg, &pend, timeout) &&
+              pend != NULL &&
+              dbus_pending_call_set_notify(pend, client_queried,
+                                           strdup(id), free);
+
+    dbus_message_unref(msg);
+
+    if (!success) {
+        OHM_ERROR("Failed to query the owner of %s", id);
+        return FALSE;
     }
-    else
-        dbus_bus_remove_match(sess_conn, filter, NULL);
-    
+
     return TRUE;
 }
 
@@ -1328,6 +1343,24 @@ static DBusHandlerResult method(DBusConnection *conn, DBusMessage *msg,
 
 
 
+static void client_queried(DBusPendingCall *pend, void *data)
+{
+    char        *dbusid = (char *)data;
+    DBusMessage *reply;
+
+    if ((reply = dbus_pending_call_steal_reply(pend)) != NULL) {
+        if (dbus_message_is_error(reply, DBUS_ERROR_NAME_HAS_NO_OWNER)) {
+            OHM_DEBUG(DBG_DBUS, "client %s was already gone", dbusid);
+            client_purge(dbusid);
+        }
+
+        dbus_message_unref(reply);
+    }
+
+    dbus_pending_call_unref(pend);
+}
+
+
 static void get_property_cb(DBusPendingCall *pend, void *data)
 {
     get_property_cb_data_t *cbd = (get_property_cb_data_t *)data;
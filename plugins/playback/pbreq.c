@@ -54,6 +54,8 @@ static pbreq_t *pbreq_create(client_t *cl, DBusMessage *msg)
             next->prev = req;
             req->prev  = prev;
 
+            TRC_RECORD(&trace, TRACE_PBREQ_CREATE, req->trid,
+                       cl && cl->sm ? cl->sm->id : 0, 0);
             OHM_DEBUG(DBG_QUE, "playback request %d created", req->trid);
         }
     }
@@ -66,6 +68,8 @@ static void pbreq_destroy(pbreq_t *req)
     pbreq_t *prev, *next;
 
     if (req != NULL) {
+        TRC_RECORD(&trace, TRACE_PBREQ_DESTROY, req->trid,
+                   req->cl && req->cl->sm ? req->cl->sm->id : 0, 0);
         OHM_DEBUG(DBG_QUE, "playback request %d is going to be destroyed",
                   req->trid);
 
@@ -38,6 +38,7 @@ USA.
 #include "dbusif.h"
 #include "dresif.h"
 #include "fsif.h"
+#include "trcring.h"
 
 static int DBG_CLIENT, DBG_MEDIA, DBG_DBUS, DBG_DRES, DBG_FS, \
            DBG_SM, DBG_TRANS, DBG_QUE;
@@ -53,6 +54,22 @@ OHM_DEBUG_PLUGIN(playback,
     OHM_DEBUG_FLAG("queue" , "queued requests"    , &DBG_QUE   )
 );
 
+/* events recorded in the trace ring */
+typedef enum {
+    TRACE_SM_EVENT = 0,         /* sm id, event id, old << 16 | new state */
+    TRACE_PBREQ_CREATE,         /* request trid, sm id */
+    TRACE_PBREQ_DESTROY,        /* request trid, sm id */
+    TRACE_MAX
+} trace_event_t;
+
+static const char *trace_events[TRACE_MAX] = {
+    [TRACE_SM_EVENT]      = "sm-event",
+    [TRACE_PBREQ_CREATE]  = "request-created",
+    [TRACE_PBREQ_DESTROY] = "request-destroyed",
+};
+
+static trcring_t trace;
+
 
 OHM_IMPORTABLE(void, timestamp_add, (const char *step));
 
@@ -72,13 +89,15 @@ static void plugin_init(OhmPlugin *plugin)
 {
     OHM_DEBUG_INIT(playback);
 
+    trcring_init(&trace, plugin, "playback", trace_events, TRACE_MAX);
+
     client_init(plugin);
     media_init(plugin);
     pbreq_init(plugin);
     sm_init(plugin);
     dbusif_init(plugin);
     dresif_init(plugin);
-    fsif_init(plugin);
+    fsif_init(plugin, &DBG_FS);
 
     timestamp_init();
 }
@@ -86,6 +105,7 @@ static void plugin_init(OhmPlugin *plugin)
 static void plugin_destroy(OhmPlugin *plugin)
 {
     fsif_exit(plugin);
+    trcring_exit(&trace);
 }
 
 
@@ -95,7 +115,6 @@ static void plugin_destroy(OhmPlugin *plugin)
 #include "sm.c"
 #include "dbusif.c"
 #include "dresif.c"
-#include "fsif.c"
 
 
 OHM_PLUGIN_REQUIRES_METHODS(playback, 1, 
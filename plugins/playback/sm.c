@@ -312,6 +312,8 @@ static void sm_init(OhmPlugin *plugin)
 
 static sm_t *sm_create(char *name, void *user_data)
 {
+    static uint32_t  id;
+
     sm_t *sm;
 
     if (!name) {
@@ -326,10 +328,11 @@ static sm_t *sm_create(char *name, void *user_data)
 
     memset(sm, 0, sizeof(*sm));
     sm->name = strdup(name);
+    sm->id   = ++id;
     sm->stid = sm_def.stid;
     sm->data = user_data;
 
-    OHM_DEBUG(DBG_SM, "[%s] state machine created", sm->name);
+    OHM_DEBUG(DBG_SM, "[%s] state machine %u created", sm->name, sm->id);
 
     return sm;
 }
@@ -441,6 +444,9 @@ static int sm_process_event(sm_t *sm, sm_evdata_t *evdata)
 
     next_state = sm_def.stdef + next_stid;
 
+    TRC_RECORD(&trace, TRACE_SM_EVENT, sm->id, evid,
+               (uint32_t)stid << 16 | (uint32_t)next_stid);
+
     OHM_DEBUG(DBG_SM, "[%s] %s '%s' state", sm->name,
               (next_stid == stid) ? "stays in" : "goes to", next_state->name);
 
@@ -55,6 +55,7 @@ typedef enum {
 
 typedef struct {
     char         *name;       /* name of the state machine instance */
+    uint32_t      id;         /* identifies the instance in the trace ring */
     sm_stid_t     stid;       /* ID of the current state */
     int           busy;       /* to prevent nested event processing */
     unsigned int  sched;      /* event source for scheduled event if any */
@@ -31,23 +31,46 @@ USA.
 #include "dbusif.h"
 #include "manager.h"
 
-typedef struct {
-    char                  *addr;
+typedef struct query_s {
+    struct query_s        *next;
     dbusif_pid_query_cb_t  func;
     void                  *data;
 } query_t;
 
+/*
+ * What we know about a D-Bus peer. The pid is queried once per peer and
+ * every query that comes while it is in flight is queued to 'queries'.
+ * The peer is forgotten when its unique name loses its owner.
+ */
+typedef struct {
+    char            *addr;
+    pid_t            pid;       /* 0 until the query succeeds */
+    int              pending;   /* pid query in flight */
+    DBusPendingCall *call;      /* the pid query while it is in flight */
+    int              gone;      /* name lost while the query was in flight */
+    query_t         *queries;   /* callbacks waiting for the pid */
+    GHashTable      *auth;      /* 'method/arg' -> authorized credentials */
+} peer_t;
+
 
 static DBusConnection   *sys_conn;       /* connection for D-Bus system bus */
 static DBusConnection   *sess_conn;      /* connection for D-Bus session bus */
 static int               timeout;        /* message timeout in msec */
 static int               use_system_bus; /* to use system or session bus */
 static resconn_t        *res_conn;       /* resource manager connection */
+static DBusConnection   *filter_conn;    /* connection with peer_filter */
+static GHashTable       *peers;          /* D-Bus address -> peer_t */
 
 static void system_bus_init(void);
 static void session_bus_init(const char *);
 static void res_conn_setup(DBusConnection *);
 static void pid_queried(DBusPendingCall *, void *);
+static peer_t *peer_create(const char *);
+static void peer_destroy(void *);
+static void peer_forget(const char *);
+static void peer_drop(gpointer, gpointer, gpointer);
+static char *peer_match_rule(const char *, char *, int);
+static DBusHandlerResult peer_filter(DBusConnection *, DBusMessage *, void *);
 
 
 
@@ -110,6 +133,23 @@ void dbusif_init(OhmPlugin *plugin)
 }
 
 
+void dbusif_exit(OhmPlugin *plugin)
+{
+    (void)plugin;
+
+    if (filter_conn != NULL) {
+        dbus_connection_remove_filter(filter_conn, peer_filter, NULL);
+        filter_conn = NULL;
+    }
+
+    if (peers != NULL) {
+        g_hash_table_foreach(peers, peer_drop, NULL);
+        g_hash_table_destroy(peers);
+        peers = NULL;
+    }
+}
+
+
 DBusHandlerResult dbusif_session_notification(DBusConnection *conn,
                                               DBusMessage    *msg,
                                               void           *ud)
@@ -168,23 +208,50 @@ DBusHandlerResult dbusif_session_notification(DBusConnection *conn,
 void dbusif_query_pid(char *addr, dbusif_pid_query_cb_t func, void *data)
 {
     DBusConnection  *conn  = use_system_bus ? sys_conn : sess_conn;
+    peer_t          *peer  = NULL;
     query_t         *query = NULL;
-    DBusMessage     *msg;
-    DBusPendingCall *pend;
-    int              success;
+    query_t         *last;
+    DBusMessage     *msg   = NULL;
+    DBusPendingCall *pend  = NULL;
+    char            *key;
+    char             rule[256];
+    int              matched = FALSE;
 
     if (!func)
         return;
 
     do { /* not a loop */
-        if (!conn || !(query = malloc(sizeof(query_t))))
+        if (!conn || !addr)
+            break;
+
+        if (peers != NULL && (peer = g_hash_table_lookup(peers, addr))) {
+            if (peer->pid) {
+                OHM_DEBUG(DBG_DBUS, "PID for address %s is cached: %u",
+                          addr, peer->pid);
+                func(peer->pid, data);
+                return;
+            }
+        }
+        else if ((peer = peer_create(addr)) == NULL)
+            break;
+
+        if ((query = malloc(sizeof(query_t))) == NULL)
             break;
 
         memset(query, 0, sizeof(query_t));
-        query->addr = strdup(addr);
         query->func = func;
         query->data = data;
 
+        if (peer->pending) {
+            for (last = (query_t *)&peer->queries; last->next; last=last->next)
+                ;
+            last->next = query;
+
+            OHM_DEBUG(DBG_DBUS, "PID query for address %s is already "
+                      "in progress", addr);
+            return;
+        }
+
         msg = dbus_message_new_method_call(DBUS_ADMIN_NAME,
                                            DBUS_ADMIN_PATH,
                                            DBUS_ADMIN_INTERFACE,
@@ -192,31 +259,97 @@ void dbusif_query_pid(char *addr, dbusif_pid_query_cb_t func, void *data)
         if (!msg)
             break;
 
-        success = dbus_message_append_args(msg,
-                                           DBUS_TYPE_STRING, &addr,
-                                           DBUS_TYPE_INVALID);
+        if (!dbus_message_append_args(msg,
+                                      DBUS_TYPE_STRING, &addr,
+                                      DBUS_TYPE_INVALID))
+            break;
+
+        /*
+         * Get notified when the peer goes away (non-blocking). The bus
+         * handles the match before the pid query, so a peer leaving
+         * after this point is seen leaving, and one that has already
+         * left fails the query. Unique names are never reused, so the
+         * query also confirms that the peer is still around.
+         */
+        dbus_bus_add_match(conn, peer_match_rule(addr, rule, sizeof(rule)),
+                           NULL);
+        matched = TRUE;
 
-        if (!success                                                    ||
-            !dbus_connection_send_with_reply(conn, msg, &pend, -1)      ||
-            !dbus_pending_call_set_notify(pend, pid_queried, query, NULL))
+        if (!dbus_connection_send_with_reply(conn, msg, &pend, -1) || !pend)
             break;
 
+        key = g_strdup(addr);
+
+        if (!dbus_pending_call_set_notify(pend, pid_queried, key, g_free)) {
+            g_free(key);
+            dbus_pending_call_cancel(pend);
+            dbus_pending_call_unref(pend);
+            break;
+        }
+
         dbus_message_unref(msg);
 
+        peer->pending = TRUE;
+        peer->call    = pend;
+        peer->queries = query;
+
         OHM_DEBUG(DBG_DBUS, "quering PID for address %s on %s bus",
-                  query->addr, use_system_bus ? "system" : "session");
+                  addr, use_system_bus ? "system" : "session");
 
         return;
     } while (0);
 
-    if (query) {
-        free(query->addr);
-        free(query);
+    if (msg)
+        dbus_message_unref(msg);
+
+    if (peer && !peer->pending && !peer->pid) {
+        if (matched)
+            dbus_bus_remove_match(conn, rule, NULL);
+
+        g_hash_table_remove(peers, addr);
     }
 
+    free(query);
+
     func(0, data);
 }
 
+int dbusif_peer_authorized(char *addr, char *method, char *arg)
+{
+    peer_t *peer;
+    char    key[512];
+
+    if (peers == NULL || addr == NULL || method == NULL || arg == NULL)
+        return FALSE;
+
+    if ((peer = g_hash_table_lookup(peers, addr)) == NULL || !peer->pid)
+        return FALSE;
+
+    snprintf(key, sizeof(key), "%s/%s", method, arg);
+
+    return peer->auth != NULL && g_hash_table_lookup(peer->auth, key) != NULL;
+}
+
+void dbusif_peer_set_authorized(char *addr, char *method, char *arg)
+{
+    peer_t *peer;
+    char    key[512];
+
+    if (peers == NULL || addr == NULL || method == NULL || arg == NULL)
+        return;
+
+    if ((peer = g_hash_table_lookup(peers, addr)) == NULL || !peer->pid)
+        return;
+
+    if (peer->auth == NULL)
+        peer->auth = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                           g_free, NULL);
+
+    snprintf(key, sizeof(key), "%s/%s", method, arg);
+
+    g_hash_table_insert(peer->auth, g_strdup(key), GINT_TO_POINTER(TRUE));
+}
+
 
 /*!
  * @}
@@ -322,11 +455,19 @@ static void res_conn_setup(DBusConnection *conn)
     resproto_set_handler(res_conn, RESMSG_RELEASE   , manager_release   );
     resproto_set_handler(res_conn, RESMSG_AUDIO     , manager_audio     );
     resproto_set_handler(res_conn, RESMSG_VIDEO     , manager_video     );
+
+    if (dbus_connection_add_filter(conn, peer_filter, NULL, NULL))
+        filter_conn = conn;
+    else
+        OHM_ERROR("resource: can't add D-Bus filter for peer tracking");
 }
 
 static void pid_queried(DBusPendingCall *pend, void *data)
 {
-    query_t       *query   = (query_t *)data;
+    char          *addr    = (char *)data;
+    peer_t        *peer    = NULL;
+    query_t       *query;
+    query_t       *next;
     int            success = FALSE;
     dbus_uint32_t  pid     = 0;
     const char    *error   = "";
@@ -363,18 +504,29 @@ static void pid_queried(DBusPendingCall *pend, void *data)
 
     } while(0);
 
-    if (query) {
-        if (success)
-            OHM_DEBUG(DBG_DBUS, "pid query succeeded: %s -> %u",
-                      query->addr, pid);
-        else
-            OHM_DEBUG(DBG_DBUS, "pid query for %s failed: %s",
-                      query->addr, error);
+    if (success)
+        OHM_DEBUG(DBG_DBUS, "pid query succeeded: %s -> %u", addr, pid);
+    else
+        OHM_DEBUG(DBG_DBUS, "pid query for %s failed: %s", addr, error);
+
+    if (peers != NULL && (peer = g_hash_table_lookup(peers, addr)) != NULL) {
+        query = peer->queries;
 
-        query->func(pid, query->data);
+        peer->pending = FALSE;
+        peer->call    = NULL;
+        peer->queries = NULL;
 
-        free(query->addr);
-        free(query);
+        /* don't keep anything about failed queries or vanished peers */
+        if (success && !peer->gone)
+            peer->pid = pid;
+        else
+            peer_forget(addr);
+
+        for (;  query != NULL;  query = next) {
+            next = query->next;
+            query->func(pid, query->data);
+            free(query);
+        }
     }
 
     if (reply)
@@ -383,6 +535,125 @@ static void pid_queried(DBusPendingCall *pend, void *data)
     dbus_pending_call_unref(pend);
 }
 
+static peer_t *peer_create(const char *addr)
+{
+    peer_t *peer;
+
+    if (peers == NULL)
+        peers = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                      NULL, peer_destroy);
+
+    if ((peer = malloc(sizeof(peer_t))) != NULL) {
+        memset(peer, 0, sizeof(peer_t));
+        peer->addr = strdup(addr);
+
+        g_hash_table_insert(peers, peer->addr, peer);
+    }
+
+    return peer;
+}
+
+static void peer_destroy(void *data)
+{
+    peer_t  *peer = (peer_t *)data;
+    query_t *query;
+
+    if (peer != NULL) {
+        while ((query = peer->queries) != NULL) {
+            peer->queries = query->next;
+            free(query);
+        }
+
+        if (peer->auth != NULL)
+            g_hash_table_destroy(peer->auth);
+
+        free(peer->addr);
+        free(peer);
+    }
+}
+
+static void peer_forget(const char *addr)
+{
+    DBusConnection *conn = use_system_bus ? sys_conn : sess_conn;
+    peer_t         *peer;
+    char            rule[256];
+
+    if (peers == NULL || (peer = g_hash_table_lookup(peers, addr)) == NULL)
+        return;
+
+    if (peer->pending) {
+        /* pid_queried() will drop it */
+        peer->gone = TRUE;
+        return;
+    }
+
+    OHM_DEBUG(DBG_DBUS, "forgetting peer %s", addr);
+
+    if (conn != NULL)
+        dbus_bus_remove_match(conn, peer_match_rule(addr, rule, sizeof(rule)),
+                              NULL);
+
+    g_hash_table_remove(peers, addr);
+}
+
+/* teardown of a peer when the plugin goes away; peers is destroyed next */
+static void peer_drop(gpointer key, gpointer value, gpointer data)
+{
+    DBusConnection *conn = use_system_bus ? sys_conn : sess_conn;
+    peer_t         *peer = (peer_t *)value;
+    char            rule[256];
+
+    (void)key;
+    (void)data;
+
+    if (peer->call != NULL) {
+        dbus_pending_call_cancel(peer->call);
+        dbus_pending_call_unref(peer->call);
+        peer->call = NULL;
+    }
+
+    if (conn != NULL)
+        dbus_bus_remove_match(conn, peer_match_rule(peer->addr, rule,
+                                                    sizeof(rule)), NULL);
+}
+
+static char *peer_match_rule(const char *addr, char *buf, int len)
+{
+    snprintf(buf, len, "type='signal',sender='%s',interface='%s',"
+             "member='%s',path='%s',arg0='%s'", DBUS_ADMIN_NAME,
+             DBUS_ADMIN_INTERFACE, DBUS_NAME_OWNER_CHANGED_SIGNAL,
+             DBUS_ADMIN_PATH, addr);
+
+    return buf;
+}
+
+static DBusHandlerResult peer_filter(DBusConnection *conn,
+                                     DBusMessage    *msg,
+                                     void           *ud)
+{
+    char *name;
+    char *before;
+    char *after;
+
+    (void)conn;
+    (void)ud;
+
+    if (peers != NULL &&
+        dbus_message_is_signal(msg, DBUS_ADMIN_INTERFACE,
+                               DBUS_NAME_OWNER_CHANGED_SIGNAL) &&
+        dbus_message_get_args(msg, NULL,
+                              DBUS_TYPE_STRING, &name,
+                              DBUS_TYPE_STRING, &before,
+                              DBUS_TYPE_STRING, &after,
+                              DBUS_TYPE_INVALID) &&
+        (after == NULL || after[0] == '\0'))
+    {
+        peer_forget(name);
+    }
+
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
 /* 
  * Local Variables:
  * c-basic-offset: 4
@@ -52,9 +52,12 @@ typedef struct _OhmPlugin OhmPlugin;
 
 
 void dbusif_init(OhmPlugin *);
+void dbusif_exit(OhmPlugin *);
 DBusHandlerResult dbusif_session_notification(DBusConnection *, DBusMessage *,
                                               void *);
 void dbusif_query_pid(char *, dbusif_pid_query_cb_t, void *);
+int  dbusif_peer_authorized(char *, char *, char *);
+void dbusif_peer_set_authorized(char *, char *, char *);
 
 #endif /* __OHM_RESOURCE_DBUSIF_H__ */
 
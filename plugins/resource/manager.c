@@ -52,6 +52,18 @@ typedef struct reg_data_s {
     char              *arg;
 } reg_data_t;
 
+typedef struct batch_req_s {
+    struct batch_req_s *next;
+    uint32_t            manager_id;
+    char               *client_name;
+    uint32_t            client_id;
+    char               *request;
+    uint32_t            reqno;
+    int                 reply;      /* queue a grant with reqno when done */
+    uint32_t            txid;       /* transaction kept open until resolved */
+    int                 resolved;
+} batch_req_t;
+
 typedef void (*auth_request_cb_t)(int, char *, void *);
 
 OHM_IMPORTABLE(int, auth_request, (char *id_type,  void *id,
@@ -59,8 +71,22 @@ OHM_IMPORTABLE(int, auth_request, (char *id_type,  void *id,
                                    auth_request_cb_t callback, void *data));
 
 static uint32_t     trans_id;
+static int          trans_deferred;
 static reg_data_t  *reg_reqs;
 
+static int          batch_enabled;
+static uint32_t     batch_window;     /* in usecs, 0 = next idle */
+static guint        batch_srcid;
+static batch_req_t *batch_head;
+static batch_req_t *batch_tail;
+static uint32_t     stat_requests;
+static uint32_t     stat_resolves;
+
+static void batch_config(OhmPlugin *);
+static int  resolve_request(resource_set_t *, uint32_t, char *, uint32_t,
+                            char *, int);
+static gboolean batch_flush(gpointer);
+
 static void forced_auto_release(resource_set_t *);
 
 static void keyword_list(char *, char **, int);
@@ -93,8 +119,6 @@ void manager_init(OhmPlugin *plugin)
 #define ADD_FIELD_WATCH(n,cb) \
     fsif_add_field_watch(FACTSTORE_RESOURCE_SET,NULL, n, cb, NULL)
 
-    (void)plugin;
-
     char *name      = "auth.request";
     char *signature = (char *)auth_request_SIGNATURE; 
 
@@ -112,11 +136,39 @@ void manager_init(OhmPlugin *plugin)
     ADD_FIELD_WATCH("request", request_cb);
     ADD_FIELD_WATCH("block"  , block_cb  );
 
+    batch_config(plugin);
+
     LEAVE;
 
 #undef ADD_FIELD_WATCH
 }
 
+void manager_exit(OhmPlugin *plugin)
+{
+    batch_req_t *req;
+    batch_req_t *next;
+
+    (void)plugin;
+
+    if (batch_srcid) {
+        g_source_remove(batch_srcid);
+        batch_srcid = 0;
+    }
+
+    for (req = batch_head;   req;   req = next) {
+        next = req->next;
+
+        if (req->txid != NO_TRANSACTION)
+            transaction_unref(req->txid);
+
+        free(req->client_name);
+        free(req->request);
+        free(req);
+    }
+
+    batch_head = batch_tail = NULL;
+}
+
 void manager_register(resmsg_t *msg, resset_t *resset, void *proto_data)
 {
     resource_set_dump_message(msg, resset, "from");
@@ -164,8 +216,8 @@ void manager_unregister(resmsg_t *msg, resset_t *resset, void *proto_data)
         resource_set_destroy(resset);
 
     if (manager_id) {
-        dresif_resource_request(manager_id, client_name, client_id,
-                                "unregister");
+        resolve_request(NULL, manager_id, client_name, client_id,
+                        "unregister", FALSE);
     }
 
     OHM_DEBUG(DBG_MGR, "message replied with %d '%s'", errcod, errmsg);
@@ -244,13 +296,15 @@ void manager_update(resmsg_t *msg, resset_t *resset, void *proto_data)
         rs->granted.client != 0)
         resource_set_update_factstore(resset, update_request);
 
-    dresif_resource_request(rs->manager_id, resset->peer, resset->id, "update");
+    resolve_request(rs, rs->manager_id, resset->peer, resset->id, "update",
+                    resset->mode & RESMSG_MODE_ALWAYS_REPLY);
 
  reply_message:
     OHM_DEBUG(DBG_MGR, "message replied with %d '%s'", errcod, errmsg);
     resproto_reply_message(resset, msg, proto_data, errcod, errmsg);
 
-    if (trans_id != NO_TRANSACTION && (resset->mode & RESMSG_MODE_ALWAYS_REPLY))
+    if (trans_id != NO_TRANSACTION && !trans_deferred &&
+        (resset->mode & RESMSG_MODE_ALWAYS_REPLY))
         resource_set_queue_change(rs, trans_id, rs->reqno, resource_set_granted);
 
     transaction_end(rs);
@@ -280,8 +334,7 @@ void manager_acquire(resmsg_t *msg, resset_t *resset, void *proto_data)
         if (!rs->request || strcmp(rs->request, "acquire")) {
             acquire = TRUE;
 
-            free(rs->request);
-            rs->request = strdup("acquire");
+            rs->request = g_intern_string("acquire");
         }
         else if ((rs->advice.client & ~(rs->granted.client)) != 0) {
             acquire = TRUE;
@@ -292,8 +345,8 @@ void manager_acquire(resmsg_t *msg, resset_t *resset, void *proto_data)
 
         if (acquire) {
             resource_set_update_factstore(resset, update_request);
-            dresif_resource_request(rs->manager_id, resset->peer,
-                                    resset->id, "acquire");
+            resolve_request(rs, rs->manager_id, resset->peer, resset->id,
+                            "acquire", resset->mode & RESMSG_MODE_ALWAYS_REPLY);
         }
     }
 
@@ -301,7 +354,8 @@ void manager_acquire(resmsg_t *msg, resset_t *resset, void *proto_data)
 
     resproto_reply_message(resset, msg, proto_data, errcod, errmsg);
 
-    if (rs && trans_id && (resset->mode & RESMSG_MODE_ALWAYS_REPLY)) {
+    if (rs && trans_id && !trans_deferred &&
+        (resset->mode & RESMSG_MODE_ALWAYS_REPLY)) {
         resource_set_queue_change(rs,trans_id,rs->reqno,resource_set_granted);
     }
 
@@ -332,8 +386,7 @@ void manager_release(resmsg_t *msg, resset_t *resset, void *proto_data)
         if (!rs->request || strcmp(rs->request, "release")) {
             release = TRUE;
 
-            free(rs->request);
-            rs->request = strdup("release");
+            rs->request = g_intern_string("release");
         }
         else if (rs->granted.client != 0)
             release = TRUE;
@@ -348,8 +401,8 @@ void manager_release(resmsg_t *msg, resset_t *resset, void *proto_data)
 
         if (release) {
             resource_set_update_factstore(resset, update_request);
-            dresif_resource_request(rs->manager_id, resset->peer,
-                                    resset->id, "release");
+            resolve_request(rs, rs->manager_id, resset->peer, resset->id,
+                            "release", resset->mode & RESMSG_MODE_ALWAYS_REPLY);
         }
     }
 
@@ -357,7 +410,8 @@ void manager_release(resmsg_t *msg, resset_t *resset, void *proto_data)
 
     resproto_reply_message(resset, msg, proto_data, errcod, errmsg);
 
-    if (rs && trans_id && (resset->mode & RESMSG_MODE_ALWAYS_REPLY)) {
+    if (rs && trans_id && !trans_deferred &&
+        (resset->mode & RESMSG_MODE_ALWAYS_REPLY)) {
         resource_set_queue_change(rs,trans_id,rs->reqno,resource_set_granted);
     }
 
@@ -394,8 +448,8 @@ void manager_audio(resmsg_t *msg, resset_t *resset, void *proto_data)
                                         propnam, method,pattern);
 
         if (success) {
-            dresif_resource_request(rs->manager_id, resset->peer,
-                                    resset->id, "audio");
+            resolve_request(rs, rs->manager_id, resset->peer, resset->id,
+                            "audio", FALSE);
         }
     }
 
@@ -429,8 +483,8 @@ void manager_video(resmsg_t *msg, resset_t *resset, void *proto_data)
         success = resource_set_add_spec(resset, resource_video, pid);
 
         if (success) {
-            dresif_resource_request(rs->manager_id, resset->peer,
-                                    resset->id, "video");
+            resolve_request(rs, rs->manager_id, resset->peer, resset->id,
+                            "video", FALSE);
         }
     }
 
@@ -440,10 +494,207 @@ void manager_video(resmsg_t *msg, resset_t *resset, void *proto_data)
 }
 
 
+void manager_statistics(uint32_t *requests, uint32_t *resolves)
+{
+    if (requests != NULL)
+        *requests = stat_requests;
+
+    if (resolves != NULL)
+        *resolves = stat_resolves;
+}
+
+
 /*!
  * @}
  */
 
+static void batch_config(OhmPlugin *plugin)
+{
+    const char *batch_str;
+    const char *window_str;
+    char       *e;
+
+    if ((batch_str = ohm_plugin_get_param(plugin, "batch-requests")) != NULL) {
+        if (!strcmp(batch_str, "yes"))
+            batch_enabled = TRUE;
+        else if (strcmp(batch_str, "no")) {
+            OHM_ERROR("resource: invalid value '%s' for 'batch-requests'",
+                      batch_str);
+        }
+    }
+
+    if ((window_str = ohm_plugin_get_param(plugin, "batch-window")) != NULL) {
+        batch_window = strtoul(window_str, &e, 10);
+
+        if (*e != '\0') {
+            OHM_ERROR("resource: invalid value '%s' for 'batch-window'",
+                      window_str);
+            batch_window = 0;
+        }
+    }
+
+    if (!batch_enabled)
+        OHM_INFO("resource: resource requests are resolved one by one");
+    else if (!batch_window)
+        OHM_INFO("resource: resource requests are batched per main loop "
+                 "iteration");
+    else
+        OHM_INFO("resource: resource requests are batched for %uusec",
+                 batch_window);
+}
+
+/*
+ * Resolve a resource request right away or, in batching mode, queue it
+ * for batch_flush(). A batched request keeps the current transaction
+ * open, so none of its changes get sent before the batch is resolved.
+ * Returns TRUE if the request was batched.
+ */
+static int resolve_request(resource_set_t *rs,
+                           uint32_t        manager_id,
+                           char           *client_name,
+                           uint32_t        client_id,
+                           char           *request,
+                           int             reply)
+{
+    batch_req_t *req;
+    guint        msecs;
+
+    stat_requests++;
+
+    TRC_RECORD(&resource_trace, TRACE_REQUEST,
+               manager_id, rs ? rs->reqno : 0, trans_id);
+
+    if (!batch_enabled || (req = malloc(sizeof(batch_req_t))) == NULL) {
+        stat_resolves++;
+        dresif_resource_request(manager_id, client_name, client_id, request);
+        return FALSE;
+    }
+
+    memset(req, 0, sizeof(batch_req_t));
+    req->manager_id  = manager_id;
+    req->client_name = strdup(client_name ? client_name : "<unidentified>");
+    req->client_id   = client_id;
+    req->request     = strdup(request);
+    req->reqno       = rs ? rs->reqno : 0;
+    req->reply       = reply ? TRUE : FALSE;
+
+    if (trans_id != NO_TRANSACTION && transaction_ref(trans_id)) {
+        req->txid      = trans_id;
+        trans_deferred = TRUE;
+    }
+
+    if (batch_tail != NULL)
+        batch_tail->next = req;
+    else
+        batch_head = req;
+
+    batch_tail = req;
+
+    if (!batch_srcid) {
+        if (batch_window) {
+            msecs = (batch_window + 999) / 1000;
+            batch_srcid = g_timeout_add(msecs, batch_flush, NULL);
+        }
+        else
+            batch_srcid = g_idle_add(batch_flush, NULL);
+    }
+
+    OHM_DEBUG(DBG_MGR, "%s request of %s/%u (manager id %u) batched",
+              request, req->client_name, client_id, manager_id);
+
+    return TRUE;
+}
+
+/*
+ * The factstore already reflects every batched request, so one
+ * resolution does for all requests of the same kind. The kinds are
+ * resolved in the order they first appear in the batch, each with the
+ * arguments of its latest request. While a kind is resolved, every
+ * resource set with a request of that kind has its own request number,
+ * so the replies triggered by the resolution carry the right one. The
+ * grants of always-reply clients are queued afterwards in request order.
+ */
+static gboolean batch_flush(gpointer data)
+{
+    batch_req_t    *list;
+    batch_req_t    *req;
+    batch_req_t    *kind;
+    batch_req_t    *r;
+    batch_req_t    *next;
+    resource_set_t *rs;
+    int             nreq;
+    int             nkind;
+
+    (void)data;
+
+    list = batch_head;
+
+    batch_head  = batch_tail = NULL;
+    batch_srcid = 0;
+
+    if (list == NULL)
+        return FALSE;
+
+    transaction_start(NULL, NULL);
+
+    for (req = list, nreq = nkind = 0;   req;   req = req->next, nreq++) {
+        if (req->resolved)
+            continue;
+
+        for (kind = req, r = req->next;   r;   r = r->next) {
+            if (!strcmp(r->request, req->request))
+                kind = r;
+        }
+
+        for (r = req;   r;   r = r->next) {
+            if (!strcmp(r->request, req->request)) {
+                r->resolved = TRUE;
+
+                if ((rs = resource_set_find_by_id(r->manager_id)) != NULL)
+                    rs->reqno = r->reqno;
+            }
+        }
+
+        stat_resolves++;
+        nkind++;
+
+        dresif_resource_request(kind->manager_id, kind->client_name,
+                                kind->client_id, kind->request);
+
+        for (r = req;   r;   r = r->next) {
+            if (!strcmp(r->request, req->request) &&
+                (rs = resource_set_find_by_id(r->manager_id)) != NULL)
+                rs->reqno = 0;
+        }
+    }
+
+    OHM_DEBUG(DBG_MGR, "resolved %d batched request%s in %d resolution%s",
+              nreq, nreq == 1 ? "" : "s", nkind, nkind == 1 ? "" : "s");
+
+    for (req = list;   req;   req = req->next) {
+        rs = resource_set_find_by_id(req->manager_id);
+
+        if (rs != NULL && req->reply && trans_id != NO_TRANSACTION)
+            resource_set_queue_change(rs, trans_id, req->reqno,
+                                      resource_set_granted);
+    }
+
+    for (req = list;   req;   req = next) {
+        next = req->next;
+
+        if (req->txid != NO_TRANSACTION)
+            transaction_unref(req->txid);
+
+        free(req->client_name);
+        free(req->request);
+        free(req);
+    }
+
+    transaction_end(NULL);
+
+    return FALSE;
+}
+
 static void forced_auto_release(resource_set_t *rs)
 {
     static resmsg_t zeromsg;
@@ -459,15 +710,14 @@ static void forced_auto_release(resource_set_t *rs)
 
             transaction_start(rs, &zeromsg);
 
-            free(rs->request);
-            rs->request = strdup("release");
+            rs->request = g_intern_string("release");
             rs->block   = 0;
 
             resource_set_update_factstore(resset, update_block);
             resource_set_update_factstore(resset, update_request);
 
-            dresif_resource_request(rs->manager_id, resset->peer,
-                                    resset->id, "release");
+            resolve_request(rs, rs->manager_id, resset->peer, resset->id,
+                            "release", FALSE);
 
             transaction_end(rs);
         }
@@ -503,6 +753,12 @@ static void pid_cb(pid_t pid, void *data)
     else {
         if (!regreq->authorize || regreq->canceled)
             register_cb(0, regreq);
+        else if (dbusif_peer_authorized(regreq->resset->peer,
+                                        regreq->method, regreq->arg)) {
+            OHM_DEBUG(DBG_AUTH, "credentials of %s for '%s' were already "
+                      "checked", regreq->resset->peer, regreq->arg);
+            authorize_cb(TRUE, NULL, regreq);
+        }
         else {
             OHM_DEBUG(DBG_AUTH, "auth_request('pid', '%u', '%s', '%s')",
                       regreq->pid, regreq->method, regreq->arg);
@@ -525,8 +781,14 @@ static void authorize_cb(int authorized, char *autherr, void *data)
 
     (void)autherr;
 
-    if (authorized)
+    if (authorized) {
         OHM_DEBUG(DBG_AUTH, "registration allowed");
+
+        /* the peer keeps its credentials as long as it is on the bus */
+        if (regreq->authorize && !regreq->canceled)
+            dbusif_peer_set_authorized(regreq->resset->peer,
+                                       regreq->method, regreq->arg);
+    }
     else
         OHM_DEBUG(DBG_AUTH, "registration forbidden: %s", strerror(errcod));
 
@@ -567,7 +829,8 @@ static void register_cb(int32_t errcod, reg_data_t *regreq)
     }
 
     transaction_start(rs, msg);
-    dresif_resource_request(rs->manager_id, resset->peer, resset->id, "register");
+    resolve_request(rs, rs->manager_id, resset->peer, resset->id, "register",
+                    FALSE);
 
  reply_message:
     OHM_DEBUG(DBG_MGR, "message replied with %d '%s'", errcod, errmsg);
@@ -588,7 +851,6 @@ static void granted_cb(fsif_entry_t *entry,
     uint32_t        granted;
     resource_set_t *rs;
     resset_t       *resset;
-    char           *granted_str;
     char            buf[256];
 
     (void)name;
@@ -601,11 +863,13 @@ static void granted_cb(fsif_entry_t *entry,
     }
 
     granted = fld->value.integer;
-    granted_str = resmsg_res_str(granted, buf, sizeof(buf));
 
     if ((rs = resource_set_find(entry))  && (resset = rs->resset)) {
-        OHM_DEBUG(DBG_MGR, "resource set %s/%u (manager id %u) grant changed: "
-                  "%s", resset->peer, resset->id, rs->manager_id, granted_str);
+        TRC_RECORD(&resource_trace, TRACE_GRANT,
+                   rs->manager_id, granted, trans_id);
+        TRC_DEBUG(DBG_MGR, "resource set %s/%u (manager id %u) grant changed: "
+                  "%s", resset->peer, resset->id, rs->manager_id,
+                  resmsg_res_str(granted, buf, sizeof(buf)));
 
         rs->granted.factstore = granted;
         
@@ -631,7 +895,6 @@ static void advice_cb(fsif_entry_t *entry,
     uint32_t        advice;
     resource_set_t *rs;
     resset_t       *resset;
-    char           *advice_str;
     char            buf[256];
 
     (void)name;
@@ -644,11 +907,13 @@ static void advice_cb(fsif_entry_t *entry,
     }
 
     advice = fld->value.integer;
-    advice_str = resmsg_res_str(advice, buf, sizeof(buf));
 
     if ((rs = resource_set_find(entry))  && (resset = rs->resset)) {
-        OHM_DEBUG(DBG_MGR,"resource set %s/%u (manager id %u) advice changed: "
-                  "%s", resset->peer, resset->id, rs->manager_id, advice_str);
+        TRC_RECORD(&resource_trace, TRACE_ADVICE,
+                   rs->manager_id, advice, trans_id);
+        TRC_DEBUG(DBG_MGR,"resource set %s/%u (manager id %u) advice changed: "
+                  "%s", resset->peer, resset->id, rs->manager_id,
+                  resmsg_res_str(advice, buf, sizeof(buf)));
 
         rs->advice.factstore = advice;
 
@@ -689,8 +954,7 @@ static void request_cb(fsif_entry_t *entry,
                       "changed: %s", resset->peer, resset->id, rs->manager_id,
                       request);
 
-            free(rs->request);
-            rs->request = strdup(request);
+            rs->request = g_intern_string(request);
         }
     }
 }
@@ -866,6 +1130,7 @@ static void transaction_end(resource_set_t *rs)
     if (trans_id != NO_TRANSACTION) {
         transaction_unref(trans_id);
         trans_id = NO_TRANSACTION;
+        trans_deferred = FALSE;
 
         if (rs != NULL)
             rs->reqno = 0;
@@ -27,6 +27,7 @@ USA.
 typedef struct _OhmPlugin OhmPlugin;
 
 void manager_init(OhmPlugin *);
+void manager_exit(OhmPlugin *);
 
 void manager_register(resmsg_t *, resset_t *, void *);
 void manager_unregister(resmsg_t *, resset_t *, void *);
@@ -36,6 +37,8 @@ void manager_release(resmsg_t *, resset_t *, void *);
 void manager_audio(resmsg_t *, resset_t *, void *);
 void manager_video(resmsg_t *, resset_t *, void *);
 
+void manager_statistics(uint32_t *, uint32_t *);
+
 #endif	/* __OHM_RESOURCE_MANAGER_H__ */
 
 /* 
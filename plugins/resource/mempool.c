@@ -0,0 +1,106 @@
+/*************************************************************************
+Copyright (C) 2010 Nokia Corporation.
+
+These OHM Modules are free software; you can redistribute
+it and/or modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation
+version 2.1 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301
+USA.
+*************************************************************************/
+
+
+/*! \defgroup pubif Public Interfaces */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "plugin.h"
+#include "mempool.h"
+
+
+/*! \addtogroup pubif
+ *  Functions
+ *  @{
+ */
+
+void *mempool_alloc(mempool_t *pool)
+{
+    void *obj;
+
+    if ((obj = pool->free) != NULL) {
+        pool->free = *(void **)obj;
+        pool->nfree--;
+        pool->reuses++;
+    }
+    else {
+        if ((obj = malloc(pool->size)) == NULL)
+            return NULL;
+
+        pool->allocs++;
+    }
+
+    if (++pool->inuse > pool->peak)
+        pool->peak = pool->inuse;
+
+    memset(obj, 0, pool->size);
+
+    return obj;
+}
+
+void mempool_free(mempool_t *pool, void *obj)
+{
+    if (obj == NULL)
+        return;
+
+    pool->inuse--;
+
+    if (pool->nfree >= pool->maxfree)
+        free(obj);
+    else {
+        *(void **)obj = pool->free;
+        pool->free = obj;
+        pool->nfree++;
+    }
+}
+
+void mempool_flush(mempool_t *pool)
+{
+    void *obj;
+
+    while ((obj = pool->free) != NULL) {
+        pool->free = *(void **)obj;
+        free(obj);
+    }
+
+    pool->nfree = 0;
+}
+
+void mempool_dump_statistics(mempool_t *pool, int debug)
+{
+    OHM_DEBUG(debug, "%s pool: %u in use (peak %u), %u free, %u malloc'ed, "
+              "%u reused", pool->name, pool->inuse, pool->peak, pool->nfree,
+              pool->allocs, pool->reuses);
+}
+
+
+/*!
+ * @}
+ */
+
+
+/* 
+ * Local Variables:
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ * vim:set expandtab shiftwidth=4:
+ */
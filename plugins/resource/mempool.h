@@ -0,0 +1,60 @@
+/*************************************************************************
+Copyright (C) 2010 Nokia Corporation.
+
+These OHM Modules are free software; you can redistribute
+it and/or modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation
+version 2.1 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301
+USA.
+*************************************************************************/
+
+
+#ifndef __OHM_RESOURCE_MEMPOOL_H__
+#define __OHM_RESOURCE_MEMPOOL_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Free-list pool for the fixed size objects of the hot paths. Released
+ * objects are kept for reuse up to 'maxfree', the rest go back to malloc.
+ */
+typedef struct {
+    const char  *name;
+    size_t       size;
+    uint32_t     maxfree;
+    void        *free;          /* list of released objects */
+    uint32_t     nfree;         /* length of the free list */
+    uint32_t     inuse;         /* objects currently handed out */
+    uint32_t     peak;          /* highest value of inuse */
+    uint32_t     allocs;        /* objects malloc'ed */
+    uint32_t     reuses;        /* objects taken from the free list */
+} mempool_t;
+
+#define MEMPOOL_INITIALIZER(n, type, max)                               \
+    { n, sizeof(type) > sizeof(void *) ? sizeof(type) : sizeof(void *), \
+      max, NULL, 0, 0, 0, 0, 0 }
+
+void *mempool_alloc(mempool_t *);
+void  mempool_free(mempool_t *, void *);
+void  mempool_flush(mempool_t *);
+void  mempool_dump_statistics(mempool_t *, int);
+
+#endif	/* __OHM_RESOURCE_MEMPOOL_H__ */
+
+/* 
+ * Local Variables:
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ * vim:set expandtab shiftwidth=4:
+ */
@@ -44,11 +44,28 @@ static const char *OHM_VAR(internalif_timer_add,_SIGNATURE) =
 static const char *OHM_VAR(internalif_timer_del,_SIGNATURE) =
     "void(void *timer)";
 
+static const char *OHM_VAR(manager_statistics,_SIGNATURE) =
+    "void(uint32_t *requests, uint32_t *resolves)";
+
+static const char *OHM_VAR(ruleif_flush_cache,_SIGNATURE) =
+    "void(void)";
+
 
 int DBG_INIT, DBG_MGR, DBG_SET, DBG_DBUS, DBG_INTERNAL;
 int DBG_DRES, DBG_FS, DBG_QUE, DBG_TRANSACT, DBG_MEDIA, DBG_AUTH;
 int DBG_RULE;
 
+trcring_t resource_trace;
+
+static const char *trace_events[TRACE_MAX] = {
+    [TRACE_REQUEST] = "request",
+    [TRACE_GRANT]   = "grant-changed",
+    [TRACE_ADVICE]  = "advice-changed",
+    [TRACE_ENQUEUE] = "enqueue",
+    [TRACE_SEND]    = "send",
+    [TRACE_BLOCKED] = "blocked",
+};
+
 OHM_DEBUG_PLUGIN(resource,
     OHM_DEBUG_FLAG( "init"    , "init sequence"      , &DBG_INIT     ),
     OHM_DEBUG_FLAG( "manager" , "resource manager"   , &DBG_MGR      ),
@@ -89,11 +106,13 @@ static void plugin_init(OhmPlugin *plugin)
 
     ENTER;
 
+    trcring_init(&resource_trace, plugin, "resource", trace_events, TRACE_MAX);
+
     timestamp_init(plugin);
     dbusif_init(plugin);
     ruleif_init(plugin);
     internalif_init(plugin);
-    fsif_init(plugin);
+    fsif_init(plugin, &DBG_FS);
     dresif_init(plugin);
     manager_init(plugin);
     resource_set_init(plugin);
@@ -111,8 +130,13 @@ static void plugin_init(OhmPlugin *plugin)
 
 static void plugin_destroy(OhmPlugin *plugin)
 {
+    manager_exit(plugin);
     auth_exit(plugin);
+    dbusif_exit(plugin);
+    ruleif_exit(plugin);
+    resource_set_exit(plugin);
     fsif_exit(plugin);
+    trcring_exit(&resource_trace);
 }
 
 
@@ -140,9 +164,11 @@ OHM_PLUGIN_DBUS_SIGNALS(
 );
 
 
-OHM_PLUGIN_PROVIDES_METHODS(resource, 2,
-    OHM_EXPORT(internalif_timer_add, "restimer_add"),
-    OHM_EXPORT(internalif_timer_del, "restimer_del")
+OHM_PLUGIN_PROVIDES_METHODS(resource, 4,
+    OHM_EXPORT(internalif_timer_add, "restimer_add"    ),
+    OHM_EXPORT(internalif_timer_del, "restimer_del"    ),
+    OHM_EXPORT(manager_statistics  , "statistics"      ),
+    OHM_EXPORT(ruleif_flush_cache  , "rule_cache_flush")
 );
 
 
@@ -28,6 +28,8 @@ USA.
 #include <ohm/ohm-plugin-log.h>
 #include <ohm/ohm-plugin-debug.h>
 
+#include "trcring.h"
+
 #define EXPORT __attribute__ ((visibility ("default")))
 #define HIDE   __attribute__ ((visibility ("hidden")))
 
@@ -52,6 +54,19 @@ USA.
 extern int DBG_INIT, DBG_MGR, DBG_SET, DBG_DBUS, DBG_INTERNAL;
 extern int DBG_DRES, DBG_FS, DBG_QUE, DBG_TRANSACT, DBG_MEDIA, DBG_AUTH;
 
+/* events recorded in the trace ring; see trace_events in plugin.c */
+typedef enum {
+    TRACE_REQUEST = 0,          /* manager_id, reqno, txid */
+    TRACE_GRANT,                /* manager_id, granted, txid */
+    TRACE_ADVICE,               /* manager_id, advice, txid */
+    TRACE_ENQUEUE,              /* manager_id, field, value */
+    TRACE_SEND,                 /* manager_id, message type, value */
+    TRACE_BLOCKED,              /* manager_id, message type, value */
+    TRACE_MAX
+} trace_event_t;
+
+extern trcring_t resource_trace;
+
 
 void plugin_print_timestamp(const char *, const char *);
 
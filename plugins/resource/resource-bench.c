@@ -0,0 +1,649 @@
+/*************************************************************************
+Copyright (C) 2010 Nokia Corporation.
+
+These OHM Modules are free software; you can redistribute
+it and/or modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation
+version 2.1 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301
+USA.
+*************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <glib.h>
+#include <glib-object.h>
+#include <gmodule.h>
+#include <ohm/ohm-plugin.h>
+#include <ohm/ohm-plugin-log.h>
+#include <ohm/ohm-plugin-debug.h>
+
+#include <res-conn.h>
+
+/*
+ * Resource manager benchmark. A configurable number of simulated clients
+ * register a resource set each over the internal transport and then run
+ * a script of acquire, release and update storms against the resource
+ * manager. Every step of the script is sent as one burst, so with request
+ * batching enabled in the resource plugin the whole burst can be resolved
+ * together. For every request the time to the status reply and to the
+ * first grant notification is recorded and reported as p50/p99/max along
+ * with the throughput.
+ *
+ * Load the plugin into a locally started ohmd next to the resource plugin
+ * and run it from the console with 'resource-bench run [rounds]' or
+ * 'resource-bench script <step>[,<step>...] [rounds]'. The policy only
+ * needs to grant the benchmark class for the numbers to be meaningful.
+ * The number of clients and their class can be set with the 'clients'
+ * and 'class' plugin parameters.
+ *
+ * No ruleset, ini file or launch script comes with the benchmark. The
+ * resource_request target and the resource_class_request rule it drives
+ * live in the policy package of the device, so ohmd has to be started
+ * with that policy installed.
+ */
+
+#define BENCH_CLIENTS      100
+#define BENCH_MAX_CLIENTS  2048
+#define BENCH_ROUNDS       50
+#define BENCH_CLASS        "player"
+#define BENCH_SCRIPT       "acquire,release"
+#define BENCH_MAX_STEPS    16
+
+typedef enum {
+    bench_idle = 0,
+    bench_register,
+    bench_acquire,
+    bench_release,
+    bench_update,
+} bench_phase_t;
+
+typedef struct {
+    uint64_t       sent;        /* when the last request was sent */
+    int            waitgrant;   /* no grant arrived since then */
+    int            video;       /* video playback requested */
+} bench_client_t;
+
+typedef struct {
+    uint32_t      *usecs;
+    int            count;
+    int            dim;
+} bench_samples_t;
+
+OHM_IMPORTABLE(int   , add_command, (char *name, void (*handler)(char *)));
+OHM_IMPORTABLE(void *, timer_add  , (uint32_t delay,
+                                     resconn_timercb_t callback,
+                                     void *data));
+OHM_IMPORTABLE(void  , timer_del  , (void *timer));
+OHM_IMPORTABLE(void  , statistics , (uint32_t *requests, uint32_t *resolves));
+
+static resconn_t       *conn;
+static resset_t       **rsets;
+static bench_client_t  *clients;
+static int              nclient = BENCH_CLIENTS;
+static const char      *klass   = BENCH_CLASS;
+static uint32_t         reqno   = 1;
+static bench_phase_t    phase;
+static bench_phase_t    script[BENCH_MAX_STEPS];
+static int              nstep;
+static int              step;
+static int              pending;
+static int              rounds;
+static int              round_no;
+static uint32_t         sent;
+static uint32_t         grants;
+static uint32_t         failures;
+static bench_samples_t  status_latency;
+static bench_samples_t  grant_latency;
+static uint64_t         start;
+static uint32_t         start_requests;
+static uint32_t         start_resolves;
+
+static void console_init(void);
+static void console_command(char *);
+
+static void     bench_init(OhmPlugin *);
+static void     bench_exit(void);
+static int      bench_parse_script(const char *);
+static void     bench_start(int);
+static void     bench_burst(bench_phase_t);
+static gboolean bench_next(gpointer);
+static void     bench_report(void);
+
+static uint64_t bench_usecs(void);
+static void     samples_add(bench_samples_t *, uint32_t);
+static void     samples_reset(bench_samples_t *);
+static void     samples_report(const char *, bench_samples_t *);
+
+static void     client_connect(int);
+static void     client_status(resset_t *, resmsg_t *);
+static void     client_grant(resmsg_t *, resset_t *, void *);
+static void     client_advice(resmsg_t *, resset_t *, void *);
+static void     client_unregister(resmsg_t *, resset_t *, void *);
+static void     client_manager_up(resconn_t *);
+
+
+static void plugin_init(OhmPlugin *plugin)
+{
+    console_init();
+    bench_init(plugin);
+}
+
+static void plugin_destroy(OhmPlugin *plugin)
+{
+    (void)plugin;
+
+    bench_exit();
+}
+
+static void console_init(void)
+{
+    add_command("resource-bench", console_command);
+    OHM_INFO("resource-bench: registered console command handler");
+}
+
+static void console_command(char *cmd)
+{
+    char *args;
+    char *steps;
+    char *e;
+    int   n;
+
+    if (!strcmp(cmd, "help")) {
+        printf("resource-bench help          show this help\n");
+        printf("resource-bench run [rounds]  run acquire/release rounds "
+               "with %d clients\n", nclient);
+        printf("resource-bench script <step>[,<step>...] [rounds]\n"
+               "                             run rounds of the given steps; "
+               "a step is\n"
+               "                             acquire, release or update\n");
+        return;
+    }
+
+    if (!strncmp(cmd, "run", 3) && (cmd[3] == '\0' || cmd[3] == ' ')) {
+        bench_parse_script(BENCH_SCRIPT);
+        args = cmd + 3;
+    }
+    else if (!strncmp(cmd, "script ", 7)) {
+        steps = cmd + 7;
+
+        while (*steps == ' ')
+            steps++;
+
+        if ((args = strchr(steps, ' ')) != NULL)
+            *args++ = '\0';
+        else
+            args = steps + strlen(steps);
+
+        if (!bench_parse_script(steps)) {
+            printf("resource-bench: invalid script '%s'\n", steps);
+            return;
+        }
+    }
+    else {
+        printf("resource-bench: unknown command\n");
+        return;
+    }
+
+    while (*args == ' ')
+        args++;
+
+    if (*args == '\0')
+        n = BENCH_ROUNDS;
+    else {
+        n = strtol(args, &e, 10);
+
+        if (*e != '\0' || n <= 0) {
+            printf("resource-bench: invalid number of rounds '%s'\n", args);
+            return;
+        }
+    }
+
+    bench_start(n);
+}
+
+static void bench_init(OhmPlugin *plugin)
+{
+    const char *value;
+    char       *e;
+    int         i, n;
+
+    if ((value = ohm_plugin_get_param(plugin, "clients")) != NULL) {
+        n = strtol(value, &e, 10);
+
+        if (*e != '\0' || n <= 0 || n > BENCH_MAX_CLIENTS)
+            OHM_ERROR("resource-bench: invalid number of clients '%s'", value);
+        else
+            nclient = n;
+    }
+
+    if ((value = ohm_plugin_get_param(plugin, "class")) != NULL)
+        klass = value;
+
+    rsets   = calloc(nclient, sizeof(rsets[0]));
+    clients = calloc(nclient, sizeof(clients[0]));
+
+    if (rsets == NULL || clients == NULL) {
+        OHM_ERROR("resource-bench: can't allocate %d clients", nclient);
+        bench_exit();
+        return;
+    }
+
+    conn = resproto_init(RESPROTO_ROLE_CLIENT, RESPROTO_TRANSPORT_INTERNAL,
+                         client_manager_up, "ResourceBench",
+                         timer_add, timer_del);
+
+    if (conn == NULL) {
+        OHM_ERROR("resource-bench: can't initialize resource loopback "
+                  "protocol");
+        return;
+    }
+
+    resproto_set_handler(conn, RESMSG_UNREGISTER, client_unregister);
+    resproto_set_handler(conn, RESMSG_GRANT     , client_grant     );
+    resproto_set_handler(conn, RESMSG_ADVICE    , client_advice    );
+
+    phase   = bench_register;
+    pending = nclient;
+
+    for (i = 0;  i < nclient;  i++)
+        client_connect(i);
+
+    OHM_INFO("resource-bench: registering %d clients of class '%s'",
+             nclient, klass);
+}
+
+static void bench_exit(void)
+{
+    free(rsets);
+    free(clients);
+
+    rsets   = NULL;
+    clients = NULL;
+
+    samples_reset(&status_latency);
+    samples_reset(&grant_latency);
+}
+
+static int bench_parse_script(const char *str)
+{
+    const char *p;
+    int         len;
+
+    nstep = 0;
+
+    for (p = str;  *p;  p += len + (p[len] == ',')) {
+        len = strcspn(p, ",");
+
+        if (nstep >= BENCH_MAX_STEPS)
+            return FALSE;
+
+        if (len == 7 && !strncmp(p, "acquire", 7))
+            script[nstep++] = bench_acquire;
+        else if (len == 7 && !strncmp(p, "release", 7))
+            script[nstep++] = bench_release;
+        else if (len == 6 && !strncmp(p, "update", 6))
+            script[nstep++] = bench_update;
+        else
+            return FALSE;
+    }
+
+    return nstep > 0;
+}
+
+static void bench_start(int n)
+{
+    int i;
+
+    if (conn == NULL || phase != bench_idle) {
+        printf("resource-bench: %s\n", conn == NULL ? "not initialized" :
+               (phase == bench_register ? "clients are still registering" :
+                "a run is already in progress"));
+        return;
+    }
+
+    rounds   = n;
+    round_no = 0;
+    step     = 0;
+    sent     = 0;
+    grants   = 0;
+    failures = 0;
+
+    status_latency.count = 0;
+    grant_latency.count  = 0;
+
+    for (i = 0;  i < nclient;  i++)
+        clients[i].waitgrant = FALSE;
+
+    if (statistics != NULL)
+        statistics(&start_requests, &start_resolves);
+
+    start = bench_usecs();
+
+    bench_burst(script[0]);
+}
+
+static void bench_burst(bench_phase_t what)
+{
+    bench_client_t *client;
+    resmsg_t        msg;
+    uint32_t        video;
+    int             nsent;
+    int             i;
+
+    phase   = what;
+    pending = nclient;
+    nsent   = 0;
+
+    for (i = 0;  i < nclient;  i++) {
+        client = clients + i;
+
+        memset(&msg, 0, sizeof(msg));
+
+        if (what == bench_update) {
+            client->video = !client->video;
+            video = client->video ? RESMSG_VIDEO_PLAYBACK : 0;
+
+            msg.record.type       = RESMSG_UPDATE;
+            msg.record.id         = i + 1;
+            msg.record.reqno      = reqno++;
+            msg.record.rset.all   = RESMSG_AUDIO_PLAYBACK | video;
+            msg.record.rset.opt   = video;
+            msg.record.klass      = (char *)klass;
+        }
+        else {
+            msg.possess.type  = (what == bench_acquire) ?
+                                RESMSG_ACQUIRE : RESMSG_RELEASE;
+            msg.possess.id    = i + 1;
+            msg.possess.reqno = reqno++;
+        }
+
+        client->sent      = bench_usecs();
+        client->waitgrant = TRUE;
+
+        if (!resproto_send_message(rsets[i], &msg, client_status)) {
+            client->waitgrant = FALSE;
+            failures++;
+            pending--;
+        }
+        else {
+            sent++;
+            nsent++;
+        }
+    }
+
+    /* no status is coming to move the run forward */
+    if (pending <= 0) {
+        if (nsent > 0)
+            g_idle_add_full(G_PRIORITY_LOW, bench_next, NULL, NULL);
+        else {
+            printf("resource-bench: can't send any requests, "
+                   "stopping the run\n");
+            phase = bench_idle;
+            bench_report();
+        }
+    }
+}
+
+/*
+ * Runs at a lower priority than the batch flush of the resource plugin,
+ * so the grants of the previous burst are out before the next one starts.
+ */
+static gboolean bench_next(gpointer data)
+{
+    (void)data;
+
+    if (++step >= nstep) {
+        step = 0;
+
+        if (++round_no >= rounds) {
+            phase = bench_idle;
+            bench_report();
+            return FALSE;
+        }
+    }
+
+    bench_burst(script[step]);
+
+    return FALSE;
+}
+
+static void bench_report(void)
+{
+    uint32_t requests = 0;
+    uint32_t resolves = 0;
+    double   elapsed;
+
+    elapsed = (bench_usecs() - start) / 1000000.0;
+
+    if (statistics != NULL) {
+        statistics(&requests, &resolves);
+        requests -= start_requests;
+        resolves -= start_resolves;
+    }
+
+    printf("resource-bench: %d clients, %d rounds of %d steps in %.3f sec\n",
+           nclient, rounds, nstep, elapsed);
+    printf("resource-bench: %u sent, %u requests, %u resolutions, "
+           "%u grants, %u failures\n",
+           sent, requests, resolves, grants, failures);
+
+    if (elapsed > 0) {
+        printf("resource-bench: %.0f requests/sec, %.0f resolutions/sec\n",
+               sent / elapsed, resolves / elapsed);
+    }
+
+    samples_report("status", &status_latency);
+    samples_report("grant" , &grant_latency);
+}
+
+static uint64_t bench_usecs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void samples_add(bench_samples_t *s, uint32_t usecs)
+{
+    uint32_t *usecs_new;
+    int       dim;
+
+    if (s->count >= s->dim) {
+        dim = s->dim ? 2 * s->dim : 1024;
+
+        if ((usecs_new = realloc(s->usecs, dim * sizeof(uint32_t))) == NULL)
+            return;
+
+        s->usecs = usecs_new;
+        s->dim   = dim;
+    }
+
+    s->usecs[s->count++] = usecs;
+}
+
+static void samples_reset(bench_samples_t *s)
+{
+    free(s->usecs);
+
+    s->usecs = NULL;
+    s->count = 0;
+    s->dim   = 0;
+}
+
+static int samples_compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void samples_report(const char *what, bench_samples_t *s)
+{
+    uint32_t p50, p99, max;
+
+    if (s->count == 0) {
+        printf("resource-bench: %-6s latency: no samples\n", what);
+        return;
+    }
+
+    qsort(s->usecs, s->count, sizeof(uint32_t), samples_compare);
+
+    p50 = s->usecs[(s->count - 1) * 50 / 100];
+    p99 = s->usecs[(s->count - 1) * 99 / 100];
+    max = s->usecs[s->count - 1];
+
+    printf("resource-bench: %-6s latency: p50 %u us, p99 %u us, max %u us "
+           "(%d samples)\n", what, p50, p99, max, s->count);
+}
+
+static void client_connect(int i)
+{
+    resmsg_t msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.record.type       = RESMSG_REGISTER;
+    msg.record.id         = i + 1;
+    msg.record.reqno      = reqno++;
+    msg.record.rset.all   = RESMSG_AUDIO_PLAYBACK;
+    msg.record.rset.opt   = 0;
+    msg.record.rset.share = 0;
+    msg.record.rset.mask  = 0;
+    msg.record.klass      = (char *)klass;
+    msg.record.mode       = 0;
+
+    clients[i].video = FALSE;
+
+    rsets[i] = resconn_connect(conn, &msg, client_status);
+}
+
+static void client_status(resset_t *rset, resmsg_t *msg)
+{
+    bench_client_t *client;
+
+    if (msg->type != RESMSG_STATUS || msg->status.errcod != 0)
+        failures++;
+
+    if (phase != bench_register && rset != NULL &&
+        rset->id > 0 && rset->id <= (uint32_t)nclient)
+    {
+        client = clients + (rset->id - 1);
+        samples_add(&status_latency, bench_usecs() - client->sent);
+    }
+
+    if (--pending > 0)
+        return;
+
+    if (phase == bench_register) {
+        phase = bench_idle;
+        OHM_INFO("resource-bench: %d clients registered%s", nclient,
+                 failures ? " with failures" : "");
+        failures = 0;
+    }
+    else if (phase != bench_idle)
+        g_idle_add_full(G_PRIORITY_LOW, bench_next, NULL, NULL);
+}
+
+static void client_grant(resmsg_t *msg, resset_t *rset, void *data)
+{
+    bench_client_t *client;
+    uint32_t        id = msg->notify.id;
+
+    (void)rset;
+    (void)data;
+
+    grants++;
+
+    if (id > 0 && id <= (uint32_t)nclient) {
+        client = clients + (id - 1);
+
+        if (client->waitgrant) {
+            client->waitgrant = FALSE;
+            samples_add(&grant_latency, bench_usecs() - client->sent);
+        }
+    }
+}
+
+static void client_advice(resmsg_t *msg, resset_t *rset, void *data)
+{
+    (void)msg;
+    (void)rset;
+    (void)data;
+}
+
+static void client_unregister(resmsg_t *msg, resset_t *rset, void *data)
+{
+    resproto_reply_message(rset, msg, data, 0, "OK");
+}
+
+static void client_manager_up(resconn_t *rc)
+{
+    int i;
+
+    (void)rc;
+
+    if (clients == NULL)
+        return;
+
+    phase   = bench_register;
+    pending = nclient;
+
+    for (i = 0;  i < nclient;  i++)
+        client_connect(i);
+}
+
+
+
+OHM_PLUGIN_DESCRIPTION(
+    "OHM resource manager benchmark",   /* description */
+    "0.0.1",                            /* version */
+    "janos.f.kovacs@nokia.com",         /* author */
+    OHM_LICENSE_LGPL,                   /* license */
+    plugin_init,                        /* initalize */
+    plugin_destroy,                     /* destroy */
+    NULL                                /* notify */
+);
+
+OHM_PLUGIN_PROVIDES(
+    "maemo.resource_bench"
+);
+
+OHM_PLUGIN_REQUIRES(
+    "resource"
+);
+
+OHM_PLUGIN_REQUIRES_METHODS(resource_bench, 4,
+    OHM_IMPORT("dres.add_command"     , add_command),
+    OHM_IMPORT("resource.restimer_add", timer_add  ),
+    OHM_IMPORT("resource.restimer_del", timer_del  ),
+    OHM_IMPORT("resource.statistics"  , statistics )
+);
+
+
+
+/*
+ * Local Variables:
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ * vim:set expandtab shiftwidth=4:
+ */
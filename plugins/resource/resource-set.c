@@ -31,6 +31,7 @@ USA.
 #include "resource-spec.h"
 #include "fsif.h"
 #include "transaction.h"
+#include "mempool.h"
 
 #define HASH_BITS      8
 #define HASH_DIM       (1 << HASH_BITS)
@@ -43,9 +44,24 @@ USA.
 
 #define SELIST_DIM  2
 
+#define POOL_MAX_SETS    64
+#define POOL_MAX_QUEUED  256
+
 static resource_set_t  *hash_table[HASH_DIM];
 
+/* the request strings are interned, so a set is just one block */
+static mempool_t set_pool =
+    MEMPOOL_INITIALIZER("resource set", resource_set_t, POOL_MAX_SETS);
+static mempool_t queue_pool =
+    MEMPOOL_INITIALIZER("queue entry", resource_set_queue_t, POOL_MAX_QUEUED);
+
+static int       coalesce_enabled;
+static GSList   *coalesce_list;     /* manager_id's with changes to send */
+static guint     coalesce_srcid;
+static uint32_t  coalesce_dropped;  /* superseded changes not sent */
+
 static gboolean idle_task(gpointer);
+static gboolean coalesce_flush(gpointer);
 
 static void enqueue_send_request(resource_set_t *, resource_set_field_id_t,
                                  uint32_t, uint32_t);
@@ -72,13 +88,51 @@ static resource_set_t *find_in_hash_table(uint32_t);
 
 void resource_set_init(OhmPlugin *plugin)
 {
-    (void)plugin;
+    const char *coalesce_str;
 
     ENTER;
 
+    fsif_add_index(FACTSTORE_RESOURCE_SET, "manager_id");
+
+    coalesce_str = ohm_plugin_get_param(plugin, "coalesce-changes");
+
+    if (coalesce_str != NULL) {
+        if (!strcmp(coalesce_str, "yes"))
+            coalesce_enabled = TRUE;
+        else if (strcmp(coalesce_str, "no")) {
+            OHM_ERROR("resource: invalid value '%s' for 'coalesce-changes'",
+                      coalesce_str);
+        }
+    }
+
+    OHM_INFO("resource: grant/advice changes are %s",
+             coalesce_enabled ? "coalesced" : "sent one by one");
+
     LEAVE;
 }
 
+void resource_set_exit(OhmPlugin *plugin)
+{
+    (void)plugin;
+
+    if (coalesce_srcid) {
+        g_source_remove(coalesce_srcid);
+        coalesce_srcid = 0;
+    }
+
+    g_slist_free(coalesce_list);
+    coalesce_list = NULL;
+
+    if (coalesce_enabled)
+        OHM_INFO("resource: %u superseded changes were not sent",
+                 coalesce_dropped);
+
+    /* give the cached objects back to malloc */
+    mempool_flush(&queue_pool);
+    mempool_flush(&set_pool);
+    resource_spec_exit(plugin);
+}
+
 resource_set_t *resource_set_create(pid_t client_pid, resset_t *resset)
 {
     static uint32_t  manager_id;
@@ -91,12 +145,11 @@ resource_set_t *resource_set_create(pid_t client_pid, resset_t *resset)
     }
     else {
 
-        if ((rs = malloc(sizeof(resource_set_t))) != NULL) {
-            memset(rs, 0, sizeof(resource_set_t));
+        if ((rs = mempool_alloc(&set_pool)) != NULL) {
             rs->client_pid = client_pid;
             rs->manager_id = manager_id++;
             rs->resset     = resset;
-            rs->request    = strdup("release");
+            rs->request    = g_intern_string("release");
 
             resset->userdata = rs;
             add_to_hash_table(rs);
@@ -147,13 +200,14 @@ void resource_set_destroy(resset_t *resset)
             delete_factstore_entry(rs);
             delete_from_hash_table(rs);
 
-            free(rs->request);
-            free(rs);
+            mempool_free(&set_pool, rs);
 
             resset->userdata=NULL;
 
             OHM_DEBUG(DBG_SET, "destroyed resource set %s/%u (manager id %u)",
                       resset->peer, resset->id, mgrid);
+
+            resource_set_dump_statistics(DBG_SET);
         }
     }
 }
@@ -267,8 +321,25 @@ void resource_set_send_queued_changes(uint32_t manager_id, uint32_t txid)
     resource_set_t *rs;
     
     if ((rs = find_in_hash_table(manager_id)) != NULL) {
-        dequeue_and_send(rs, resource_set_granted, txid);
-        dequeue_and_send(rs, resource_set_advice , txid);
+        if (!coalesce_enabled) {
+            dequeue_and_send(rs, resource_set_granted, txid);
+            dequeue_and_send(rs, resource_set_advice , txid);
+        }
+        else {
+            /*
+             * transactions complete in txid order, so it is enough to
+             * remember the latest one and send up to that in one go
+             */
+            if (rs->sendtxid == NO_TRANSACTION) {
+                coalesce_list = g_slist_prepend(coalesce_list,
+                                                GUINT_TO_POINTER(manager_id));
+            }
+
+            rs->sendtxid = txid;
+
+            if (!coalesce_srcid)
+                coalesce_srcid = g_idle_add(coalesce_flush, NULL);
+        }
     }
 }
 
@@ -331,6 +402,11 @@ resource_set_t *resource_set_find(fsif_entry_t *entry)
     return rs;
 }
 
+resource_set_t *resource_set_find_by_id(uint32_t manager_id)
+{
+    return find_in_hash_table(manager_id);
+}
+
 void resource_set_dump_message(resmsg_t *msg,resset_t *resset,const char *dir)
 {
     resconn_t *rconn = resset->resconn;
@@ -352,6 +428,20 @@ void resource_set_dump_message(resmsg_t *msg,resset_t *resset,const char *dir)
     }
 }
 
+void resource_set_dump_statistics(int debug)
+{
+    if (TRC_ENABLED(debug)) {
+        mempool_dump_statistics(&set_pool, debug);
+        mempool_dump_statistics(&queue_pool, debug);
+        resource_spec_dump_statistics(debug);
+
+        if (coalesce_enabled) {
+            OHM_DEBUG(debug, "%u superseded grant/advice changes were "
+                      "not sent", coalesce_dropped);
+        }
+    }
+}
+
 
 /*!
  * @}
@@ -432,19 +522,20 @@ static void enqueue_send_request(resource_set_t          *rs,
     default:                                                           return;
     }
 
-    if ((qentry = malloc(sizeof(resource_set_queue_t))) == NULL)
+    if ((qentry = mempool_alloc(&queue_pool)) == NULL)
         OHM_ERROR("resource: [%s] memory allocation failure", __FUNCTION__);
     else {
         qhead = &value->queue;
 
-        memset(qentry, 0, sizeof(resource_set_queue_t));
         qentry->txid  = txid;
         qentry->reqno = reqno;
         qentry->value = value->factstore;
 
         queue_push_tail(qhead, qentry);
 
-        OHM_DEBUG(DBG_SET, "%s/%u (manager_id %u) enqued %s value %s",
+        TRC_RECORD(&resource_trace, TRACE_ENQUEUE,
+                   rs->manager_id, what, qentry->value);
+        TRC_DEBUG(DBG_SET, "%s/%u (manager_id %u) enqued %s value %s",
                   resset->peer, resset->id, rs->manager_id, type,
                   resmsg_res_str(qentry->value, buf, sizeof(buf)));
     }
@@ -479,53 +570,70 @@ static void dequeue_and_send(resource_set_t          *rs,
 
     /*
      * we assume that the queue contains strictly monoton increasing txid's
-     * and this function is called with strictly monoton txid's
+     * and this function is called with strictly monoton txid's. When
+     * changes are coalesced, txid is the latest of the completed
+     * transactions, so entries of earlier transactions are expected here
+     * and are dropped if a later value follows them within this batch.
+     * Replies to requests (ie. entries with reqno) are always sent.
      */
-    while ((qentry = queue_pop_head(qhead)) != NULL) {
+    while ((qentry = qhead->head) != NULL) {
         if (qentry->txid > txid)
             return;             /* nothing to send */
 
-        if (qentry->txid == txid) {
-            if (qentry->reqno || value->client != qentry->value) {
-                if (block && type == RESMSG_GRANT) {
-                    OHM_DEBUG(DBG_SET, "%s/%u (manager_id %u) dequed but not "
+        queue_pop_head(qhead);
+
+        if (qentry->txid != txid && !coalesce_enabled) {
+            OHM_ERROR("resource: deleting out-of-order '%s' transaction "
+                      "%u for %s/%u (manager id %u: expected transaction %u)",
+                      resmsg_type_str(type), qentry->txid,
+                      resset->peer, resset->id, rs->manager_id, txid);
+        }
+        else if (coalesce_enabled && !qentry->reqno &&
+                 qhead->head != NULL && qhead->head->txid <= txid)
+        {
+            coalesce_dropped++;
+
+            TRC_DEBUG(DBG_SET, "%s/%u (manager_id %u) dropped superseded "
+                      "%s value %s", resset->peer, resset->id,
+                      rs->manager_id, resmsg_type_str(type),
+                      resmsg_res_str(qentry->value, buf, sizeof(buf)));
+        }
+        else if (qentry->reqno || value->client != qentry->value) {
+            if (block && type == RESMSG_GRANT) {
+                TRC_RECORD(&resource_trace, TRACE_BLOCKED,
+                           rs->manager_id, type, qentry->value);
+                TRC_DEBUG(DBG_SET, "%s/%u (manager_id %u) dequed but not "
+                          "sent %s value %s", resset->peer, resset->id,
+                          rs->manager_id, resmsg_type_str(type),
+                          resmsg_res_str(value->client,buf,sizeof(buf)));
+            }
+            else {
+                memset(&msg, 0, sizeof(msg));
+                msg.notify.type  = type;
+                msg.notify.id    = resset->id;
+                msg.notify.reqno = qentry->reqno;
+                msg.notify.resrc = qentry->value;
+
+                if (resproto_send_message(resset, &msg, NULL)) {
+                    value->client = qentry->value;
+
+                    TRC_RECORD(&resource_trace, TRACE_SEND,
+                               rs->manager_id, type, value->client);
+                    TRC_DEBUG(DBG_SET, "%s/%u (manager_id %u) dequed and "
                               "sent %s value %s", resset->peer, resset->id,
                               rs->manager_id, resmsg_type_str(type),
                               resmsg_res_str(value->client,buf,sizeof(buf)));
                 }
                 else {
-                    memset(&msg, 0, sizeof(msg));
-                    msg.notify.type  = type;
-                    msg.notify.id    = resset->id;
-                    msg.notify.reqno = qentry->reqno;
-                    msg.notify.resrc = qentry->value;
-                
-                    if (resproto_send_message(resset, &msg, NULL)) {
-                        value->client = qentry->value;
-
-                        OHM_DEBUG(DBG_SET, "%s/%u (manager_id %u) dequed and "
-                                  "sent %s value %s", resset->peer, resset->id,
-                                  rs->manager_id, resmsg_type_str(type),
-                                  resmsg_res_str(value->client,buf,sizeof(buf))
-                                 );
-                    }
-                    else {
-                        OHM_ERROR("resource: failed to send %s message to "
-                                  "%s/%u (manager id %u)",
-                                  resmsg_type_str(type), resset->peer,
-                                  resset->id, rs->manager_id);
-                    }
-                } /* if !block */
-            }
-        }
-        else {
-            OHM_ERROR("resource: deleting out-of-order '%s' transaction "
-                      "%u for %s/%u (manager id %u: expected transaction %u)",
-                      resmsg_type_str(type), qentry->txid,
-                      resset->peer, resset->id, rs->manager_id, txid);
+                    OHM_ERROR("resource: failed to send %s message to "
+                              "%s/%u (manager id %u)",
+                              resmsg_type_str(type), resset->peer,
+                              resset->id, rs->manager_id);
+                }
+            } /* if !block */
         }
 
-        free(qentry);
+        mempool_free(&queue_pool, qentry);
     } /* while */
 }
 
@@ -541,7 +649,36 @@ static void destroy_queue(resource_set_t *rs, resource_set_field_id_t what)
     }
 
     while ((qentry = queue_pop_head(qhead)) != NULL)
-        free(qentry);
+        mempool_free(&queue_pool, qentry);
+}
+
+static gboolean coalesce_flush(gpointer data)
+{
+    GSList         *list;
+    GSList         *l;
+    resource_set_t *rs;
+    uint32_t        txid;
+
+    (void)data;
+
+    list = g_slist_reverse(coalesce_list);
+
+    coalesce_list  = NULL;
+    coalesce_srcid = 0;
+
+    for (l = list;  l != NULL;  l = l->next) {
+        if ((rs = find_in_hash_table(GPOINTER_TO_UINT(l->data))) != NULL) {
+            txid = rs->sendtxid;
+            rs->sendtxid = NO_TRANSACTION;
+
+            dequeue_and_send(rs, resource_set_granted, txid);
+            dequeue_and_send(rs, resource_set_advice , txid);
+        }
+    }
+
+    g_slist_free(list);
+
+    return FALSE;
 }
 
 
@@ -568,7 +705,7 @@ static int add_factstore_entry(resource_set_t *rs)
         INTEGER_FIELD ("mask"       , resset->flags.mask   ),
         INTEGER_FIELD ("granted"    , rs->granted.factstore),
         INTEGER_FIELD ("advice"     , rs->advice.factstore ),
-        STRING_FIELD  ("request"    , rs->request          ),
+        STRING_FIELD  ("request"    , (char *)rs->request  ),
         INTEGER_FIELD ("block"      , rs->block            ),
         INTEGER_FIELD ("reqno"      , 0                    ),
         STRING_FIELD  ("audiogr"    , audiogr              ),
@@ -632,7 +769,7 @@ static int update_factstore_request(resource_set_t *rs)
         INVALID_FIELD
     };
     fsif_field_t  fldlist[] = {
-        STRING_FIELD  ("request", rs->request),
+        STRING_FIELD  ("request", (char *)rs->request),
         INTEGER_FIELD ("reqno"  , reqno++    ),
         INVALID_FIELD
     };
@@ -74,12 +74,13 @@ typedef struct resource_set_s {
     uint32_t                 manager_id; /* resource-set generated unique ID */
     resset_t                *resset;     /* link to libresource */
     union resource_spec_u   *specs;      /* resource specifications if any */
-    char                    *request;    /* either 'acquire', 'release'  */
+    const char              *request;    /* either 'acquire', 'release'  */
     int32_t                  block;      /* manager forced release */
     resource_set_output_t    granted;    /* granted resources of this set */
     resource_set_output_t    advice;     /* advice on this resource set */
     resource_set_qhead_t     qhead;      /* queue for delayed responses */
     uint32_t                 reqno;
+    uint32_t                 sendtxid;   /* completed, not yet sent tx */
     struct {
         uint32_t            srcid;
         resource_set_task_t task;
@@ -96,6 +97,7 @@ typedef enum {
 
 
 void resource_set_init(OhmPlugin *);
+void resource_set_exit(OhmPlugin *);
 
 resource_set_t *resource_set_create(pid_t, resset_t *);
 void resource_set_destroy(resset_t *);
@@ -107,8 +109,10 @@ void resource_set_send_queued_changes(uint32_t, uint32_t);
 void resource_set_send_release_request(resource_set_t *);
 int  resource_set_add_idle_task(resource_set_t *, resource_set_task_t);
 resource_set_t *resource_set_find(struct _OhmFact *);
+resource_set_t *resource_set_find_by_id(uint32_t);
 
 void resource_set_dump_message(resmsg_t *, resset_t *, const char *);
+void resource_set_dump_statistics(int);
 
 #endif	/* __OHM_RESOURCE_SET_H__ */
 
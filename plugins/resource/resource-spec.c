@@ -30,12 +30,17 @@ USA.
 #include "plugin.h"
 #include "resource-spec.h"
 #include "fsif.h"
+#include "mempool.h"
 
 
 #define INTEGER_FIELD(n,v) { fldtype_integer, n, .value.integer = v }
 #define STRING_FIELD(n,v)  { fldtype_string , n, .value.string  = v ? v : "" }
 #define INVALID_FIELD      { fldtype_invalid, NULL, .value.string = NULL }
 
+#define POOL_MAX_SPECS     64
+
+static mempool_t spec_pool =
+    MEMPOOL_INITIALIZER("resource spec", resource_spec_t, POOL_MAX_SPECS);
 
 static int  create_audio_stream_spec(resource_audio_stream_t *,
                                      resource_set_t *, va_list);
@@ -57,9 +62,19 @@ void resource_spec_init(OhmPlugin *plugin)
 
     ENTER;
 
+    fsif_add_index(FACTSTORE_AUDIO_STREAM, "pid");
+    fsif_add_index(FACTSTORE_VIDEO_STREAM, "videopid");
+
     LEAVE;
 }
 
+void resource_spec_exit(OhmPlugin *plugin)
+{
+    (void)plugin;
+
+    mempool_flush(&spec_pool);
+}
+
 resource_spec_t *resource_spec_create(resource_set_t       *rs,
                                       resource_spec_type_t  type,
                                       va_list               args)
@@ -67,9 +82,7 @@ resource_spec_t *resource_spec_create(resource_set_t       *rs,
     resource_spec_t *spec = NULL;
     int              success;
 
-    if (rs != NULL && (spec = malloc(sizeof(resource_spec_t))) != NULL) {
-        memset(spec, 0, sizeof(resource_spec_t));
-
+    if (rs != NULL && (spec = mempool_alloc(&spec_pool)) != NULL) {
         switch (type) {
 
         case resource_audio:
@@ -86,7 +99,7 @@ resource_spec_t *resource_spec_create(resource_set_t       *rs,
         }
 
         if (!success) {
-            free(spec);
+            mempool_free(&spec_pool, spec);
             spec = NULL;
         }
     }
@@ -103,7 +116,12 @@ void resource_spec_destroy(resource_spec_t *spec)
     default:               /* do nothing */                           break;
     }
 
-    free(spec);
+    mempool_free(&spec_pool, spec);
+}
+
+void resource_spec_dump_statistics(int debug)
+{
+    mempool_dump_statistics(&spec_pool, debug);
 }
 
 
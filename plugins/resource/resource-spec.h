@@ -67,10 +67,12 @@ typedef union resource_spec_u {
 } resource_spec_t;
 
 void             resource_spec_init(OhmPlugin *);
+void             resource_spec_exit(OhmPlugin *);
 
 resource_spec_t *resource_spec_create(resource_set_t *, resource_spec_type_t,
                                       va_list);
 void             resource_spec_destroy(resource_spec_t *);
+void             resource_spec_dump_statistics(int);
 int              resource_spec_update(resource_spec_t *, resource_set_t *,
                                       resource_spec_type_t, va_list);
                                      
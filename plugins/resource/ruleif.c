@@ -24,6 +24,7 @@ USA.
 #include <string.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <time.h>
 
 #include "plugin.h"
 #include "ruleif.h"
@@ -44,6 +45,28 @@ typedef struct {
     int  *rule;
 } rule_def_t;
 
+typedef struct {
+    char       *name;
+    int         type;
+    union {
+        char   *string;
+        int     integer;
+        double  floating;
+    }           value;
+} rule_field_t;
+
+/*
+ * the outcome of a resource_class_request evaluation; 'valid' is set if
+ * the rule succeeded with exactly one result
+ */
+typedef struct {
+    int           valid;
+    int           nfield;
+    rule_field_t *fields;
+} rule_result_t;
+
+#define CACHE_MAX  256          /* flush the cache when it gets this big */
+
 
 OHM_IMPORTABLE(void, rules_free_result, (void *retval));
 OHM_IMPORTABLE(void, rules_dump_result, (void *retval));
@@ -53,7 +76,17 @@ OHM_IMPORTABLE(int , rule_eval        , (int rule, void *retval,
 
 static int resource_class_req = -1;
 
-static int copy_value(char *, int, void *, char **);
+static int         cache_enabled = FALSE;
+static GHashTable *cache;
+static uint32_t    cache_hits;
+static uint32_t    cache_misses;
+static uint64_t    eval_usecs;  /* time spent in rule_eval() on misses */
+
+static rule_result_t *evaluate_request(const char *, int, int);
+static rule_result_t *parse_result(char ***);
+static void free_result(void *);
+static int copy_value(char *, int, void *, rule_result_t *);
+static uint64_t usecs_now(void);
 
 static int lookup_rules(void)
 {
@@ -104,6 +137,9 @@ static int lookup_rules(void)
     if (n == DIM(ruldefs))
         OHM_INFO("resource: found all rules");
 
+    /* the rules might have changed, whatever we cached is stale */
+    ruleif_flush_cache();
+
     return success;
 }
 
@@ -116,87 +152,281 @@ static int lookup_rules(void)
 
 void ruleif_init(OhmPlugin *plugin)
 {
-    (void)plugin;
+    const char *cache_str;
 
     ENTER;
 
+    if ((cache_str = ohm_plugin_get_param(plugin, "rule-cache")) != NULL) {
+        if (!strcmp(cache_str, "yes"))
+            cache_enabled = TRUE;
+        else if (!strcmp(cache_str, "no"))
+            cache_enabled = FALSE;
+        else {
+            OHM_ERROR("resource: invalid value '%s' for rule-cache",
+                      cache_str);
+        }
+    }
+
+    OHM_INFO("resource: rule evaluation cache is %s",
+             cache_enabled ? "enabled" : "disabled");
+
     lookup_rules();
 
     LEAVE;
 }
 
+void ruleif_exit(OhmPlugin *plugin)
+{
+    uint32_t hits, misses, saved;
+
+    (void)plugin;
+
+    if (cache_enabled) {
+        ruleif_cache_statistics(&hits, &misses, &saved);
+
+        OHM_INFO("resource: rule cache %u hits, %u misses, ~%u usecs of rule "
+                 "evaluation saved", hits, misses, saved);
+    }
+
+    if (cache != NULL) {
+        g_hash_table_destroy(cache);
+        cache = NULL;
+    }
+}
+
 int ruleif_valid_resource_request(const char *class, int mandatory, int optional, ...)
 {
-    va_list  ap;
-    char    *argv[16];
-    char  ***retval;
-    char    *name;
-    int      type;
-    void    *value;
-    int      i;
-    int      status;
-    int      success = FALSE;
+    va_list        ap;
+    rule_result_t *result;
+    char           key[256];
+    char          *name;
+    int            type;
+    void          *value;
+    int            cached  = FALSE;
+    int            success = FALSE;
 
     if (resource_class_req < 0)
         lookup_rules();
 
-    if (resource_class_req >= 0) {
-        retval = NULL;
+    if (resource_class_req < 0)
+        result = NULL;
+    else if (!cache_enabled)
+        result = evaluate_request(class, mandatory, optional);
+    else {
+        snprintf(key, sizeof(key), "%s/%d/%d",
+                 class ? class : "", mandatory, optional);
+
+        if (cache == NULL) {
+            cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                          g_free, free_result);
+        }
+
+        if ((result = g_hash_table_lookup(cache, key)) != NULL) {
+            cache_hits++;
+            cached = TRUE;
+            OHM_DEBUG(DBG_RULE, "rule cache hit for %s", key);
+        }
+        else if ((result = evaluate_request(class,mandatory,optional)) &&
+                 result->valid)
+        {
+            /* failures might be transient, only successes are cached */
+            if (g_hash_table_size(cache) >= CACHE_MAX)
+                g_hash_table_remove_all(cache);
+
+            g_hash_table_insert(cache, g_strdup(key), result);
+            cached = TRUE;
+        }
+    }
+
+    if (result != NULL && result->valid) {
+        success = TRUE;
+
+        va_start(ap, optional);
+
+        while ((name = va_arg(ap, char *)) != NULL) {
+            type  = va_arg(ap, int);
+            value = va_arg(ap, void *);
+
+            if (!copy_value(name, type, value, result)) {
+                success = FALSE;
+                break;
+            }
+        }
+
+        va_end(ap);
+    }
+
+    if (!cached)
+        free_result(result);
+
+    OHM_DEBUG(DBG_RULE, "%s", success ? "succeeded" : "failed");
+
+    return success;
+}
+
+void ruleif_flush_cache(void)
+{
+    if (cache != NULL && g_hash_table_size(cache) > 0) {
+        OHM_DEBUG(DBG_RULE, "flushing %u cached rule results",
+                  g_hash_table_size(cache));
+        g_hash_table_remove_all(cache);
+    }
+}
+
+void ruleif_cache_statistics(uint32_t *hits, uint32_t *misses, uint32_t *saved)
+{
+    if (hits != NULL)
+        *hits = cache_hits;
+
+    if (misses != NULL)
+        *misses = cache_misses;
+
+    /* every hit saves an average evaluation */
+    if (saved != NULL)
+        *saved = cache_misses ? eval_usecs * cache_hits / cache_misses : 0;
+}
+
+
+/*!
+ * @}
+ */
+
+static rule_result_t *evaluate_request(const char *class,
+                                       int         mandatory,
+                                       int         optional)
+{
+    char           *argv[16];
+    char         ***retval;
+    rule_result_t  *result;
+    uint64_t        start;
+    int             i;
+    int             status;
+
+    retval = NULL;
+
+    argv[i=0] = (char *)'s';
+    argv[++i] = (char *)class;
 
-        argv[i=0] = (char *)'s';
-        argv[++i] = (char *)class;
+    argv[++i] = (char *)'i';
+    argv[++i] = (char *)mandatory;
 
-        argv[++i] = (char *)'i';
-        argv[++i] = (char *)mandatory;
+    argv[++i] = (char *)'i';
+    argv[++i] = (char *)optional;
 
-        argv[++i] = (char *)'i';
-        argv[++i] = (char *)optional;
+    start  = usecs_now();
+    status = rule_eval(resource_class_req, &retval, (void **)argv, (i+1)/2);
 
-        status = rule_eval(resource_class_req, &retval, (void **)argv, (i+1)/2);
+    cache_misses++;
+    eval_usecs += usecs_now() - start;
 
-        OHM_DEBUG(DBG_RULE, "rule_eval returned %d (retval %p)", status, retval);
+    OHM_DEBUG(DBG_RULE, "rule_eval returned %d (retval %p)", status, retval);
 
-        if (status <= 0 && retval) {
+    if (status <= 0 && retval) {
+        rules_dump_result(retval);
+        result = parse_result(NULL);
+    }
+    else {
+        if (OHM_LOGGED(INFO) && retval)
             rules_dump_result(retval);
-        } else {
-            if (OHM_LOGGED(INFO) && retval)
-                rules_dump_result(retval);
 
-            if (retval && retval[0] != NULL && retval[1] == NULL) {
-                success = TRUE;
+        if (retval && retval[0] != NULL && retval[1] == NULL)
+            result = parse_result(retval);
+        else
+            result = parse_result(NULL);
+    }
+
+    if (retval)
+        rules_free_result(retval);
+
+    return result;
+}
+
+/*
+ * Copy the fields of a single result entry. The entry is the name of the
+ * result ("name", <name>, <dummy>) followed by (name, type, value) triplets.
+ */
+static rule_result_t *parse_result(char ***retval)
+{
+    rule_result_t *result;
+    rule_field_t  *fld;
+    char         **entry;
+    int            n;
+    int            i;
 
-                va_start(ap, optional);
+    if ((result = malloc(sizeof(rule_result_t))) == NULL)
+        return NULL;
 
-                while ((name = va_arg(ap, char *)) != NULL) {
-                    type  = va_arg(ap, int);
-                    value = va_arg(ap, void *);
+    memset(result, 0, sizeof(rule_result_t));
 
-                    if (!copy_value(name, type, value, retval[0])) {
-                        success = FALSE;
-                        break;
-                    }
-                }
+    if (retval == NULL)
+        return result;
 
-                va_end(ap);
-            }
+    result->valid = TRUE;
+    entry = retval[0];
+
+    if (!entry[0] || strcmp(entry[0], "name") || entry[1] == NULL)
+        return result;
+
+    for (n = 0;  entry[3 + n*3];  n++)
+        ;
+
+    if (n > 0 && (result->fields = calloc(n, sizeof(rule_field_t))) == NULL) {
+        free(result);
+        return NULL;
+    }
+
+    for (i = 0;  i < n;  i++) {
+        fld = result->fields + result->nfield;
+
+        fld->name = strdup(entry[3 + i*3]);
+        fld->type = (int)entry[3 + i*3 + 1];
+
+        switch (fld->type) {
+        case 's':
+            fld->value.string = strdup((char *)entry[3 + i*3 + 2]);
+            break;
+        case 'i':
+            fld->value.integer = (int)entry[3 + i*3 + 2];
+            break;
+        case 'd':
+            fld->value.floating = *(double *)entry[3 + i*3 + 2];
+            break;
+        default:
+            free(fld->name);
+            continue;
         }
 
-        if (retval)
-            rules_free_result(retval);
+        result->nfield++;
     }
 
-    OHM_DEBUG(DBG_RULE, "%s", success ? "succeeded" : "failed");
+    return result;
+}
 
-    return success;
+static void free_result(void *data)
+{
+    rule_result_t *result = (rule_result_t *)data;
+    rule_field_t  *fld;
+    int            i;
+
+    if (result != NULL) {
+        for (i = 0;  i < result->nfield;  i++) {
+            fld = result->fields + i;
+
+            free(fld->name);
+
+            if (fld->type == 's')
+                free(fld->value.string);
+        }
+
+        free(result->fields);
+        free(result);
+    }
 }
 
-static int copy_value(char *name, int type, void *value, char **entry)
+static int copy_value(char *name, int type, void *value, rule_result_t *result)
 {
-    int   i;
-    char *fldnam;
-    int   fldtyp;
-    void *fldval;
-    int   success;
+    rule_field_t *fld;
+    int           i;
 
     switch (type) {
     case 's':  *(char  **)value = NULL;    break;
@@ -205,31 +435,32 @@ static int copy_value(char *name, int type, void *value, char **entry)
     default:                               return FALSE;
     }
 
-    success = FALSE;
+    for (i = 0;  i < result->nfield;  i++) {
+        fld = result->fields + i;
+
+        if (!strcmp(name, fld->name) && type == fld->type) {
 
-    if (entry[0] && !strcmp(entry[0], "name") && entry[1] != NULL) {
-        for (i = 3;   entry[i];   i += 3) {
-            fldnam = entry[i];
-            fldtyp = (int)entry[i+1];
-            fldval = (void *)entry[i+2];
+            switch (type) {
+            case 's':  *(char  **)value = strdup(fld->value.string); break;
+            case 'i':  *(int    *)value = fld->value.integer;        break;
+            case 'd':  *(double *)value = fld->value.floating;       break;
+            default:                                                 break;
+            }
 
-            if (!strcmp(name, fldnam) && type == fldtyp) {
+            return TRUE;
+        }
+    }
 
-                switch (fldtyp) {
-                case 's':  *(char  **)value = strdup((char *)fldval); break;
-                case 'i':  *(int    *)value = (int)fldval;            break;
-                case 'd':  *(double *)value = *(double *)fldval;      break;
-                default:                                              break;
-                }
+    return FALSE;
+}
 
-                success = TRUE;
+static uint64_t usecs_now(void)
+{
+    struct timespec ts;
 
-                break;
-            }
-        } /* for */
-    }
+    clock_gettime(CLOCK_MONOTONIC, &ts);
 
-    return success;
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
 }
 
 
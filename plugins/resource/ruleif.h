@@ -21,6 +21,8 @@ USA.
 #ifndef __OHM_RESOURCE_RULEIF_H__
 #define __OHM_RESOURCE_RULEIF_H__
 
+#include <stdint.h>
+
 #define RULEIF_STRING_ARG(n,v)     n, (int)'s', (void *)(&v)
 #define RULEIF_INTEGER_ARG(n,v)    n, (int)'i', (void *)(&v)
 #define RULEIF_DOUBLE_ARG(n,v)     n, (int)'d', (void *)(&v)
@@ -31,7 +33,10 @@ USA.
 typedef struct _OhmPlugin OhmPlugin;
 
 void ruleif_init(OhmPlugin *);
+void ruleif_exit(OhmPlugin *);
 int ruleif_valid_resource_request(const char *class, int mandatory, int optional, ...);
+void ruleif_flush_cache(void);
+void ruleif_cache_statistics(uint32_t *, uint32_t *, uint32_t *);
 
 #endif	/* __OHM_RESOURCE_RULEIF_H__ */
 
@@ -0,0 +1,233 @@
+/*************************************************************************
+Copyright (C) 2010 Nokia Corporation.
+
+These OHM Modules are free software; you can redistribute
+it and/or modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation
+version 2.1 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301
+USA.
+*************************************************************************/
+
+
+/**
+ * @file check_transaction.c
+ * @brief OHM resource plugin transaction stress test
+ *
+ * Keeps thousands of transactions open at the same time and completes
+ * them through transaction_ref/unref in scrambled order.
+ */
+
+#include <check.h>
+#include "../transaction.c"
+
+#define STRESS_TRANSACTIONS 5000
+#define STRESS_RESSETS      40
+#define STRESS_ROUNDS       3
+
+int DBG_TRANSACT;
+
+void plugin_print_timestamp(const char *function, const char *step)
+{
+    (void)function;
+    (void)step;
+}
+
+/**
+ * ohm_log:
+ **/
+void
+ohm_log(OhmLogLevel level, const gchar *format, ...)
+{
+    va_list     ap;
+    FILE       *out;
+    const char *prefix;
+
+    switch (level) {
+    case OHM_LOG_ERROR:   prefix = "E: "; out = stderr; break;
+    case OHM_LOG_WARNING: prefix = "W: "; out = stderr; break;
+    case OHM_LOG_INFO:    prefix = "I: "; out = stdout; break;
+    default:                                           return;
+    }
+
+    va_start(ap, format);
+
+    fputs(prefix, out);
+    vfprintf(out, format, ap);
+    fputs("\n", out);
+
+    va_end(ap);
+}
+
+static uint32_t txids[STRESS_TRANSACTIONS];
+static uint32_t last_completed;
+static int      completed_count;
+static int      failed_count;
+
+static void stress_complete(uint32_t *rsids, int n, uint32_t txid, void *data)
+{
+    int i;
+
+    (void)data;
+
+    /* transactions complete in creation order ... */
+    if (txid <= last_completed)
+        failed_count++;
+
+    last_completed = txid;
+
+    /* ... with every resource set exactly once, in the order of addition */
+    if (n != STRESS_RESSETS)
+        failed_count++;
+    else {
+        for (i = 0;  i < n;  i++) {
+            if (rsids[i] != txid + i)
+                failed_count++;
+        }
+    }
+
+    completed_count++;
+}
+
+/*
+ * test_transaction_dedup
+ *
+ * Add the same resource sets over and over and check that the
+ * completion gets each of them only once.
+ */
+
+START_TEST (test_transaction_dedup)
+
+    uint32_t txid;
+    int i, j;
+
+    completed_count = 0;
+    failed_count    = 0;
+    last_completed  = 0;
+
+    txid = transaction_create(stress_complete, NULL);
+    fail_unless(txid != NO_TRANSACTION, "Failed to create transaction");
+
+    for (j = 0;  j < 4;  j++) {
+        for (i = 0;  i < STRESS_RESSETS;  i++) {
+            fail_unless(transaction_add_resource_set(txid, txid + i),
+                        "Failed to add resource set %d", i);
+        }
+    }
+
+    fail_unless(transaction_unref(txid), "Failed to unref transaction");
+    fail_unless(completed_count == 1, "Completed %d transactions",
+                completed_count);
+    fail_unless(failed_count == 0, "Wrong resource sets on completion");
+    fail_unless(find_transaction(txid) == NULL, "Transaction was not freed");
+
+END_TEST
+
+/*
+ * test_transaction_stress
+ *
+ * Keep STRESS_TRANSACTIONS transactions open at a time, hold an extra
+ * reference on each and drop the references in scrambled order. All of
+ * them must complete, in txid order, and the ring must not overflow.
+ */
+
+START_TEST (test_transaction_stress)
+
+    GRand *rand;
+    uint32_t tmp;
+    int round, i, j, k;
+
+    rand = g_rand_new_with_seed(12345);
+
+    completed_count = 0;
+    failed_count    = 0;
+    last_completed  = 0;
+
+    for (round = 0;  round < STRESS_ROUNDS;  round++) {
+        for (i = 0;  i < STRESS_TRANSACTIONS;  i++) {
+            txids[i] = transaction_create(stress_complete, NULL);
+            fail_unless(txids[i] != NO_TRANSACTION,
+                        "Failed to create transaction %d", i);
+
+            for (k = 0;  k < 2;  k++) {
+                for (j = 0;  j < STRESS_RESSETS;  j++)
+                    transaction_add_resource_set(txids[i], txids[i] + j);
+            }
+
+            fail_unless(transaction_ref(txids[i]),
+                        "Failed to ref transaction %u", txids[i]);
+        }
+
+        fail_unless(ringdim >= STRESS_TRANSACTIONS,
+                    "Transaction ring did not grow (%u)", ringdim);
+
+        /* drop the creation references in scrambled order ... */
+        for (i = STRESS_TRANSACTIONS - 1;  i > 0;  i--) {
+            j = g_rand_int_range(rand, 0, i + 1);
+            tmp = txids[i];  txids[i] = txids[j];  txids[j] = tmp;
+        }
+
+        for (i = 0;  i < STRESS_TRANSACTIONS;  i++)
+            fail_unless(transaction_unref(txids[i]), "Failed to unref");
+
+        fail_unless(completed_count == round * STRESS_TRANSACTIONS,
+                    "Transactions completed while still referenced");
+
+        /* ... and then the extra ones, again scrambled */
+        for (i = STRESS_TRANSACTIONS - 1;  i > 0;  i--) {
+            j = g_rand_int_range(rand, 0, i + 1);
+            tmp = txids[i];  txids[i] = txids[j];  txids[j] = tmp;
+        }
+
+        for (i = 0;  i < STRESS_TRANSACTIONS;  i++)
+            fail_unless(transaction_unref(txids[i]), "Failed to unref");
+
+        fail_unless(completed_count == (round + 1) * STRESS_TRANSACTIONS,
+                    "Completed %d transactions", completed_count);
+        fail_unless(txread == txwrite + 1, "Pending transactions left");
+    }
+
+    fail_unless(failed_count == 0, "%d completion errors", failed_count);
+
+    g_rand_free(rand);
+
+END_TEST
+
+
+Suite *ohm_resource_transaction_suite(void)
+{
+    Suite *suite = suite_create("ohm_resource_transaction");
+
+    TCase *tc_all = tcase_create("Transaction");
+
+    tcase_add_test(tc_all, test_transaction_dedup);
+    tcase_add_test(tc_all, test_transaction_stress);
+
+    tcase_set_timeout(tc_all, 120);
+    suite_add_tcase(suite, tc_all);
+
+    return suite;
+}
+
+int main (void) {
+
+    int failed = 0;
+    Suite *suite;
+
+    suite = ohm_resource_transaction_suite();
+    SRunner *runner = srunner_create(suite);
+    srunner_set_xml(runner, "/tmp/result-transaction.xml");
+    srunner_run_all(runner, CK_NORMAL);
+
+    failed = srunner_ntests_failed(runner);
+    srunner_free(runner);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
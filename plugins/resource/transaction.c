@@ -28,19 +28,33 @@ USA.
 #include "plugin.h"
 #include "transaction.h"
 
-#define HASH_BITS      10
-#define HASH_DIM       (1 << HASH_BITS)
-#define HASH_MASK      (HASH_DIM - 1)
-#define HASH_INDEX(i)  ((i) & HASH_MASK)
+/*
+ * Transactions live in a ring indexed by the lower bits of the txid. The
+ * ids between txread and txwrite are all in use, so the ring is doubled
+ * whenever a new transaction would wrap onto the oldest pending one, up
+ * to RING_MAX entries. A transaction that never completes would otherwise
+ * make the ring grow without bounds.
+ */
+#define RING_BITS      10
+#define RING_DIM       (1 << RING_BITS)
+#define RING_MAX       (1 << 16)
+#define RING_INDEX(i)  ((i) & ringmask)
+
+#define ALLOC_DIM      16
 
-#define ALLOC_DIM      1024
-#define ALLOC_JUNK     (ALLOC_DIM * sizeof(uint32_t))
+/*
+ * the resource sets are kept in an array in the order they were added
+ * and, once there are more than DEDUP_LIMIT of them, also in a set to
+ * make the duplicate check cheap
+ */
+#define DEDUP_LIMIT    16
 
 
 typedef struct {
-    int       junks;
-    int       length;
-    uint32_t *table;    
+    int         dim;
+    int         length;
+    uint32_t   *table;    
+    GHashTable *dedup;
 } resset_table_t;
 
 typedef struct {
@@ -56,12 +70,16 @@ typedef struct {
 } transaction_t;
 
 
-static transaction_t   transactions[HASH_DIM];
+static transaction_t **transactions;
+static uint32_t        ringdim;
+static uint32_t        ringmask;
 static uint32_t        txwrite;
 static uint32_t        txread = 1;
 
 static transaction_t *find_transaction(uint32_t);
+static int grow_ring(void);
 static int add_resource_set(transaction_t *, uint32_t);
+static void free_transaction(transaction_t *);
 static void complete_transaction(uint32_t);
 
 
@@ -83,16 +101,24 @@ uint32_t transaction_create(transaction_callback_t callback, void *user_data)
 {
     static uint32_t  count = NO_TRANSACTION;
 
-    uint32_t       txid = ++count;
-    int            idx  = HASH_INDEX(txid);
-    transaction_t *tx   = transactions + idx;
+    uint32_t       txid = count + 1;
+    transaction_t *tx;
+
+    if (txid == NO_TRANSACTION)
+        txid++;
 
-    if (tx->id != NO_TRANSACTION) {
-        OHM_ERROR("resource: transaction table overflow: transaction %u",txid);
+    if ((txid - txread >= ringdim && !grow_ring()) ||
+        (tx = malloc(sizeof(transaction_t))) == NULL)
+    {
+        OHM_ERROR("resource: can't create transaction %u", txid);
         txid = NO_TRANSACTION;
     }
     else {
+        count = txid;
+
         memset(tx, 0, sizeof(transaction_t));
+        transactions[RING_INDEX(txid)] = tx;
+
         tx->id     = txid;
         tx->refcnt = 1;
 
@@ -171,43 +197,111 @@ int transaction_unref(uint32_t txid)
 
 static transaction_t *find_transaction(uint32_t txid)
 {
-    int            idx = HASH_INDEX(txid);
-    transaction_t *tx  = transactions + idx;
+    transaction_t *tx;
+
+    if (txid == NO_TRANSACTION || transactions == NULL ||
+        txid - txread >= ringdim)
+        return NULL;
 
-    return (txid != NO_TRANSACTION && txid == tx->id) ? tx : NULL;
+    tx = transactions[RING_INDEX(txid)];
+
+    return (tx != NULL && txid == tx->id) ? tx : NULL;
 }
 
+static int grow_ring(void)
+{
+    transaction_t **ring;
+    uint32_t        dim;
+    uint32_t        i;
+    transaction_t  *tx;
+
+    dim = ringdim ? ringdim * 2 : RING_DIM;
+
+    if (dim > RING_MAX) {
+        OHM_ERROR("resource: transaction %u is still pending after %u "
+                  "others, refusing to grow the transaction ring beyond "
+                  "%u entries", txread, ringdim - 1, ringdim);
+        return FALSE;
+    }
+
+    if ((ring = calloc(dim, sizeof(transaction_t *))) == NULL)
+        return FALSE;
+
+    for (i = 0;  i < ringdim;  i++) {
+        if ((tx = transactions[i]) != NULL)
+            ring[tx->id & (dim - 1)] = tx;
+    }
+
+    free(transactions);
+
+    transactions = ring;
+    ringdim      = dim;
+    ringmask     = dim - 1;
+
+    if (dim > RING_DIM) {
+        OHM_DEBUG(DBG_TRANSACT, "transaction ring grown to %u entries", dim);
+    }
+
+    return TRUE;
+}
 
 static int add_resource_set(transaction_t *tx, uint32_t rsid)
 {
-    int   idx   = tx->resset.length;
-    int   junks;
-    int   size;
-    void *mem;
-    int   i;
-
-    for (i = 0;    i < tx->resset.length;   i++) {
-        if (tx->resset.table[i] == rsid)
+    resset_table_t *rt  = &tx->resset;
+    gpointer        key = GUINT_TO_POINTER(rsid);
+    int             dim;
+    void           *mem;
+    int             i;
+
+    if (rt->dedup != NULL) {
+        if (g_hash_table_lookup_extended(rt->dedup, key, NULL, NULL))
             return TRUE;        /* it is already there */
     }
+    else {
+        for (i = 0;    i < rt->length;   i++) {
+            if (rt->table[i] == rsid)
+                return TRUE;    /* it is already there */
+        }
+    }
     
-    if ((junks = (idx + ALLOC_JUNK) / ALLOC_JUNK) > tx->resset.junks) {
-        size = junks * ALLOC_JUNK * sizeof(uint32_t *);
-        mem  = realloc(tx->resset.table, size);
+    if (rt->length >= rt->dim) {
+        dim = rt->dim ? rt->dim * 2 : ALLOC_DIM;
+        mem = realloc(rt->table, dim * sizeof(uint32_t));
         
         if (mem == NULL)
             return FALSE;
 
-        tx->resset.junks = junks;
-        tx->resset.table = mem;
+        rt->dim   = dim;
+        rt->table = mem;
     }
 
-    tx->resset.length = idx + 1;
-    tx->resset.table[idx] = rsid;
+    rt->table[rt->length++] = rsid;
+
+    if (rt->dedup != NULL)
+        g_hash_table_insert(rt->dedup, key, key);
+    else if (rt->length > DEDUP_LIMIT) {
+        rt->dedup = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+        for (i = 0;  i < rt->length;  i++) {
+            key = GUINT_TO_POINTER(rt->table[i]);
+            g_hash_table_insert(rt->dedup, key, key);
+        }
+    }
 
     return TRUE;
 }
 
+static void free_transaction(transaction_t *tx)
+{
+    transactions[RING_INDEX(tx->id)] = NULL;
+
+    if (tx->resset.dedup != NULL)
+        g_hash_table_destroy(tx->resset.dedup);
+
+    free(tx->resset.table);
+    free(tx);
+}
+
 static void complete_transaction(uint32_t txid)
 {
     transaction_t *tx;
@@ -231,8 +325,7 @@ static void complete_transaction(uint32_t txid)
                                         tx->id, tx->completion.user_data);
             }
         
-            free(tx->resset.table);
-            memset(tx, 0, sizeof(*tx));
+            free_transaction(tx);
             
             txread = id + 1;
         }
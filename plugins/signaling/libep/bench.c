@@ -0,0 +1,204 @@
+/*************************************************************************
+Copyright (C) 2010 Nokia Corporation.
+
+These OHM Modules are free software; you can redistribute
+it and/or modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation
+version 2.1 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301
+USA.
+*************************************************************************/
+
+
+#include "ep.h"
+#include <time.h>
+
+/* decision parsing and field access benchmark, no bus needed */
+
+#define NSET       4
+#define NDECISION  8
+#define NFIELD     12
+#define NROUND     20000
+
+static const char *set_names[NSET] = {
+    "com.nokia.policy.audio_route",
+    "com.nokia.policy.audio_mute",
+    "com.nokia.policy.volume_limit",
+    "com.nokia.policy.context"
+};
+
+static char field_names[NFIELD][32];
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int append_field(DBusMessageIter *decit, const char *key, int i)
+{
+    DBusMessageIter fieldit, varit;
+    const char *str = "headset";
+    dbus_int32_t val = i;
+
+    if (!dbus_message_iter_open_container(decit, DBUS_TYPE_STRUCT, NULL, &fieldit) ||
+        !dbus_message_iter_append_basic(&fieldit, DBUS_TYPE_STRING, &key))
+        return FALSE;
+
+    if (i % 2) {
+        if (!dbus_message_iter_open_container(&fieldit, DBUS_TYPE_VARIANT, "s", &varit) ||
+            !dbus_message_iter_append_basic(&varit, DBUS_TYPE_STRING, &str))
+            return FALSE;
+    }
+    else {
+        if (!dbus_message_iter_open_container(&fieldit, DBUS_TYPE_VARIANT, "i", &varit) ||
+            !dbus_message_iter_append_basic(&varit, DBUS_TYPE_INT32, &val))
+            return FALSE;
+    }
+
+    return dbus_message_iter_close_container(&fieldit, &varit) &&
+        dbus_message_iter_close_container(decit, &fieldit);
+}
+
+static DBusMessage *create_message(void)
+{
+    DBusMessage *msg;
+    DBusMessageIter msgit, arrit, entit, setit, decit;
+    dbus_uint32_t txid = 0;
+    int s, d, f;
+
+    msg = dbus_message_new_signal(POLICY_DBUS_PATH "/" POLICY_DECISION,
+            POLICY_DBUS_INTERFACE, "actions");
+
+    if (msg == NULL)
+        return NULL;
+
+    dbus_message_iter_init_append(msg, &msgit);
+    dbus_message_iter_append_basic(&msgit, DBUS_TYPE_UINT32, &txid);
+    dbus_message_iter_open_container(&msgit, DBUS_TYPE_ARRAY, "{saa(sv)}", &arrit);
+
+    for (s = 0; s < NSET; s++) {
+        dbus_message_iter_open_container(&arrit, DBUS_TYPE_DICT_ENTRY, NULL, &entit);
+        dbus_message_iter_append_basic(&entit, DBUS_TYPE_STRING, &set_names[s]);
+        dbus_message_iter_open_container(&entit, DBUS_TYPE_ARRAY, "a(sv)", &setit);
+
+        for (d = 0; d < NDECISION; d++) {
+            dbus_message_iter_open_container(&setit, DBUS_TYPE_ARRAY, "(sv)", &decit);
+            for (f = 0; f < NFIELD; f++) {
+                if (!append_field(&decit, field_names[f], f)) {
+                    dbus_message_unref(msg);
+                    return NULL;
+                }
+            }
+            dbus_message_iter_close_container(&setit, &decit);
+        }
+
+        dbus_message_iter_close_container(&entit, &setit);
+        dbus_message_iter_close_container(&arrit, &entit);
+    }
+
+    dbus_message_iter_close_container(&msgit, &arrit);
+
+    return msg;
+}
+
+int main() {
+
+    DBusMessage *msg;
+    struct ep_message *m;
+    struct ep_decision **d;
+    ep_key keys[NFIELD];
+    double start, t_parse, t_string, t_key;
+    long sum_string = 0, sum_key = 0;
+    int round, s, f;
+
+    for (f = 0; f < NFIELD; f++)
+        snprintf(field_names[f], sizeof(field_names[f]), "field_%02d", f);
+
+    if ((msg = create_message()) == NULL) {
+        printf("bench: failed to create message\n");
+        return 1;
+    }
+
+    /* parsing */
+
+    start = now();
+    for (round = 0; round < NROUND; round++) {
+        if ((m = ep_message_parse(msg)) == NULL) {
+            printf("bench: failed to parse message\n");
+            return 1;
+        }
+        ep_message_free(m);
+    }
+    t_parse = now() - start;
+
+    m = ep_message_parse(msg);
+
+    if (m == NULL || !m->valid || m->nset != NSET) {
+        printf("bench: message parsed incorrectly\n");
+        return 1;
+    }
+
+    /* field access by name (old API) */
+
+    start = now();
+    for (round = 0; round < NROUND; round++) {
+        for (s = 0; s < m->nset; s++) {
+            for (d = m->sets[s].decisions; *d; d++) {
+                for (f = 0; f < NFIELD; f += 2)
+                    sum_string += ep_decision_get_int(*d, field_names[f]);
+                for (f = 1; f < NFIELD; f += 2)
+                    sum_string += ep_decision_get_string(*d, field_names[f]) != NULL;
+            }
+        }
+    }
+    t_string = now() - start;
+
+    /* field access by interned key */
+
+    for (f = 0; f < NFIELD; f++)
+        keys[f] = ep_key_intern(field_names[f]);
+
+    start = now();
+    for (round = 0; round < NROUND; round++) {
+        for (s = 0; s < m->nset; s++) {
+            for (d = m->sets[s].decisions; *d; d++) {
+                for (f = 0; f < NFIELD; f += 2)
+                    sum_key += ep_decision_lookup_int(*d, keys[f]);
+                for (f = 1; f < NFIELD; f += 2)
+                    sum_key += ep_decision_lookup_string(*d, keys[f]) != NULL;
+            }
+        }
+    }
+    t_key = now() - start;
+
+    ep_message_free(m);
+    dbus_message_unref(msg);
+
+    if (sum_string != sum_key) {
+        printf("bench: lookup mismatch (%ld != %ld)\n", sum_string, sum_key);
+        return 1;
+    }
+
+    printf("bench: %d sets x %d decisions x %d fields, %d rounds\n",
+            NSET, NDECISION, NFIELD, NROUND);
+    printf("bench: parse          %8.2f us/message\n",
+            t_parse * 1e6 / NROUND);
+    printf("bench: lookup by name %8.2f ns/field\n",
+            t_string * 1e9 / ((double) NROUND * NSET * NDECISION * NFIELD));
+    printf("bench: lookup by key  %8.2f ns/field\n",
+            t_key * 1e9 / ((double) NROUND * NSET * NDECISION * NFIELD));
+
+    return 0;
+}
@@ -124,47 +124,6 @@ static int ep_list_remove (struct ep_list_head_s *head, void *data)
     return TRUE;
 }
 
-static void ep_list_free_all (struct ep_list_head_s *head) {
-
-    struct ep_list_node_s *node = head->first, *p_node = NULL;
-
-    while (node) {
-        p_node = node;
-        node = node->next;
-
-        free(p_node);
-    }
-
-    head->first = NULL;
-    head->last = NULL;
-}
-
-static void ** ep_list_convert_to_array(struct ep_list_head_s *head) {
-
-    struct ep_list_node_s *node = head->first;
-    int node_count = 0, i = 0;
-    void **retval = NULL;
-
-    while (node) {
-        node_count++;
-        node = node->next;
-    }
-
-    retval = calloc(node_count + 1, sizeof(void *));
-
-    if (!retval)
-        return NULL;
-
-    node = head->first;
-
-    for (i = 0; i < node_count; i++) {
-        retval[i] = node->data;
-        node = node->next;
-    }
-    
-    return retval;
-}
-
 static struct transaction_data * ep_get_transaction(int txid) {
     
     /* check if it is still valid -- need to be in the list */
@@ -273,291 +232,518 @@ static void ep_ready(int txid, int status) {
 }
 
 
-static void free_decisions(struct ep_decision **decisions) {
+/* interned keys, bounded so that a peer sending ever new keys can not
+ * make us grow forever; keys beyond the limit are simply not indexed */
+
+#define EP_KEY_MAX   1024
+
+static char         **key_names = NULL;
+static int            key_count = 0;
+static int            key_alloc = 0;
+static int           *key_hash  = NULL; /* handle + 1, 0 = empty slot */
+static unsigned int   key_hash_size = 0;
+
+static unsigned int ep_hash (const char *s)
+{
+    unsigned int h = 5381;
+
+    while (*s)
+        h = h * 33 + (unsigned char) *s++;
+
+    return h;
+}
+
+static int ep_key_rehash (unsigned int size)
+{
+    int *hash = calloc(size, sizeof(int));
+    unsigned int i;
+    int k;
+
+    if (hash == NULL)
+        return FALSE;
+
+    for (k = 0; k < key_count; k++) {
+        for (i = ep_hash(key_names[k]) & (size - 1); hash[i];
+             i = (i + 1) & (size - 1))
+            ;
+        hash[i] = k + 1;
+    }
 
-    struct ep_decision **decisions_iter = decisions;
+    free(key_hash);
+    key_hash = hash;
+    key_hash_size = size;
 
-    while (*decisions_iter) {
-        struct ep_decision *decision = *decisions_iter;
-        struct ep_key_value_pair **pairs = decision->pairs;
+    return TRUE;
+}
 
-        while (*pairs) {
-            struct ep_key_value_pair *pair = *pairs;
+static ep_key ep_key_lookup (const char *key, int create)
+{
+    unsigned int i, mask;
+    char **names;
 
-            free(pair->key);
-            free(pair->value);
-            free(pair);
+    if (key == NULL)
+        return EP_KEY_INVALID;
 
-            pairs++;
+    if (key_hash_size) {
+        mask = key_hash_size - 1;
+
+        for (i = ep_hash(key) & mask; key_hash[i]; i = (i + 1) & mask) {
+            if (strcmp(key_names[key_hash[i] - 1], key) == 0)
+                return key_hash[i] - 1;
         }
-        free(decision->pairs);
+    }
+
+    if (!create || key_count >= EP_KEY_MAX)
+        return EP_KEY_INVALID;
+
+    if (key_count == key_alloc) {
+        names = realloc(key_names, (key_alloc + 32) * sizeof(char *));
+        if (names == NULL)
+            return EP_KEY_INVALID;
+        key_names = names;
+        key_alloc += 32;
+    }
 
-        decisions_iter++;
+    /* keep the load factor under 1/2 */
+    if ((unsigned int)(key_count + 1) * 2 > key_hash_size) {
+        if (!ep_key_rehash(key_hash_size ? key_hash_size * 2 : 64))
+            return EP_KEY_INVALID;
     }
-    free(decisions);
+
+    if ((key_names[key_count] = strdup(key)) == NULL)
+        return EP_KEY_INVALID;
+
+    mask = key_hash_size - 1;
+    for (i = ep_hash(key) & mask; key_hash[i]; i = (i + 1) & mask)
+        ;
+    key_hash[i] = ++key_count;
+
+    return key_count - 1;
 }
 
-static void handle_message (DBusMessage *msg, struct cb_data *data)
+ep_key ep_key_intern (const char *key)
 {
-    char *cb_decision_name;
-    int found = 0, i = 0;
+    return ep_key_lookup(key, TRUE);
+}
 
-    struct transaction_data *trans_data = NULL;
+ep_key ep_key_find (const char *key)
+{
+    return ep_key_lookup(key, FALSE);
+}
 
-    /* parse the message to ep_decision array */
+const char * ep_key_name (ep_key key)
+{
+    if (key < 0 || key >= key_count)
+        return NULL;
 
-    dbus_uint32_t    txid;
-    char            *actname;
+    return key_names[key];
+}
 
-    DBusMessageIter  msgit;
-    DBusMessageIter  arrit;
-    DBusMessageIter  entit;
-    DBusMessageIter  actit;
-    DBusMessageIter  structit;
-    DBusMessageIter  structfieldit;
-    DBusMessageIter  variantit;
+/* decision parsing */
 
-    int              success = TRUE;
+union ep_scalar {
+    int    i;
+    double f;
+};
 
-    /* printf("libep: parsing the message\n"); */
+struct ep_parse {
+    /* counting pass */
+    int nset;
+    int ndecision;
+    int npair;
+    int nindex;                 /* index slots of all decisions */
+
+    /* filling pass, NULL message while counting */
+    struct ep_message         *message;
+    struct ep_decision_set    *set;
+    struct ep_decision        *decision;
+    struct ep_decision       **decision_ptr;
+    struct ep_key_value_pair  *pair;
+    struct ep_key_value_pair **pair_ptr;
+    union ep_scalar           *value;
+    unsigned short            *index;
+    struct ep_decision        *current;
+    unsigned short            *current_index;
+    int                        slot;
+};
 
-    /**
-     * This is really complicated and nasty. Idea is that the message is
-     * supposed to look something like this:
-     *
-     * uint32 0
-     * array [
-     *    dict entry(
-     *       string "com.nokia.policy.audio_route"
-     *       array [
-     *          array [
-     *             struct {
-     *                string "type"
-     *                variant                      string "source"
-     *             }
-     *             struct {
-     *                string "device"
-     *                variant                      string "headset"
-     *             }
-     *          ]
-     *          array [
-     *             struct {
-     *                string "type"
-     *                variant                      string "sink"
-     *             }
-     *             struct {
-     *                string "device"
-     *                variant                      string "headset"
-     *             }
-     *          ]
-     *       ]
-     *    )
-     * ]
-     *
+#define EP_ALIGN(size) (((size) + sizeof(double) - 1) & ~(sizeof(double) - 1))
+
+static int index_size (int npair)
+{
+    /*
+     * Every decision gets an open addressing table of its own, sized by
+     * the number of its pairs and kept at most half full. Decisions too
+     * big for the slot type are not indexed but scanned.
      */
 
-    dbus_message_iter_init(msg, &msgit);
+    int size;
 
-    if (dbus_message_iter_get_arg_type(&msgit) != DBUS_TYPE_UINT32)
-        return;
+    if (npair <= 0 || npair >= 0x7fff)
+        return 0;
 
-    dbus_message_iter_get_basic(&msgit, (void *)&txid);
+    for (size = 4; size < npair * 2; size *= 2)
+        ;
 
-    if (txid != 0) {
-        trans_data = calloc(1, sizeof(struct transaction_data));
-        if (!trans_data)
-            goto send_signal;
-        trans_data->txid = txid;
-        if (!ep_list_append(&transaction_list, trans_data)) {
-            success = FALSE;
-            goto send_signal;
-        }
+    return size;
+}
+
+static int count_pairs (DBusMessageIter *structit)
+{
+    DBusMessageIter it = *structit;
+    int             n  = 0;
+
+    if (dbus_message_iter_get_arg_type(&it) != DBUS_TYPE_INVALID) {
+        do {
+            n++;
+        } while (dbus_message_iter_next(&it));
+    }
+
+    return n;
+}
+
+static void index_insert (struct ep_parse *p, ep_key key)
+{
+    struct ep_key_value_pair **pairs = p->current->pairs;
+    unsigned short            *index = p->current_index;
+    unsigned int               mask  = p->current->nindex - 1;
+    unsigned int               i;
+    const char                *name  = key_names[key];
+
+    for (i = key & mask; index[i]; i = (i + 1) & mask) {
+        /* like the linear scan used to, let the first occurrence win */
+        if (pairs[index[i] - 1]->key == name)
+            return;
     }
 
-    /* printf("libep: txid: %u\n", txid); */
+    index[i] = (unsigned short) (p->slot + 1);
+}
 
-    if (!dbus_message_iter_next(&msgit) ||
-        dbus_message_iter_get_arg_type(&msgit) != DBUS_TYPE_ARRAY) {
-        success = FALSE;
-        goto send_signal;
+static int parse_pair (DBusMessageIter *structit, struct ep_parse *p)
+{
+    /* there are two fields inside the struct: one string and one variant */
+
+    DBusMessageIter           fieldit, variantit;
+    struct ep_key_value_pair *pair;
+    char                     *key;
+    ep_key                    k;
+    dbus_int32_t              i32;
+
+    if (dbus_message_iter_get_arg_type(structit) != DBUS_TYPE_STRUCT)
+        return FALSE;
+
+    dbus_message_iter_recurse(structit, &fieldit);
+
+    if (dbus_message_iter_get_arg_type(&fieldit) != DBUS_TYPE_STRING)
+        return FALSE;
+
+    dbus_message_iter_get_basic(&fieldit, (void *)&key);
+
+    if (!dbus_message_iter_next(&fieldit) ||
+        dbus_message_iter_get_arg_type(&fieldit) != DBUS_TYPE_VARIANT)
+        return FALSE;
+
+    k = ep_key_intern(key);
+
+    if (p->message == NULL) {
+        p->npair++;
+        return TRUE;
+    }
+
+    pair = p->pair++;
+
+    /* keys over the intern limit point into the message, like values */
+    pair->key   = k >= 0 ? key_names[k] : key;
+    pair->type  = EP_VALUE_INVALID;
+    pair->value = NULL;
+
+    dbus_message_iter_recurse(&fieldit, &variantit);
+
+    switch (dbus_message_iter_get_arg_type(&variantit)) {
+        case DBUS_TYPE_INT32:
+            dbus_message_iter_get_basic(&variantit, &i32);
+            p->value->i = i32;
+            pair->value = &p->value->i;
+            pair->type  = EP_VALUE_INT;
+            break;
+        case DBUS_TYPE_DOUBLE:
+            dbus_message_iter_get_basic(&variantit, &p->value->f);
+            pair->value = &p->value->f;
+            pair->type  = EP_VALUE_FLOAT;
+            break;
+        case DBUS_TYPE_STRING:
+            /* no copy, the string stays in the message */
+            dbus_message_iter_get_basic(&variantit, &pair->value);
+            pair->type  = EP_VALUE_STRING;
+            break;
+        default:
+            break;
+    }
+
+    p->value++;
+    *p->pair_ptr++ = pair;
+
+    if (k >= 0 && p->current->nindex > 0)
+        index_insert(p, k);
+
+    p->slot++;
+
+    return TRUE;
+}
+
+static int parse_decision (DBusMessageIter *actit, struct ep_parse *p)
+{
+    DBusMessageIter     structit;
+    struct ep_decision *decision = NULL;
+    int                 valid = TRUE;
+    int                 nindex;
+
+    if (dbus_message_iter_get_arg_type(actit) != DBUS_TYPE_ARRAY)
+        return FALSE;
+
+    dbus_message_iter_recurse(actit, &structit);
+
+    /* both passes size the index of the decision the same way */
+    nindex = index_size(count_pairs(&structit));
+
+    if (p->message == NULL) {
+        p->ndecision++;
+        p->nindex += nindex;
+    }
+    else {
+        decision = p->decision++;
+
+        decision->pairs  = p->pair_ptr;
+        decision->nindex = nindex;
+        decision->index  = nindex ? p->index : NULL;
+        p->current       = decision;
+        p->current_index = p->index;
+        p->index        += nindex;
+        p->slot          = 0;
+
+        *p->decision_ptr++ = decision;
+    }
+
+    /* gather the key-value pairs to the decision */
+    if (dbus_message_iter_get_arg_type(&structit) != DBUS_TYPE_INVALID) {
+        do {
+            if (!parse_pair(&structit, p))
+                valid = FALSE;
+        } while (dbus_message_iter_next(&structit));
+    }
+
+    if (decision != NULL)
+        *p->pair_ptr++ = NULL;
+
+    return valid;
+}
+
+static int parse_decision_set (DBusMessageIter *arrit, struct ep_parse *p)
+{
+    DBusMessageIter         entit, actit;
+    struct ep_decision_set *set;
+    char                   *actname;
+    int                     valid = TRUE;
+
+    if (dbus_message_iter_get_arg_type(arrit) != DBUS_TYPE_DICT_ENTRY)
+        return FALSE;
+
+    dbus_message_iter_recurse(arrit, &entit);
+
+    if (dbus_message_iter_get_arg_type(&entit) != DBUS_TYPE_STRING)
+        return FALSE;
+
+    dbus_message_iter_get_basic(&entit, (void *)&actname);
+
+    if (!dbus_message_iter_next(&entit) ||
+        dbus_message_iter_get_arg_type(&entit) != DBUS_TYPE_ARRAY)
+        return FALSE;
+
+    if (p->message == NULL)
+        p->nset++;
+    else {
+        set = p->set++;
+        set->name      = actname;
+        set->decisions = p->decision_ptr;
+        p->message->nset++;
+    }
+
+    dbus_message_iter_recurse(&entit, &actit);
+
+    /* gather the decisions to the decision set */
+    if (dbus_message_iter_get_arg_type(&actit) != DBUS_TYPE_INVALID) {
+        do {
+            if (!parse_decision(&actit, p))
+                valid = FALSE;
+        } while (dbus_message_iter_next(&actit));
     }
 
+    if (p->message != NULL)
+        *p->decision_ptr++ = NULL;
+
+    return valid;
+}
+
+static int parse_message (DBusMessage *msg, struct ep_parse *p,
+        dbus_uint32_t *txid)
+{
+    DBusMessageIter msgit, arrit;
+    int             valid = TRUE;
+
+    dbus_message_iter_init(msg, &msgit);
+
+    if (dbus_message_iter_get_arg_type(&msgit) != DBUS_TYPE_UINT32)
+        return -1;
+
+    dbus_message_iter_get_basic(&msgit, (void *)txid);
+
+    if (!dbus_message_iter_next(&msgit) ||
+        dbus_message_iter_get_arg_type(&msgit) != DBUS_TYPE_ARRAY)
+        return FALSE;
+
     dbus_message_iter_recurse(&msgit, &arrit);
 
+    if (dbus_message_iter_get_arg_type(&arrit) == DBUS_TYPE_INVALID)
+        return TRUE;
+
     do {
-        if (dbus_message_iter_get_arg_type(&arrit) != DBUS_TYPE_DICT_ENTRY) {
-            success = FALSE;
-            continue;
-        }
+        if (!parse_decision_set(&arrit, p))
+            valid = FALSE;
+    } while (dbus_message_iter_next(&arrit));
 
-        dbus_message_iter_recurse(&arrit, &entit);
+    return valid;
+}
 
-        do {
-            struct ep_decision **decisions = NULL;
-            struct ep_list_head_s decision_list;
-            
-            memset(&decision_list, 0, sizeof(struct ep_list_head_s));
-    
-            if (dbus_message_iter_get_arg_type(&entit) != DBUS_TYPE_STRING) {
-                success = FALSE;
-                continue;
-            }
-            
-            dbus_message_iter_get_basic(&entit, (void *)&actname);
-    
-            /* printf("libep: decision set name '%s'\n", actname); */
-            
-            if (!dbus_message_iter_next(&entit) ||
-                dbus_message_iter_get_arg_type(&entit) != DBUS_TYPE_ARRAY) {
-                success = FALSE;
-                continue;
-            }
-            
-            dbus_message_iter_recurse(&entit, &actit);
-            
-            /* gather the decisions to the decision set */
-            do {
-                struct ep_decision *decision = calloc(1, sizeof(struct ep_decision));
-
-                struct ep_list_head_s pair_list;
-                memset(&pair_list, 0, sizeof(struct ep_list_head_s));
-
-                if (dbus_message_iter_get_arg_type(&actit) != DBUS_TYPE_ARRAY) {
-                    success = FALSE;
-                    free(decision);
-                    continue;
-                }
-                dbus_message_iter_recurse(&actit, &structit);
-
-                /* gather the key-value pairs to the decision */
-                do {
-                    struct ep_key_value_pair *pair =
-                        calloc(1, sizeof(struct ep_key_value_pair));
-                    void *tmp = NULL;
-                    char *key = NULL;
-
-                    if (dbus_message_iter_get_arg_type(&structit) != DBUS_TYPE_STRUCT) {
-                        success = FALSE;
-                        free(pair);
-                        continue;
-                    }
-                    dbus_message_iter_recurse(&structit, &structfieldit);
+struct ep_message * ep_message_parse (DBusMessage *msg)
+{
+    /*
+     * Parse the whole message in two passes: first count everything,
+     * then fill in a single block laid out as
+     *
+     *   message | values | sets | decisions | pairs |
+     *   decision pointers | pair pointers | lookup indices
+     */
 
-                    /* there are two fields inside the struct: one
-                     * string and one variant */
+    struct ep_parse  p;
+    struct ep_message *m;
+    dbus_uint32_t    txid = 0;
+    size_t           size, off_values, off_sets, off_decisions, off_pairs,
+                     off_dptrs, off_pptrs, off_index;
+    char            *base;
+    int              valid;
 
-                    if (dbus_message_iter_get_arg_type(&structfieldit) != DBUS_TYPE_STRING) {
-                        success = FALSE;
-                        free(pair);
-                        continue;
-                    }
+    memset(&p, 0, sizeof(p));
 
-                    dbus_message_iter_get_basic(&structfieldit, (void *)&key);
-                    pair->key = strdup(key);
-                    /* printf("libep:   key: '%s'\n", pair->key); */
+    if ((valid = parse_message(msg, &p, &txid)) < 0)
+        return NULL;
 
-                    if (!dbus_message_iter_next(&structfieldit)) {
-                        success = FALSE;
-                        free(pair);
-                        continue;
-                    }
+    off_values    = EP_ALIGN(sizeof(struct ep_message));
+    off_sets      = off_values + EP_ALIGN(p.npair * sizeof(union ep_scalar));
+    off_decisions = off_sets +
+        EP_ALIGN(p.nset * sizeof(struct ep_decision_set));
+    off_pairs     = off_decisions +
+        EP_ALIGN(p.ndecision * sizeof(struct ep_decision));
+    off_dptrs     = off_pairs +
+        EP_ALIGN(p.npair * sizeof(struct ep_key_value_pair));
+    off_pptrs     = off_dptrs +
+        EP_ALIGN((p.ndecision + p.nset) * sizeof(struct ep_decision *));
+    off_index     = off_pptrs +
+        EP_ALIGN((p.npair + p.ndecision) * sizeof(struct ep_key_value_pair *));
+    size          = off_index +
+        (size_t) p.nindex * sizeof(unsigned short);
+
+    if ((base = calloc(1, size)) == NULL)
+        return NULL;
 
-                    if (dbus_message_iter_get_arg_type(&structfieldit) != DBUS_TYPE_VARIANT) {
-                        success = FALSE;
-                        free(pair);
-                        continue;
-                    }
-                    dbus_message_iter_recurse(&structfieldit, &variantit);
-                    dbus_message_iter_get_basic(&variantit, (void *)&tmp);
-                    
-                    switch (dbus_message_iter_get_arg_type(&variantit)) {
-                        case DBUS_TYPE_INT32:
-                            pair->value = malloc(sizeof(int));
-                            memcpy(pair->value, &tmp, sizeof(int));
-                            pair->type = EP_VALUE_INT;
-                            /* printf("libep:   value (int)    '%i'\n",
-                                    *(int *) pair->value); */
-                            break;
-                        case DBUS_TYPE_DOUBLE:
-                            pair->value = malloc(sizeof(double));
-                            memcpy(pair->value, &tmp, sizeof(double));
-                            pair->type = EP_VALUE_FLOAT;
-                            /* printf("libep:   value (float)  '%f'\n",
-                                    *(float *) pair->value); */
-                            break;
-                        case DBUS_TYPE_STRING:
-                            pair->value = strdup(tmp);
-                            pair->type = EP_VALUE_STRING;
-                            /* printf("libep:   value (string) '%s'\n",
-                                    (char *) pair->value); */
-                            break;
-                        default:
-                            /* printf("libep:   value is unknown D-Bus type '%i'\n", 
-                                    dbus_message_iter_get_arg_type(&variantit)); */
-                            break;
-                    }
-                    
-                    ep_list_append(&pair_list, pair);
-
-                } while (dbus_message_iter_next(&structit));
-
-                decision->pairs =
-                    (struct ep_key_value_pair **) ep_list_convert_to_array(&pair_list);
-                ep_list_free_all(&pair_list);
-                
-                ep_list_append(&decision_list, decision);
-            
-            } while (dbus_message_iter_next(&entit));
-
-            decisions = (struct ep_decision **) ep_list_convert_to_array(&decision_list);
-            ep_list_free_all(&decision_list);
-
-            /* count the callbacks if a transaction is needed */
-            if (trans_data) {
-                if (data->decision_names[0]) {
-                    i = 0;
-                    cb_decision_name = data->decision_names[i];
-                    while (cb_decision_name) {
-                        if (strcmp(cb_decision_name, actname) == 0) {
-                            trans_data->refcount++;
-#if 0
-                            printf("libep: increased transaction data '%p' refcount to %u for name '%s'\n",
-                                    trans_data, trans_data->refcount, cb_decision_name);
-#endif
-                        }
-                        cb_decision_name = data->decision_names[++i];
-                    }
-                }
-                else {
-                    /* subscribe to all decisions */
-                    trans_data->refcount++;
-                }
-            }
+    m = (struct ep_message *) base;
+    m->txid  = txid;
+    m->valid = valid;
+    m->sets  = (struct ep_decision_set *) (base + off_sets);
+
+    p.message      = m;
+    p.value        = (union ep_scalar *) (base + off_values);
+    p.set          = m->sets;
+    p.decision     = (struct ep_decision *) (base + off_decisions);
+    p.pair         = (struct ep_key_value_pair *) (base + off_pairs);
+    p.decision_ptr = (struct ep_decision **) (base + off_dptrs);
+    p.pair_ptr     = (struct ep_key_value_pair **) (base + off_pptrs);
+    p.index        = (unsigned short *) (base + off_index);
+
+    /* the message is immutable, so the second pass walks the same items */
+    parse_message(msg, &p, &txid);
+
+    return m;
+}
+
+void ep_message_free (struct ep_message *message)
+{
+    free(message);
+}
+
+static void handle_message (struct ep_message *m, struct cb_data *data)
+{
+    char *cb_decision_name;
+    int found = 0, i = 0, s;
+
+    struct transaction_data *trans_data = NULL;
+    struct ep_decision_set *set;
+
+    dbus_uint32_t    txid = m->txid;
+    int              success = m->valid;
+
+    if (txid != 0) {
+        trans_data = calloc(1, sizeof(struct transaction_data));
+        if (!trans_data)
+            goto send_signal;
+        trans_data->txid = txid;
+        if (!ep_list_append(&transaction_list, trans_data)) {
+            success = FALSE;
+            goto send_signal;
+        }
+    }
+
+    for (s = 0; s < m->nset; s++) {
+        set = &m->sets[s];
 
+        /* count the callbacks if a transaction is needed */
+        if (trans_data) {
             if (data->decision_names[0]) {
                 i = 0;
                 cb_decision_name = data->decision_names[i];
-
-                /* send the decisions */
                 while (cb_decision_name) {
-                    if (strcmp(cb_decision_name, actname) == 0) {
-                        data->cb(actname, decisions, ep_ready, txid, data->user_data);
-                        found = TRUE;
+                    if (strcmp(cb_decision_name, set->name) == 0) {
+                        trans_data->refcount++;
                     }
                     cb_decision_name = data->decision_names[++i];
                 }
             }
             else {
-                /* call the callback for all decisions */
-                data->cb(actname, decisions, ep_ready, txid, data->user_data);
-                found = TRUE;
+                /* subscribe to all decisions */
+                trans_data->refcount++;
             }
-            
-            free_decisions(decisions);
+        }
 
-        } while (dbus_message_iter_next(&entit));
+        if (data->decision_names[0]) {
+            i = 0;
+            cb_decision_name = data->decision_names[i];
 
-    } while (dbus_message_iter_next(&arrit));
+            /* send the decisions */
+            while (cb_decision_name) {
+                if (strcmp(cb_decision_name, set->name) == 0) {
+                    data->cb(set->name, set->decisions, ep_ready, txid,
+                            data->user_data);
+                    found = TRUE;
+                }
+                cb_decision_name = data->decision_names[++i];
+            }
+        }
+        else {
+            /* call the callback for all decisions */
+            data->cb(set->name, set->decisions, ep_ready, txid,
+                    data->user_data);
+            found = TRUE;
+        }
+    }
     
     if (txid == 0) {
         /* no ack is needed, go to send_signal for cleanup */
@@ -578,9 +764,6 @@ static void handle_message (DBusMessage *msg, struct cb_data *data)
         trans_data->ready = TRUE;
         send_if_done(trans_data);
 
-#if 0
-        printf("libep: signal handling success, waiting for callbacks\n");
-#endif
         return; /* success */
     }
 
@@ -589,17 +772,12 @@ send_signal:
     /* no-one is interested or everything failed, just send the signal
      * and be done with it */
 
-    /* TODO: free all memory */
-
     if (trans_data) {
         ep_list_remove(&transaction_list, trans_data);
         free(trans_data);
         trans_data = NULL;
     }
 
-    /* printf("libep: not waiting for handlers to return, parsing %s a success\n",
-            success ? "was" : "was not"); */
-
     send_signal(txid, success);
 }
 
@@ -612,6 +790,7 @@ static DBusHandlerResult filter (DBusConnection *conn, DBusMessage *msg,
     struct ep_list_head_s *head = &cb_list;
     struct ep_list_node_s *node = NULL;
     struct cb_data *data = NULL;
+    struct ep_message *m = NULL;
 
     /* printf("libep: policy event received\n"); */
 
@@ -623,12 +802,16 @@ static DBusHandlerResult filter (DBusConnection *conn, DBusMessage *msg,
     while (node) {
         data = node->data;
         if (dbus_message_is_signal(msg, POLICY_DBUS_INTERFACE, data->signal)) {
-            handle_message(msg, data);
+            /* parse once, no matter how many filters are interested */
+            if (m == NULL && (m = ep_message_parse(msg)) == NULL)
+                goto end;
+            handle_message(m, data);
         }
         node = node->next;
     }
 
 end:
+    ep_message_free(m);
     return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
 }
 
@@ -821,21 +1004,80 @@ failed:
     return 0;
 }
 
+static struct ep_key_value_pair * ep_lookup_pair(
+        struct ep_decision *decision, ep_key key)
+{
+    struct ep_key_value_pair **pairs;
+    unsigned int mask, i;
+    const char  *name;
+    int          slot;
+
+    if (key < 0 || key >= key_count)
+        return NULL;
+
+    name = key_names[key];
+
+    if (decision->index == NULL) {
+        /* not parsed by us or too big to index, scan it */
+        for (pairs = decision->pairs; *pairs; pairs++) {
+            if (strcmp((*pairs)->key, name) == 0)
+                return *pairs;
+        }
+        return NULL;
+    }
+
+    mask = decision->nindex - 1;
+
+    for (i = key & mask; (slot = decision->index[i]) != 0; i = (i + 1) & mask) {
+        if (decision->pairs[slot - 1]->key == name)
+            return decision->pairs[slot - 1];
+    }
+
+    return NULL;
+}
+
 static struct ep_key_value_pair * ep_find_pair(
         struct ep_decision *decision, const char *key)
 {
-    struct ep_key_value_pair **pairs = decision->pairs;
-    while (*pairs) {
-        struct ep_key_value_pair *pair = *pairs;
+    struct ep_key_value_pair **pairs;
+    ep_key k;
 
-        if (strcmp(pair->key, key) == 0)
-            return pair;
+    if (decision->index != NULL && (k = ep_key_find(key)) != EP_KEY_INVALID)
+        return ep_lookup_pair(decision, k);
 
-        pairs++;
+    /* not parsed by us or not interned, fall back to a linear scan */
+    for (pairs = decision->pairs; *pairs; pairs++) {
+        if (strcmp((*pairs)->key, key) == 0)
+            return *pairs;
     }
 
     return NULL;
+}
+
+static enum ep_value_type ep_pair_type (struct ep_key_value_pair *pair)
+{
+    return pair ? pair->type : EP_VALUE_INVALID;
+}
 
+static const char * ep_pair_string (struct ep_key_value_pair *pair)
+{
+    if (!pair || pair->type != EP_VALUE_STRING)
+        return NULL;
+    return (char *) pair->value;
+}
+
+static int ep_pair_int (struct ep_key_value_pair *pair)
+{
+    if (!pair || pair->type != EP_VALUE_INT)
+        return 0; /* TODO error handling */
+    return *(int *) pair->value;
+}
+
+static double ep_pair_float (struct ep_key_value_pair *pair)
+{
+    if (!pair || pair->type != EP_VALUE_FLOAT)
+        return 0.0; /* TODO error handling */
+    return *(double *) pair->value;
 }
 
 int ep_decision_has_key (struct ep_decision *decision, const char *key)
@@ -847,34 +1089,45 @@ int ep_decision_has_key (struct ep_decision *decision, const char *key)
 
 enum ep_value_type ep_decision_type (struct ep_decision *decision, const char *key)
 {
-
-    struct ep_key_value_pair *pair = ep_find_pair(decision, key);
-    if (!pair)
-        return EP_VALUE_INVALID;
-    return pair->type;
+    return ep_pair_type(ep_find_pair(decision, key));
 }
 
-
 const char * ep_decision_get_string (struct ep_decision *decision, const char *key)
 {
-    struct ep_key_value_pair *pair = ep_find_pair(decision, key);
-    if (!pair || pair->type != EP_VALUE_STRING)
-        return NULL;
-    return (char *) pair->value;
+    return ep_pair_string(ep_find_pair(decision, key));
 }
 
 int ep_decision_get_int (struct ep_decision *decision, const char *key)
 {
-    struct ep_key_value_pair *pair = ep_find_pair(decision, key);
-    if (!pair || pair->type != EP_VALUE_INT)
-        return 0; /* TODO error handling */
-    return *(int *) pair->value;
+    return ep_pair_int(ep_find_pair(decision, key));
 }
 
 double ep_decision_get_float (struct ep_decision *decision, const char *key)
 {
-    struct ep_key_value_pair *pair = ep_find_pair(decision, key);
-    if (!pair || pair->type != EP_VALUE_FLOAT)
-        return 0.0; /* TODO error handling */
-    return *(double *) pair->value;
+    return ep_pair_float(ep_find_pair(decision, key));
+}
+
+int ep_decision_lookup_has (struct ep_decision *decision, ep_key key)
+{
+    return ep_lookup_pair(decision, key) ? TRUE : FALSE;
+}
+
+enum ep_value_type ep_decision_lookup_type (struct ep_decision *decision, ep_key key)
+{
+    return ep_pair_type(ep_lookup_pair(decision, key));
+}
+
+const char * ep_decision_lookup_string (struct ep_decision *decision, ep_key key)
+{
+    return ep_pair_string(ep_lookup_pair(decision, key));
+}
+
+int ep_decision_lookup_int (struct ep_decision *decision, ep_key key)
+{
+    return ep_pair_int(ep_lookup_pair(decision, key));
+}
+
+double ep_decision_lookup_float (struct ep_decision *decision, ep_key key)
+{
+    return ep_pair_float(ep_lookup_pair(decision, key));
 }
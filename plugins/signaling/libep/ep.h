@@ -55,6 +55,34 @@ struct ep_key_value_pair {
 
 struct ep_decision {
     struct ep_key_value_pair **pairs;
+
+    /* private: hash of interned key -> pair slot + 1, nindex slots */
+    const unsigned short      *index;
+    int                        nindex;
+};
+
+/* Decisions are parsed into a single block of memory per message. Keys
+ * are interned process-wide (up to a fixed limit), so hot paths can
+ * resolve a key once with ep_key_intern() and then use the
+ * ep_decision_lookup_* functions. The
+ * string values point into the D-Bus message and, like the decisions
+ * themselves, are only valid until ep_message_free() (for callbacks: until
+ * the callback returns). */
+
+typedef int ep_key;
+
+#define EP_KEY_INVALID -1
+
+struct ep_decision_set {
+    const char          *name;
+    struct ep_decision **decisions; /* NULL terminated */
+};
+
+struct ep_message {
+    unsigned int            txid;
+    int                     valid;  /* FALSE if parts had to be skipped */
+    int                     nset;
+    struct ep_decision_set *sets;
 };
 
 
@@ -92,4 +120,23 @@ const char * ep_decision_get_string (struct ep_decision *decision, const char *k
 int ep_decision_get_int             (struct ep_decision *decision, const char *key);
 double ep_decision_get_float        (struct ep_decision *decision, const char *key);
 
+
+/* interned keys and indexed lookups */
+
+ep_key ep_key_intern                (const char *key);
+ep_key ep_key_find                  (const char *key);
+const char * ep_key_name            (ep_key key);
+
+int ep_decision_lookup_has          (struct ep_decision *decision, ep_key key);
+enum ep_value_type ep_decision_lookup_type (struct ep_decision *decision, ep_key key);
+const char * ep_decision_lookup_string (struct ep_decision *decision, ep_key key);
+int ep_decision_lookup_int          (struct ep_decision *decision, ep_key key);
+double ep_decision_lookup_float     (struct ep_decision *decision, ep_key key);
+
+
+/* parsing decision signals without the filter machinery */
+
+struct ep_message * ep_message_parse (DBusMessage *msg);
+void ep_message_free                 (struct ep_message *message);
+
 #endif
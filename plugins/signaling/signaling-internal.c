@@ -28,19 +28,23 @@ USA.
 
 #include "signaling.h"
 
-#define ONLY_ONE_TRANSACTION 1
-
 static int DBG_SIGNALING, DBG_FACTS;
 
 GSList         *enforcement_points = NULL;
+GHashTable     *enforcement_point_index; /* id -> EnforcementPoint */
 DBusConnection *connection;
 GHashTable     *transactions;
-#ifdef ONLY_ONE_TRANSACTION
 GHashTable     *signal_queues;
-#endif
 
 static OhmFactStore *store;
 static gboolean ecosystem_ready;
+static guint    default_depth = DEFAULT_PIPELINE_DEPTH;
+static guint    slow_threshold;  /* in ms, 0 disables slow EP detection */
+static gboolean skip_slow;
+
+/* shared name owner tracking of the dbus plugin, if available */
+static name_watch_t name_watch_add;
+static name_watch_t name_watch_del;
 
     
 typedef void (*internal_ep_cb_t) (GObject *ep, GObject *transaction, gboolean success);
@@ -57,12 +61,74 @@ static Transaction * transaction_lookup(guint txid)
     return (Transaction *)g_hash_table_lookup(transactions, &txid);
 }
 
-#ifdef ONLY_ONE_TRANSACTION
-static GQueue * signal_queue_lookup(gchar *signal)
+static guint64 now_usec(void)
 {
-    return (GQueue *)g_hash_table_lookup(signal_queues, signal);
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (guint64)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static signal_queue * signal_queue_lookup(const gchar *signal)
+{
+    return (signal_queue *)g_hash_table_lookup(signal_queues, signal);
+}
+
+static signal_queue * signal_queue_get(const gchar *signal)
+{
+    signal_queue *queue;
+
+    if ((queue = signal_queue_lookup(signal)) != NULL)
+        return queue;
+
+    queue = g_new0(signal_queue, 1);
+    queue->signal  = g_strdup(signal);
+    queue->pending = g_queue_new();
+    queue->depth   = default_depth;
+
+    g_hash_table_insert(signal_queues, queue->signal, queue);
+
+    return queue;
+}
+
+static void signal_queue_free(gpointer data)
+{
+    signal_queue *queue = data;
+    Transaction  *t;
+
+    while ((t = g_queue_pop_head(queue->pending)) != NULL)
+        g_object_unref(t);
+
+    g_queue_free(queue->pending);
+    g_free(queue->signal);
+    g_free(queue);
+}
+
+static EnforcementPoint * enforcement_point_lookup(const gchar *id)
+{
+    return (EnforcementPoint *)g_hash_table_lookup(enforcement_point_index, id);
+}
+
+static const gchar * enforcement_point_id(EnforcementPoint *ep)
+{
+    /* avoid the g_object_get string copy in the hot paths */
+
+    if (G_TYPE_CHECK_INSTANCE_TYPE(ep, INTERNAL_EP_STRATEGY_TYPE))
+        return INTERNAL_EP_STRATEGY(ep)->id;
+    else
+        return EXTERNAL_EP_STRATEGY(ep)->id;
 }
-#endif
+
+static ep_stats * enforcement_point_stats(EnforcementPoint *ep)
+{
+    if (G_TYPE_CHECK_INSTANCE_TYPE(ep, INTERNAL_EP_STRATEGY_TYPE))
+        return &INTERNAL_EP_STRATEGY(ep)->stats;
+    else
+        return &EXTERNAL_EP_STRATEGY(ep)->stats;
+}
+
+static OhmFact * lookup_fact(const gchar *uri);
 
 gboolean init_signaling(DBusConnection *c, int flag_signaling, int flag_facts)
 {
@@ -79,17 +145,22 @@ gboolean init_signaling(DBusConnection *c, int flag_signaling, int flag_facts)
         g_error("Failed to create transaction hash table.");
         return FALSE;
     }
+
+    enforcement_point_index = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                    g_free, NULL);
+    if (enforcement_point_index == NULL) {
+        g_error("Failed to create enforcement point hash table.");
+        return FALSE;
+    }
     
-#ifdef ONLY_ONE_TRANSACTION
     signal_queues = g_hash_table_new_full(g_str_hash,
             g_str_equal,
             NULL,
-            (GDestroyNotify) g_queue_free);
+            signal_queue_free);
     if (signal_queues == NULL) {
         g_error("Failed to create signal queue hash table.");
         return FALSE;
     }
-#endif
 
     connection = c;
 
@@ -107,22 +178,309 @@ gboolean deinit_signaling()
     }
 
     g_slist_free(enforcement_points);
+    enforcement_points = NULL;
+
+    if (enforcement_point_index) {
+        g_hash_table_destroy(enforcement_point_index);
+        enforcement_point_index = NULL;
+    }
 
     /* TODO: stop all possibly ongoing transactions (or verify that they
      * are actually stopped when all enforcement points are gone) */
     if (transactions)
         g_hash_table_destroy(transactions);
 
-#ifdef ONLY_ONE_TRANSACTION
-    if (signal_queues)
+    if (signal_queues) {
         g_hash_table_destroy(signal_queues);
-#endif
+        signal_queues = NULL;
+    }
 
     store = NULL;
 
     return TRUE;
 }
 
+void signaling_set_pipeline_depth(const gchar *signal, guint depth)
+{
+    /* a NULL signal sets the default for signals not configured yet */
+
+    if (depth == 0)
+        depth = 1;
+
+    if (signal == NULL)
+        default_depth = depth;
+    else
+        signal_queue_get(signal)->depth = depth;
+}
+
+void signaling_set_supersede(const gchar *signal, gboolean supersede)
+{
+    signal_queue_get(signal)->supersede = supersede;
+}
+
+signal_queue * signaling_queue_lookup(const gchar *signal)
+{
+    return signal_queue_lookup(signal);
+}
+
+static void queue_statistics(gpointer key, gpointer value, gpointer data)
+{
+    signal_queue *q   = value;
+    GString      *str = data;
+    guint         sent;
+
+    (void) key;
+
+    sent = q->completed + q->timedout;
+
+    g_string_append_printf(str,
+            "%s: depth %u, pending %u (max %u), in flight %u (max %u), "
+            "queued %u, superseded %u, completed %u, timed out %u, "
+            "avg. wait %llu us, avg. ack %llu us, max. ack %llu us\n",
+            q->signal, q->depth, g_queue_get_length(q->pending),
+            q->max_pending, q->inflight, q->max_inflight, q->queued,
+            q->superseded, q->completed, q->timedout,
+            (unsigned long long)(sent ? q->wait_total / sent : 0),
+            (unsigned long long)(q->completed ? q->ack_total / q->completed : 0),
+            (unsigned long long)q->ack_max);
+}
+
+gchar * signaling_queue_statistics(void)
+{
+    GString *str = g_string_new("");
+
+    if (signal_queues != NULL)
+        g_hash_table_foreach(signal_queues, queue_statistics, str);
+
+    return g_string_free(str, FALSE);
+}
+
+void signaling_set_name_watch(name_watch_t add, name_watch_t del)
+{
+    name_watch_add = add;
+    name_watch_del = del;
+}
+
+void signaling_set_slow_threshold(guint msecs)
+{
+    slow_threshold = msecs;
+}
+
+void signaling_set_skip_slow(gboolean skip)
+{
+    skip_slow = skip;
+}
+
+ep_stats * signaling_ep_stats_lookup(const gchar *uri)
+{
+    EnforcementPoint *ep;
+
+    if (enforcement_point_index == NULL ||
+        (ep = enforcement_point_lookup(uri)) == NULL)
+        return NULL;
+
+    return enforcement_point_stats(ep);
+}
+
+static void ep_statistics(gpointer data, gpointer user_data)
+{
+    EnforcementPoint *ep  = data;
+    GString          *str = user_data;
+    ep_stats         *st  = enforcement_point_stats(ep);
+    guint             answers, b;
+
+    answers = st->acked + st->nacked + st->late;
+
+    g_string_append_printf(str,
+            "%s: %sacked %u, nacked %u, timed out %u, skipped %u, late %u, "
+            "avg. ack %llu us, max. ack %llu us, score %llu us\n  ms:",
+            enforcement_point_id(ep), st->slow ? "SLOW, " : "",
+            st->acked, st->nacked, st->timedout, st->skipped, st->late,
+            (unsigned long long)(answers ? st->latency_total / answers : 0),
+            (unsigned long long)st->latency_max,
+            (unsigned long long)st->score);
+
+    for (b = 0; b < EP_LATENCY_BUCKETS; b++) {
+        if (b < EP_LATENCY_BUCKETS - 1)
+            g_string_append_printf(str, " <%u:%u", 1 << b, st->histogram[b]);
+        else
+            g_string_append_printf(str, " >=%u:%u", 1 << (b - 1),
+                                   st->histogram[b]);
+    }
+
+    g_string_append_c(str, '\n');
+}
+
+gchar * signaling_ep_statistics(void)
+{
+    GString *str = g_string_new("");
+
+    g_slist_foreach(enforcement_points, ep_statistics, str);
+
+    return g_string_free(str, FALSE);
+}
+
+/* enforcement point latency tracking */
+
+static guint latency_bucket(guint64 usecs)
+{
+    guint64 msecs = usecs / 1000;
+    guint   b     = 0;
+
+    /* bucket b holds latencies below 2^b ms, the last one the rest */
+
+    while (msecs > 0 && b < EP_LATENCY_BUCKETS - 1) {
+        msecs >>= 1;
+        b++;
+    }
+
+    return b;
+}
+
+static void ep_stats_publish(EnforcementPoint *ep, ep_stats *st,
+                             gboolean force)
+{
+    OhmFact *fact;
+    guint64  now = now_usec();
+    guint    answers;
+
+    if (!force && now - st->published_at < EP_STATS_PUBLISH_DELAY * 1000ULL)
+        return;
+
+    if (store == NULL || (fact = lookup_fact(enforcement_point_id(ep))) == NULL)
+        return;
+
+    st->published_at = now;
+    answers = st->acked + st->nacked + st->late;
+
+    ohm_fact_set(fact, "acked", ohm_value_from_int(st->acked));
+    ohm_fact_set(fact, "nacked", ohm_value_from_int(st->nacked));
+    ohm_fact_set(fact, "timedout", ohm_value_from_int(st->timedout));
+    ohm_fact_set(fact, "skipped", ohm_value_from_int(st->skipped));
+    ohm_fact_set(fact, "latency",
+                 ohm_value_from_int(answers ?
+                                    st->latency_total / answers / 1000 : 0));
+    ohm_fact_set(fact, "latency_max",
+                 ohm_value_from_int(st->latency_max / 1000));
+    ohm_fact_set(fact, "score", ohm_value_from_int(st->score / 1000));
+    ohm_fact_set(fact, "slow", ohm_value_from_int(st->slow ? 1 : 0));
+}
+
+static void ep_stats_score(EnforcementPoint *ep, ep_stats *st,
+                           guint64 latency)
+{
+    guint64  threshold = (guint64)slow_threshold * 1000;
+    gboolean slow;
+
+    /* moving average, new samples weigh 1/8 */
+
+    if (st->score == 0)
+        st->score = latency;
+    else
+        st->score = st->score - st->score / 8 + latency / 8;
+
+    if (threshold == 0)
+        slow = FALSE;
+    else if (st->slow)
+        slow = st->score > threshold / 2;
+    else
+        slow = st->score > threshold;
+
+    if (slow != st->slow) {
+        st->slow = slow;
+        OHM_INFO("signaling: enforcement point '%s' is %s slow "
+                 "(avg. ack %llu ms)", enforcement_point_id(ep),
+                 slow ? "now" : "no longer",
+                 (unsigned long long)(st->score / 1000));
+        ep_stats_publish(ep, st, TRUE);
+    }
+    else
+        ep_stats_publish(ep, st, FALSE);
+}
+
+static void ep_stats_ack(EnforcementPoint *ep, guint64 sent_at,
+                         gboolean ack, gboolean late)
+{
+    ep_stats *st      = enforcement_point_stats(ep);
+    guint64   latency = now_usec() - sent_at;
+
+    if (late)
+        st->late++;
+    else if (ack)
+        st->acked++;
+    else
+        st->nacked++;
+
+    st->histogram[latency_bucket(latency)]++;
+    st->latency_total += latency;
+    if (latency > st->latency_max)
+        st->latency_max = latency;
+
+    ep_stats_score(ep, st, latency);
+}
+
+static void ep_expect_late_ack(EnforcementPoint *ep, Transaction *t)
+{
+    ExternalEPStrategy *s;
+    GHashTableIter      i;
+    gpointer            sent;
+    guint64             now;
+
+    /* internal EPs answer synchronously or not at all */
+
+    if (!G_TYPE_CHECK_INSTANCE_TYPE(ep, EXTERNAL_EP_STRATEGY_TYPE))
+        return;
+
+    s   = EXTERNAL_EP_STRATEGY(ep);
+    now = now_usec();
+
+    /* forget the acks which are not going to come any more */
+    g_hash_table_iter_init(&i, s->late);
+    while (g_hash_table_iter_next(&i, NULL, &sent)) {
+        if (now - *(guint64 *)sent > EP_LATE_ACK_WINDOW * 1000ULL)
+            g_hash_table_iter_remove(&i);
+    }
+
+    sent = g_new(guint64, 1);
+    *(guint64 *)sent = t->sent_at;
+
+    g_hash_table_insert(s->late, GUINT_TO_POINTER(t->txid), sent);
+}
+
+static gboolean ep_late_ack(EnforcementPoint *ep, guint txid, guint status)
+{
+    ExternalEPStrategy *s;
+    guint64            *sent;
+
+    if (!G_TYPE_CHECK_INSTANCE_TYPE(ep, EXTERNAL_EP_STRATEGY_TYPE))
+        return FALSE;
+
+    s = EXTERNAL_EP_STRATEGY(ep);
+
+    if ((sent = g_hash_table_lookup(s->late, GUINT_TO_POINTER(txid))) == NULL)
+        return FALSE;
+
+    OHM_DEBUG(DBG_SIGNALING, "late %s for transaction %u from '%s'",
+              status ? "ACK" : "NAK", txid, s->id);
+
+    ep_stats_ack(ep, *sent, status, TRUE);
+    g_hash_table_remove(s->late, GUINT_TO_POINTER(txid));
+
+    return TRUE;
+}
+
+static void ep_stats_timeout(EnforcementPoint *ep, Transaction *t)
+{
+    ep_stats *st = enforcement_point_stats(ep);
+
+    /* count the timeout as an ack at the deadline, the real latency
+     * gets into the histogram if the ack comes in later */
+
+    st->timedout++;
+    ep_stats_score(ep, st, now_usec() - t->sent_at);
+    ep_expect_late_ack(ep, t);
+}
+
 /* copy-paste from policy library */
 
 static void free_facts(GSList *facts)
@@ -149,6 +507,19 @@ static void free_string_list(GSList *list)
     return;
 }
 
+static void update_interested_quarks(GHashTable *set, GSList *interested)
+{
+    GSList *i;
+    GQuark  q;
+
+    g_hash_table_remove_all(set);
+
+    for (i = interested; i != NULL; i = g_slist_next(i)) {
+        if ((q = g_quark_from_string(i->data)) != 0)
+            g_hash_table_insert(set, GUINT_TO_POINTER(q), GUINT_TO_POINTER(q));
+    }
+}
+
 #if 0
 static GSList *copy_facts(GSList *facts)
 {
@@ -205,6 +576,24 @@ static GSList * result_list(GSList *ep_list)
     return retval;
 }
 
+static GSList * result_set(GHashTable *ep_set)
+{
+    GSList *retval = NULL;
+    GHashTableIter i;
+    gpointer ep;
+    gchar *id;
+
+    g_hash_table_iter_init(&i, ep_set);
+
+    while (g_hash_table_iter_next(&i, &ep, NULL)) {
+        g_object_get(ep, "id", &id, NULL);
+
+        retval = g_slist_prepend(retval, id);
+    }
+
+    return retval;
+}
+
 static void transaction_get_property(GObject *object,
         guint property_id,
         GValue *value,
@@ -223,7 +612,7 @@ static void transaction_get_property(GObject *object,
             g_value_set_string(value, t->signal);
             break;
         case PROP_RESPONSE_COUNT:
-            g_value_set_uint(value, g_slist_length(t->acked)+g_slist_length(t->nacked));
+            g_value_set_uint(value, t->n_acked + t->n_nacked);
             break;
         case PROP_ACKED:
             /* TODO: cache these? */
@@ -233,7 +622,7 @@ static void transaction_get_property(GObject *object,
             g_value_set_pointer(value, result_list(t->nacked));
             break;
         case PROP_NOT_ANSWERED:
-            g_value_set_pointer(value, result_list(t->not_answered));
+            g_value_set_pointer(value, result_set(t->not_answered));
             break;
         case PROP_FACTS:
             /* FIXME: pass a copy? To be refactored with OhmFacts */
@@ -299,6 +688,7 @@ static void transaction_set_property(GObject *object,
         case PROP_SIGNAL:
             g_free(t->signal);
             t->signal = g_value_dup_string(value);
+            t->signal_quark = t->signal ? g_quark_from_string(t->signal) : 0;
             break;
         case PROP_FACTS:
 #if 0
@@ -331,6 +721,7 @@ static void external_ep_strategy_set_property(GObject *object,
         case PROP_INTERESTED:
             free_string_list(ep->interested);
             ep->interested = g_value_get_pointer(value);
+            update_interested_quarks(ep->interested_quarks, ep->interested);
             break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
@@ -352,6 +743,7 @@ static void internal_ep_strategy_set_property(GObject *object,
         case PROP_INTERESTED:
             free_string_list(ep->interested);
             ep->interested = g_value_get_pointer(value);
+            update_interested_quarks(ep->interested_quarks, ep->interested);
             break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
@@ -424,19 +816,13 @@ gboolean internal_ep_is_interested(EnforcementPoint *self,
         Transaction *t)
 {
     InternalEPStrategy *s = INTERNAL_EP_STRATEGY(self);
-    gchar *signal;
-    gboolean retval = FALSE;
-
-    g_object_get(t, "signal", &signal, NULL);
+    gboolean retval;
 
-    if (g_slist_find_custom(s->interested, signal, strcmp)) {
-        retval = TRUE;
-    }
+    retval = g_hash_table_lookup(s->interested_quarks,
+                                 GUINT_TO_POINTER(t->signal_quark)) != NULL;
 
     OHM_DEBUG(DBG_SIGNALING, "Internal EP %p %s interested in signal '%s'",
-            self, retval ? "is" : "is not", signal);
-
-    g_free(signal);
+            self, retval ? "is" : "is not", t->signal);
 
     return retval;
 }
@@ -445,19 +831,13 @@ gboolean external_ep_is_interested(EnforcementPoint *self,
         Transaction *t)
 {
     ExternalEPStrategy *s = EXTERNAL_EP_STRATEGY(self);
-    gchar *signal;
-    gboolean retval = FALSE;
+    gboolean retval;
 
-    g_object_get(t, "signal", &signal, NULL);
-
-    if (g_slist_find_custom(s->interested, signal, strcmp)) {
-        retval = TRUE;
-    }
+    retval = g_hash_table_lookup(s->interested_quarks,
+                                 GUINT_TO_POINTER(t->signal_quark)) != NULL;
 
     OHM_DEBUG(DBG_SIGNALING, "External EP %p %s interested in signal '%s'",
-            self, retval ? "is" : "is not", signal);
-
-    g_free(signal);
+            self, retval ? "is" : "is not", t->signal);
 
     return retval;
 }
@@ -493,7 +873,7 @@ gboolean internal_ep_send_decision(EnforcementPoint *self,
         g_signal_emit (INTERNAL_EP_STRATEGY(self), signals [ON_KEY_CHANGE], 0, transaction);
     }
     else {
-        s->ongoing_transactions = g_slist_prepend(s->ongoing_transactions, transaction);
+        g_hash_table_insert(s->ongoing_transactions, transaction, transaction);
         g_signal_emit (INTERNAL_EP_STRATEGY(self), signals [ON_DECISION], 0, transaction, internal_ep_cb);
 
 #if 0
@@ -859,7 +1239,7 @@ gboolean external_ep_send_decision(EnforcementPoint * self,
 
     /* internal bookkeeping */
 
-    s->ongoing_transactions = g_slist_prepend(s->ongoing_transactions, transaction);
+    g_hash_table_insert(s->ongoing_transactions, transaction, transaction);
 
     return TRUE;
 }
@@ -874,14 +1254,17 @@ gboolean enforcement_point_unregister(EnforcementPoint * self)
 gboolean internal_ep_unregister(EnforcementPoint * self)
 {
     InternalEPStrategy *s = INTERNAL_EP_STRATEGY(self);
-    GSList *i = NULL;
+    GHashTableIter i;
+    gpointer t;
 
-    /* go through the ongoing_transactions list and remove this ep from
+    /* go through the ongoing_transactions set and remove this ep from
      * the transactions */
 
-    for (i = s->ongoing_transactions; i != NULL; i = g_slist_next(i)) {
-        transaction_remove_ep(i->data, self);
+    g_hash_table_iter_init(&i, s->ongoing_transactions);
+    while (g_hash_table_iter_next(&i, &t, NULL)) {
+        transaction_remove_ep(t, self);
     }
+    g_hash_table_remove_all(s->ongoing_transactions);
 
     return TRUE;
 }
@@ -889,14 +1272,17 @@ gboolean internal_ep_unregister(EnforcementPoint * self)
 gboolean external_ep_unregister(EnforcementPoint * self)
 {
     ExternalEPStrategy *s = EXTERNAL_EP_STRATEGY(self);
-    GSList *i = NULL;
+    GHashTableIter i;
+    gpointer t;
 
-    /* go through the ongoing_transactions list and remove this ep from
+    /* go through the ongoing_transactions set and remove this ep from
      * the transactions */
 
-    for (i = s->ongoing_transactions; i != NULL; i = g_slist_next(i)) {
-        transaction_remove_ep(i->data, self);
+    g_hash_table_iter_init(&i, s->ongoing_transactions);
+    while (g_hash_table_iter_next(&i, &t, NULL)) {
+        transaction_remove_ep(t, self);
     }
+    g_hash_table_remove_all(s->ongoing_transactions);
 
     return TRUE;
 }
@@ -916,7 +1302,7 @@ gboolean internal_ep_stop_transaction(EnforcementPoint * self,
     InternalEPStrategy *s = INTERNAL_EP_STRATEGY(self);
 
     /* internal reference count */
-    s->ongoing_transactions = g_slist_remove(s->ongoing_transactions, transaction);
+    g_hash_table_remove(s->ongoing_transactions, transaction);
     return TRUE;
 }
 
@@ -926,7 +1312,7 @@ gboolean external_ep_stop_transaction(EnforcementPoint * self,
     ExternalEPStrategy *s = EXTERNAL_EP_STRATEGY(self);
 
     /* internal reference count */
-    s->ongoing_transactions = g_slist_remove(s->ongoing_transactions, transaction);
+    g_hash_table_remove(s->ongoing_transactions, transaction);
     return TRUE;
 }
 
@@ -949,7 +1335,7 @@ gboolean internal_ep_receive_ack(EnforcementPoint * self,
             status ? "ACK" : "NACK");
 
     /* internal reference count */
-    s->ongoing_transactions = g_slist_remove(s->ongoing_transactions, transaction);
+    g_hash_table_remove(s->ongoing_transactions, transaction);
 
     transaction_ack_ep(transaction, self, status);
     if (transaction_done(transaction)) {
@@ -971,7 +1357,7 @@ gboolean external_ep_receive_ack(EnforcementPoint * self,
             status ? "ACK" : "NACK");
 
     /* internal reference count */
-    s->ongoing_transactions = g_slist_remove(s->ongoing_transactions, transaction);
+    g_hash_table_remove(s->ongoing_transactions, transaction);
 
     /* tell the transaction that we are ready */
     transaction_ack_ep(transaction, self, status);
@@ -996,9 +1382,15 @@ static void transaction_instance_init(GTypeInstance * instance,
     self->txid = 0;
     self->acked = NULL;
     self->nacked = NULL;
-    self->not_answered = NULL;
+    self->not_answered = g_hash_table_new(NULL, NULL);
+    self->n_acked = 0;
+    self->n_nacked = 0;
     self->timeout_id = 0;
     self->built_ready = FALSE;
+    self->folded = NULL;
+    self->queued_at = 0;
+    self->sent_at = 0;
+    self->n_skipped = 0;
 }
 
 static void external_ep_dispose(GObject *object)
@@ -1016,6 +1408,21 @@ static void external_ep_dispose(GObject *object)
     }
     g_slist_free(self->interested);
     self->interested = NULL;
+
+    if (self->interested_quarks) {
+        g_hash_table_destroy(self->interested_quarks);
+        self->interested_quarks = NULL;
+    }
+
+    if (self->ongoing_transactions) {
+        g_hash_table_destroy(self->ongoing_transactions);
+        self->ongoing_transactions = NULL;
+    }
+
+    if (self->late) {
+        g_hash_table_destroy(self->late);
+        self->late = NULL;
+    }
 }
 
 static void internal_ep_dispose(GObject *object)
@@ -1033,12 +1440,24 @@ static void internal_ep_dispose(GObject *object)
     }
     g_slist_free(self->interested);
     self->interested = NULL;
+
+    if (self->interested_quarks) {
+        g_hash_table_destroy(self->interested_quarks);
+        self->interested_quarks = NULL;
+    }
+
+    if (self->ongoing_transactions) {
+        g_hash_table_destroy(self->ongoing_transactions);
+        self->ongoing_transactions = NULL;
+    }
 }
 
 static void transaction_dispose(GObject *object)
 {
 
     GSList *i = NULL;
+    GHashTableIter j;
+    gpointer key;
     Transaction *self = TRANSACTION(object);
     OHM_DEBUG(DBG_SIGNALING, "transaction_dispose");
 
@@ -1050,19 +1469,31 @@ static void transaction_dispose(GObject *object)
         g_object_unref(ep);
     }
     g_slist_free(self->acked);
+    self->acked = NULL;
 
     for (i = self->nacked; i != 0; i = g_slist_next(i)) {
         EnforcementPoint *ep = i->data;
         g_object_unref(ep);
     }
     g_slist_free(self->nacked);
+    self->nacked = NULL;
     
     /* in case of timeout, these are still referenced */
-    for (i = self->not_answered; i != 0; i = g_slist_next(i)) {
-        EnforcementPoint *ep = i->data;
-        g_object_unref(ep);
+    if (self->not_answered) {
+        g_hash_table_iter_init(&j, self->not_answered);
+        while (g_hash_table_iter_next(&j, &key, NULL)) {
+            g_object_unref(key);
+        }
+        g_hash_table_destroy(self->not_answered);
+        self->not_answered = NULL;
     }
-    g_slist_free(self->not_answered);
+
+    /* folded transactions are normally completed (and released) along
+     * with us; if we never got completed, release them here */
+    for (i = self->folded; i != NULL; i = g_slist_next(i))
+        g_object_unref(i->data);
+    g_slist_free(self->folded);
+    self->folded = NULL;
 
     free_facts(self->facts);
     self->facts = NULL;
@@ -1226,6 +1657,8 @@ static void internal_ep_strategy_instance_init(GTypeInstance * instance,
 
     OHM_DEBUG(DBG_SIGNALING, "initing internal strategy");
     self->id = NULL;
+    self->ongoing_transactions = g_hash_table_new(NULL, NULL);
+    self->interested_quarks = g_hash_table_new(NULL, NULL);
 }
 
 
@@ -1265,6 +1698,9 @@ static void external_ep_strategy_instance_init(GTypeInstance * instance,
 
     OHM_DEBUG(DBG_SIGNALING, "initing external strategy");
     self->id = NULL;
+    self->ongoing_transactions = g_hash_table_new(NULL, NULL);
+    self->interested_quarks = g_hash_table_new(NULL, NULL);
+    self->late = g_hash_table_new_full(NULL, NULL, NULL, g_free);
 }
 
 static void external_ep_strategy_class_init(gpointer g_class,
@@ -1406,14 +1842,49 @@ GType internal_ep_get_type(void)
 
 /* transaction methods */
 
+static void transaction_skip_slow(Transaction *self)
+{
+    GHashTableIter i;
+    gpointer ep;
+
+    /* Complete without the EPs known to be slow if nobody else is left
+     * to wait for. Their acks are still picked up for the statistics
+     * when they arrive. */
+
+    g_hash_table_iter_init(&i, self->not_answered);
+    while (g_hash_table_iter_next(&i, &ep, NULL)) {
+        if (!G_TYPE_CHECK_INSTANCE_TYPE(ep, EXTERNAL_EP_STRATEGY_TYPE) ||
+            !enforcement_point_stats(ep)->slow)
+            return;
+    }
+
+    g_hash_table_iter_init(&i, self->not_answered);
+    while (g_hash_table_iter_next(&i, &ep, NULL)) {
+        OHM_DEBUG(DBG_SIGNALING, "not waiting for slow ep '%s' in "
+                  "transaction %u", enforcement_point_id(ep), self->txid);
+
+        enforcement_point_stop_transaction(ep, self);
+        enforcement_point_stats(ep)->skipped++;
+        ep_expect_late_ack(ep, self);
+        self->n_skipped++;
+
+        g_hash_table_iter_remove(&i);
+        g_object_unref(ep);
+    }
+}
+
 gboolean transaction_done(Transaction *self)
 {
     if (!self->built_ready)
         return FALSE;
+
+    if (skip_slow && self->txid != 0 && g_hash_table_size(self->not_answered))
+        transaction_skip_slow(self);
         
-    OHM_DEBUG(DBG_SIGNALING, "transaction_done unanswered ep count '%i'", g_slist_length(self->not_answered));
+    OHM_DEBUG(DBG_SIGNALING, "transaction_done unanswered ep count '%u'",
+              g_hash_table_size(self->not_answered));
 
-    return g_slist_length(self->not_answered) ? FALSE : TRUE;
+    return g_hash_table_size(self->not_answered) ? FALSE : TRUE;
 
 }
 
@@ -1425,17 +1896,22 @@ void transaction_add_ep(Transaction *self, EnforcementPoint *ep)
 
     g_object_ref(ep);
 
-    self->not_answered = g_slist_prepend(self->not_answered, ep);
+    g_hash_table_insert(self->not_answered, ep, ep);
 
-    OHM_DEBUG(DBG_SIGNALING, "Added ep %p to transaction %i, unanswered ep count now %i", ep, self->txid, g_slist_length(self->not_answered));
+    OHM_DEBUG(DBG_SIGNALING, "Added ep %p to transaction %u, unanswered ep "
+              "count now %u", ep, self->txid,
+              g_hash_table_size(self->not_answered));
 }
 
 void transaction_remove_ep(Transaction *self, EnforcementPoint *ep)
 {
 
-    self->not_answered = g_slist_remove(self->not_answered, ep);
+    if (!g_hash_table_remove(self->not_answered, ep))
+        return;
     
-    OHM_DEBUG(DBG_SIGNALING, "Removed ep %p to transaction %i, unanswered ep count now %i", ep, self->txid, g_slist_length(self->not_answered));
+    OHM_DEBUG(DBG_SIGNALING, "Removed ep %p from transaction %u, unanswered "
+              "ep count now %u", ep, self->txid,
+              g_hash_table_size(self->not_answered));
 
     g_object_unref(ep);
 }
@@ -1444,44 +1920,97 @@ void transaction_remove_ep(Transaction *self, EnforcementPoint *ep)
 void transaction_ack_ep(Transaction *self, EnforcementPoint *ep, 
         gboolean ack)
 {
-    gchar *id;
+    /* the reference taken in transaction_add_ep moves to the result list */
+
+    if (!g_hash_table_remove(self->not_answered, ep)) {
+        OHM_DEBUG(DBG_SIGNALING, "ep %p already answered transaction %u",
+                  ep, self->txid);
+        return;
+    }
+
+    if (self->txid != 0)
+        ep_stats_ack(ep, self->sent_at, ack, FALSE);
 
     if (ack) {
         /* OHM_DEBUG(DBG_SIGNALING, "ACK received from an enforcement point!"); */
         self->acked = g_slist_prepend(self->acked, ep);
+        self->n_acked++;
     }
     else {
         /* OHM_DEBUG(DBG_SIGNALING, "NACK received from an enforcement point!"); */
         self->nacked = g_slist_prepend(self->nacked, ep);
+        self->n_nacked++;
     }
 
-    self->not_answered = g_slist_remove(self->not_answered, ep);
-
-    g_object_get(ep, "id", &id, NULL);
-    g_signal_emit (self, signals [ON_ACK_RECEIVED], 0, id, ack);
-    g_free(id);
+    g_signal_emit (self, signals [ON_ACK_RECEIVED], 0,
+                   enforcement_point_id(ep), ack);
 
     return;
 }
 
+static void transaction_complete_folded(Transaction *self, Transaction *f)
+{
+    GHashTableIter i;
+    GSList *l;
+    gpointer ep;
+
+    /* a superseded transaction shares the outcome of the one it was
+     * folded into: hand out the same results (and references) */
+
+    for (l = self->acked; l != NULL; l = g_slist_next(l))
+        f->acked = g_slist_prepend(f->acked, g_object_ref(l->data));
+    for (l = self->nacked; l != NULL; l = g_slist_next(l))
+        f->nacked = g_slist_prepend(f->nacked, g_object_ref(l->data));
+
+    f->n_acked   = self->n_acked;
+    f->n_nacked  = self->n_nacked;
+    f->n_skipped = self->n_skipped;
+
+    g_hash_table_iter_init(&i, self->not_answered);
+    while (g_hash_table_iter_next(&i, &ep, NULL))
+        g_hash_table_insert(f->not_answered, g_object_ref(ep), ep);
+
+    OHM_DEBUG(DBG_SIGNALING, "superseded transaction '%u' completed by '%u'",
+              f->txid, self->txid);
+
+    g_signal_emit (f, signals [ON_TRANSACTION_COMPLETE], 0);
+
+    g_object_unref(f);
+}
+
 void transaction_complete(Transaction *self)
 {
-    GSList *i;
-#ifdef ONLY_ONE_TRANSACTION
-    GQueue *queue;
-#endif
+    GHashTableIter i;
+    gpointer ep;
+    GSList *l;
+    signal_queue *queue;
+    guint64 now;
     
     OHM_DEBUG(DBG_SIGNALING, "transaction complete!");
 
-    if (g_slist_length(self->not_answered) != 0) {
+    queue = signal_queue_lookup(self->signal);
+    now   = now_usec();
+
+    if (g_hash_table_size(self->not_answered) != 0) {
         /* we are here because of a timeout (TODO: or because of a
          * non-transaction decision, but refactor this away soon) */
         OHM_DEBUG(DBG_SIGNALING, "not all enforcement points answered");
 
-        for (i = self->not_answered; i != 0; i = g_slist_next(i)) {
-            EnforcementPoint *ep = i->data;
+        g_hash_table_iter_init(&i, self->not_answered);
+        while (g_hash_table_iter_next(&i, &ep, NULL)) {
             enforcement_point_stop_transaction(ep, self);
+            if (self->txid != 0)
+                ep_stats_timeout(ep, self);
         }
+
+        if (queue != NULL && self->txid != 0)
+            queue->timedout++;
+    }
+    else if (queue != NULL) {
+        queue->completed++;
+        queue->ack_total += now - self->sent_at;
+        if (now - self->sent_at > queue->ack_max)
+            queue->ack_max = now - self->sent_at;
     }
 
     /* check if this was the first transaction: if it was, the ecosystem
@@ -1507,6 +2036,12 @@ void transaction_complete(Transaction *self)
 
     g_signal_emit (self, signals [ON_TRANSACTION_COMPLETE], 0);
 
+    for (l = self->folded; l != NULL; l = g_slist_next(l))
+        transaction_complete_folded(self, l->data);
+
+    g_slist_free(self->folded);
+    self->folded = NULL;
+
     /* remove transaction from the table */
     g_hash_table_remove(transactions, &self->txid);
 
@@ -1514,29 +2049,26 @@ void transaction_complete(Transaction *self)
     if (self->timeout_id)
         g_source_remove(self->timeout_id);
 
-#ifdef ONLY_ONE_TRANSACTION
-    queue = signal_queue_lookup(self->signal);
-
     if (queue) {
         OHM_DEBUG(DBG_SIGNALING, "found queue '%s' (%p)",
                 self->signal, queue);
 
-        /* go on and process the next transaction */
-        if (!g_queue_is_empty(queue)) {
+        if (queue->inflight > 0)
+            queue->inflight--;
+
+        /* go on and process the next transaction, unless we are called
+         * from within process_inq which will pick it up by itself, or
+         * process_inq is already scheduled to run from the idle loop */
+        if (!g_queue_is_empty(queue->pending) &&
+            !queue->processing && !queue->scheduled) {
             OHM_DEBUG(DBG_SIGNALING,
-                    "transaction queue '%p' not empty (%i left), scheduling processing",
-                    queue, g_queue_get_length(queue));
+                    "transaction queue '%p' not empty (%u left), processing",
+                    queue, g_queue_get_length(queue->pending));
             /* Let's not delay the processing because of test issues :-) */
             process_inq(g_strdup(self->signal));
         }
-        else {
-            /* This was the last item in the queue, so remove it from
-             * the hash map. Note that the queue is also freed. */
-            OHM_DEBUG(DBG_SIGNALING, "queue is empty, removing it from the map");
-            g_hash_table_remove(signal_queues, self->signal);
-        }
     }
-#endif
+
     g_object_unref(self);
 }
 
@@ -1547,37 +2079,18 @@ static gboolean timeout_transaction(gpointer data)
     return FALSE;
 }
 
-static gboolean process_inq(gpointer data)
+static void process_transaction(signal_queue *queue, Transaction *t)
 {
-    /*
-     * Runs (mostly) in the idle loop, sends out the decisions, checks if the
-     * transactions have been completed 
-     */
-
     GSList           *e = NULL;
     gboolean        ret = TRUE;
-    Transaction      *t = NULL;
-    gchar       *signal = (gchar *) data;
-    GQueue       *queue = signal_queue_lookup(signal);
-
-    g_free(signal);
-
-#ifndef ONLY_ONE_TRANSACTION
-    while (queue != NULL && !g_queue_is_empty(queue)) {
-#endif
-
-    if (queue == NULL || g_queue_is_empty(queue)) {
-        OHM_DEBUG(DBG_SIGNALING,
-                "Error! Nothing to process, even though processing was scheduled.");
-        return FALSE;
-    }
-
-    t = g_queue_pop_head(queue);
 
     OHM_DEBUG(DBG_SIGNALING, "Processing transaction %p", t);
 
     g_hash_table_insert(transactions, &t->txid, t);
 
+    t->sent_at = now_usec();
+    queue->wait_total += t->sent_at - t->queued_at;
+
     for (e = enforcement_points; e != NULL; e = g_slist_next(e)) {
         EnforcementPoint *ep = e->data;
         OHM_DEBUG(DBG_SIGNALING, "process: ep 0x%p", ep);
@@ -1623,10 +2136,45 @@ static gboolean process_inq(gpointer data)
         /* printf("setting timeout: %u", timeout); */
         t->timeout_id = g_timeout_add(timeout, timeout_transaction, t);
     }
-#ifndef ONLY_ONE_TRANSACTION
+}
+
+static gboolean process_inq(gpointer data)
+{
+    /*
+     * Runs (mostly) in the idle loop, sends out the decisions until the
+     * pipeline of the signal is full. The rest are sent as the
+     * transactions in flight get completed.
+     */
+
+    Transaction      *t = NULL;
+    gchar       *signal = (gchar *) data;
+    signal_queue *queue = signal_queue_lookup(signal);
+
+    g_free(signal);
+
+    if (queue == NULL)
+        return FALSE;
+
+    queue->scheduled = FALSE;
+
+    if (g_queue_is_empty(queue->pending)) {
+        OHM_DEBUG(DBG_SIGNALING,
+                "Error! Nothing to process, even though processing was scheduled.");
+        return FALSE;
+    }
+
+    queue->processing = TRUE;
+
+    while (queue->inflight < queue->depth &&
+           (t = g_queue_pop_head(queue->pending)) != NULL) {
+        queue->inflight++;
+        if (queue->inflight > queue->max_inflight)
+            queue->max_inflight = queue->inflight;
+
+        process_transaction(queue, t);
     }
-    g_queue_free(queue);
-#endif
+
+    queue->processing = FALSE;
 
     return FALSE;
 }
@@ -1699,7 +2247,7 @@ static gboolean register_fact(const gchar *uri, const gchar *name, gboolean inte
 }
 
 
-static gboolean unregister_fact(const gchar *uri)
+static OhmFact * lookup_fact(const gchar *uri)
 {
     GSList     *l;
     OhmFact    *fact;
@@ -1715,14 +2263,25 @@ static gboolean unregister_fact(const gchar *uri)
         if (guri == NULL || (s = g_value_get_string(guri)) == NULL)
             continue;
 
-        if (!strcmp(s, uri)) {
-            ohm_fact_store_remove(store, fact);
-            g_object_unref(fact);
-            return TRUE;
-        }
+        if (!strcmp(s, uri))
+            return fact;
     }
 
-    return FALSE;
+    return NULL;
+}
+
+
+static gboolean unregister_fact(const gchar *uri)
+{
+    OhmFact *fact;
+
+    if ((fact = lookup_fact(uri)) == NULL)
+        return FALSE;
+
+    ohm_fact_store_remove(store, fact);
+    g_object_unref(fact);
+
+    return TRUE;
 }
 
 
@@ -1735,21 +2294,9 @@ EnforcementPoint * register_enforcement_point(const gchar *uri,
      * Registers an internal or external enforcement point 
      */
 
-    GSList *i = NULL;
     EnforcementPoint *ep = NULL;
-    gchar *id;
 
-    for (i = enforcement_points; i != NULL; i = g_slist_next(i)) {
-
-        g_object_get(i->data, "id", &id, NULL);
-
-        if (!strcmp(id, uri)) {
-            ep = i->data;
-            g_free(id);
-            break;
-        }
-        g_free(id);
-    }
+    ep = enforcement_point_lookup(uri);
 
     if (ep != NULL) {
         OHM_DEBUG(DBG_SIGNALING, "Could not register: ep '%s' already registered", uri);
@@ -1772,6 +2319,7 @@ EnforcementPoint * register_enforcement_point(const gchar *uri,
     OHM_DEBUG(DBG_SIGNALING, "Created ep '%s' at 0x%p", uri, ep);
 
     enforcement_points = g_slist_prepend(enforcement_points, ep);
+    g_hash_table_insert(enforcement_point_index, g_strdup(uri), ep);
 
     register_fact(uri, name, internal, capabilities);
 
@@ -1784,21 +2332,9 @@ gboolean unregister_enforcement_point(const gchar *uri)
     /* free memory and remove from the ep list */
     /* also remember to remove the ep from ongoing transactions list */
 
-    GSList *i = NULL;
     EnforcementPoint *ep = NULL;
-    gchar *id;
 
-    for (i = enforcement_points; i != NULL; i = g_slist_next(i)) {
-
-        g_object_get(i->data, "id", &id, NULL);
-
-        if (!strcmp(id, uri)) {
-            ep = i->data;
-            g_free(id);
-            break;
-        }
-        g_free(id);
-    }
+    ep = enforcement_point_lookup(uri);
 
     if (ep == NULL) {
         return FALSE;
@@ -1808,6 +2344,7 @@ gboolean unregister_enforcement_point(const gchar *uri)
 
     enforcement_point_unregister(ep);
     enforcement_points = g_slist_remove(enforcement_points, ep);
+    g_hash_table_remove(enforcement_point_index, uri);
     g_object_unref(ep);
 
     unregister_fact(uri);
@@ -1815,6 +2352,22 @@ gboolean unregister_enforcement_point(const gchar *uri)
     return TRUE;
 }
 
+static void ep_name_changed(const char *name, const char *previous,
+                            const char *current, void *data)
+{
+    (void) previous;
+    (void) data;
+
+    if (*current)
+        return;
+
+    /* a service went away (or was gone already), unregister it */
+    if (unregister_enforcement_point(name))
+        OHM_DEBUG(DBG_SIGNALING, "Removed service '%s'", name);
+
+    name_watch_del(DBUS_BUS_SYSTEM, name, ep_name_changed, NULL);
+}
+
 static int watch_dbus_addr(const char *addr, gboolean watchit,
                            DBusHandlerResult (*filter)(DBusConnection *,
                                                        DBusMessage *, void *),
@@ -1823,6 +2376,15 @@ static int watch_dbus_addr(const char *addr, gboolean watchit,
     char      match[1024];
     DBusError err;
 
+    if (name_watch_add != NULL) {
+        if (watchit)
+            return name_watch_add(DBUS_BUS_SYSTEM, addr,
+                                  ep_name_changed, NULL);
+        else
+            return name_watch_del(DBUS_BUS_SYSTEM, addr,
+                                  ep_name_changed, NULL);
+    }
+
     snprintf(match, sizeof(match),
              "type='signal',"
              "sender='%s',interface='%s',member='%s',path='%s',"
@@ -2024,6 +2586,8 @@ DBusHandlerResult unregister_external_enforcement_point(DBusConnection * c,
     }
     else {
         reply = dbus_message_new_method_return(msg);
+        /* no need to watch for the client disconnecting any more */
+        watch_dbus_addr(uri, FALSE, update_external_enforcement_points, NULL);
     }
 
     if (reply == NULL) {
@@ -2064,6 +2628,51 @@ static guint get_txid()
 }
 
 
+static void fold_facts(Transaction *t, GSList *facts)
+{
+    GSList *i;
+
+    for (i = facts; i != NULL; i = g_slist_next(i)) {
+        if (!g_slist_find_custom(t->facts, i->data, (GCompareFunc)strcmp))
+            t->facts = g_slist_append(t->facts, g_strdup(i->data));
+    }
+}
+
+static void fold_pending(signal_queue *queue, Transaction *t)
+{
+    GList *l, *next;
+    Transaction *p;
+
+    /*
+     * Fold transactions that have not been sent out yet into the new
+     * one. The enforcement points read the facts at sending time, so
+     * sending the union of the fact names once is equivalent to sending
+     * each pending decision. Only transactions of the same kind (acked
+     * or fire-and-forget) are folded.
+     */
+
+    for (l = queue->pending->head; l != NULL; l = next) {
+        next = l->next;
+        p    = l->data;
+
+        if ((p->txid == 0) != (t->txid == 0))
+            continue;
+
+        fold_facts(t, p->facts);
+
+        /* completing t will complete (and release) p as well */
+        t->folded = g_slist_concat(t->folded, p->folded);
+        p->folded = NULL;
+        t->folded = g_slist_append(t->folded, p);
+
+        g_queue_delete_link(queue->pending, l);
+        queue->superseded++;
+
+        OHM_DEBUG(DBG_SIGNALING, "transaction '%u' superseded by '%u'",
+                  p->txid, t->txid);
+    }
+}
+
 /*
  * return the Transaction, NULL if no need for real transaction
  */
@@ -2081,7 +2690,7 @@ Transaction * queue_decision(gchar *signal, GSList *facts,
     Transaction        *transaction;
     guint               txid = 0;
     gboolean            needs_processing = FALSE;
-    GQueue             *queue = NULL;
+    signal_queue       *queue = NULL;
     gpointer            data;
 
     /* create a new empty transaction */
@@ -2116,42 +2725,36 @@ Transaction * queue_decision(gchar *signal, GSList *facts,
             timeout,
             NULL);
 
-#ifdef ONLY_ONE_TRANSACTION
-    /* fetch the correct queue from the queue map */
-    queue = signal_queue_lookup(signal);
-    if (!queue) {
-        /* no existing queue for signal, so create a new one and add it
-         * to the signal_queues map */
-
-        queue = g_queue_new();
-        if (!queue) {
-            g_object_unref(transaction);
-            return NULL;
-        }
-        g_hash_table_insert(signal_queues, signal, queue);
-    }
-#else
-    queue = g_queue_new();
-    if (!queue) {
-        g_object_unref(transaction);
-        return NULL;
-    }
-#endif
+    /* fetch the correct queue from the queue map, creating it if needed */
+    queue = signal_queue_get(signal);
 
-    /* if the list is empty, there is no processing already pending */
-    if (g_queue_is_empty(queue))
-        needs_processing = TRUE;
+    transaction->queued_at = now_usec();
+
+    if (queue->supersede)
+        fold_pending(queue, transaction);
+
+    g_queue_push_tail(queue->pending, transaction);
+    queue->queued++;
+    if (g_queue_get_length(queue->pending) > queue->max_pending)
+        queue->max_pending = g_queue_get_length(queue->pending);
+
+    OHM_DEBUG(DBG_SIGNALING, "added transaction %p to queue '%s' (%p), "
+              "%u pending, %u in flight", transaction, signal, queue,
+              g_queue_get_length(queue->pending), queue->inflight);
 
-    g_queue_push_tail(queue, transaction);
-    OHM_DEBUG(DBG_SIGNALING, "added transaction %p to queue '%s' (%p)",
-            transaction, signal, queue);
+    /* only kick the queue if there is room in the pipeline and no
+     * processing is pending already */
+    if (queue->inflight < queue->depth && !queue->scheduled)
+        needs_processing = TRUE;
 
     if (needs_processing) {
         data = g_strdup(signal);
 
-        if (deferred_execution)
+        if (deferred_execution) {
             /* add the policy decision to the queue to be processed later */
+            queue->scheduled = TRUE;
             g_idle_add(process_inq, data);
+        }
         else
             process_inq(data);
     }
@@ -2183,7 +2786,6 @@ DBusHandlerResult dbus_ack(DBusConnection * c, DBusMessage * msg,
 
     DBusError      error;
     dbus_uint32_t  txid, status;
-    GSList *i = NULL;
     EnforcementPoint *ep = NULL;
     Transaction *transaction = NULL;
 
@@ -2213,30 +2815,21 @@ DBusHandlerResult dbus_ack(DBusConnection * c, DBusMessage * msg,
     dbus_error_free(&error);
 
     transaction = transaction_lookup(txid);
+    ep = enforcement_point_lookup(sender);
 
     if (transaction == NULL) {
-        OHM_DEBUG(DBG_SIGNALING, "unknown transaction %u, ignored", txid);
+        /* possibly an ack we did not wait for, account it to the EP */
+        if (ep == NULL || !ep_late_ack(ep, txid, status))
+            OHM_DEBUG(DBG_SIGNALING, "unknown transaction %u, ignored", txid);
         return DBUS_HANDLER_RESULT_HANDLED;
     }
 
-    for (i = transaction->not_answered; i != NULL; i = g_slist_next(i)) {
-        EnforcementPoint *tmp = i->data;
-        gchar *id;
-
-        g_object_get(tmp, "id", &id, NULL);
-
-        OHM_DEBUG(DBG_SIGNALING, "comparing id '%s' and sender '%s'", id, sender);
-
-        if (!strcmp(id, sender)) {
-            /* we found the sender */
-            ep = tmp;
-            OHM_DEBUG(DBG_SIGNALING, "transaction 0x%x %sed by peer '%s'", txid,
-                    status ? "ACK" : "NAK", id);
-
-            g_free(id);
-            break;
-        }
-        g_free(id);
+    if (ep != NULL && g_hash_table_lookup(transaction->not_answered, ep)) {
+        OHM_DEBUG(DBG_SIGNALING, "transaction 0x%x %sed by peer '%s'", txid,
+                  status ? "ACK" : "NAK", sender);
+    }
+    else {
+        ep = NULL;
     }
 
     if (ep == NULL) {
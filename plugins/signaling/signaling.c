@@ -34,6 +34,23 @@ OHM_DEBUG_PLUGIN(signaling,
     OHM_DEBUG_FLAG("signaling", "Signaling events" , &DBG_SIGNALING),
     OHM_DEBUG_FLAG("facts"    , "fact manipulation", &DBG_FACTS));
 
+#define IMPORT_METHOD(name, ptr) ({                                     \
+            signature = (char *)ptr##_SIGNATURE;                        \
+            ohm_module_find_method((name), &signature, (void *)&(ptr)); \
+        })
+
+OHM_IMPORTABLE(int, add_command, (char *name, void (*handler)(char *)));
+OHM_IMPORTABLE(int, add_watch, (DBusBusType type,
+                                const char *name,
+                                void (*handler)(const char *, const char *,
+                                                const char *, void *),
+                                void *data));
+OHM_IMPORTABLE(int, del_watch, (DBusBusType type,
+                                const char *name,
+                                void (*handler)(const char *, const char *,
+                                                const char *, void *),
+                                void *data));
+
 /* completion cb type */
 typedef void (*completion_cb_t)(char *id, char *argt, void **argv);
 
@@ -196,6 +213,154 @@ error:
     return 0;
 }
 
+OHM_EXPORTABLE(gchar *, queue_statistics, (void))
+{
+    /* caller frees the returned string */
+    return signaling_queue_statistics();
+}
+
+OHM_EXPORTABLE(gchar *, ep_statistics, (void))
+{
+    /* caller frees the returned string */
+    return signaling_ep_statistics();
+}
+
+/* console */
+
+static void console_command(char *command)
+{
+    gchar *stats;
+
+    if (!strcmp(command, "help")) {
+        printf("signaling help          show this help\n");
+        printf("signaling show eps      show enforcement point statistics\n");
+        printf("signaling show queues   show signal queue statistics\n");
+        return;
+    }
+    else if (!strcmp(command, "show eps"))
+        stats = signaling_ep_statistics();
+    else if (!strcmp(command, "show queues"))
+        stats = signaling_queue_statistics();
+    else {
+        printf("unknown signaling command \"%s\"\n", command);
+        return;
+    }
+
+    printf("%s", stats);
+    g_free(stats);
+}
+
+static void console_init(void)
+{
+    char *signature;
+
+    if (IMPORT_METHOD("dres.add_command", add_command))
+        add_command("signaling", console_command);
+    else
+        OHM_INFO("signaling: console command extensions not available");
+}
+
+/* name owner tracking */
+
+static void name_watch_init(void)
+{
+    char *signature;
+
+    /* let the dbus plugin track the external EPs if it is around */
+    if (IMPORT_METHOD("dbus.add_watch", add_watch) &&
+        IMPORT_METHOD("dbus.del_watch", del_watch))
+        signaling_set_name_watch(add_watch, del_watch);
+    else
+        OHM_INFO("signaling: shared D-Bus name tracking not available");
+}
+
+/* configuration */
+
+static void parse_pipeline(const char *value)
+{
+    gchar **entries, **e, *sep, *end;
+    gulong  depth;
+
+    /* signal:depth[,signal:depth...] */
+
+    entries = g_strsplit(value, ",", 0);
+
+    for (e = entries; *e != NULL; e++) {
+        g_strstrip(*e);
+
+        if ((sep = strchr(*e, ':')) == NULL) {
+            OHM_ERROR("signaling: invalid pipeline entry '%s'", *e);
+            continue;
+        }
+
+        *sep++ = '\0';
+        depth = strtoul(sep, &end, 10);
+
+        if (*end != '\0' || depth == 0) {
+            OHM_ERROR("signaling: invalid pipeline depth '%s' for '%s'",
+                      sep, *e);
+            continue;
+        }
+
+        signaling_set_pipeline_depth(*e, depth);
+    }
+
+    g_strfreev(entries);
+}
+
+static void parse_supersede(const char *value)
+{
+    gchar **entries, **e;
+
+    entries = g_strsplit(value, ",", 0);
+
+    for (e = entries; *e != NULL; e++) {
+        g_strstrip(*e);
+
+        if (**e)
+            signaling_set_supersede(*e, TRUE);
+    }
+
+    g_strfreev(entries);
+}
+
+static void plugin_config(OhmPlugin *plugin)
+{
+    const char *value;
+    char       *end;
+    gulong      depth, msecs;
+
+    if ((value = ohm_plugin_get_param(plugin, "pipeline-depth")) != NULL) {
+        depth = strtoul(value, &end, 10);
+
+        if (*end == '\0' && depth > 0)
+            signaling_set_pipeline_depth(NULL, depth);
+        else
+            OHM_ERROR("signaling: invalid value '%s' for 'pipeline-depth'",
+                      value);
+    }
+
+    if ((value = ohm_plugin_get_param(plugin, "pipeline")) != NULL)
+        parse_pipeline(value);
+
+    if ((value = ohm_plugin_get_param(plugin, "supersede")) != NULL)
+        parse_supersede(value);
+
+    if ((value = ohm_plugin_get_param(plugin, "slow-ep-threshold")) != NULL) {
+        msecs = strtoul(value, &end, 10);
+
+        if (*end == '\0')
+            signaling_set_slow_threshold(msecs);
+        else
+            OHM_ERROR("signaling: invalid value '%s' for 'slow-ep-threshold'",
+                      value);
+    }
+
+    if ((value = ohm_plugin_get_param(plugin, "skip-slow-eps")) != NULL)
+        signaling_set_skip_slow(!strcmp(value, "yes") ||
+                                !strcmp(value, "true"));
+}
+
 /* init and exit */
 
     static void
@@ -203,14 +368,15 @@ plugin_init(OhmPlugin * plugin)
 {
     DBusConnection *c = ohm_plugin_dbus_get_connection();
 
-    (void) plugin;
-
     /* should we ref the connection? */
 
     if (!OHM_DEBUG_INIT(signaling))
         g_warning("Failed to initialize signaling plugin debugging.");
 
     init_signaling(c, DBG_SIGNALING, DBG_FACTS);
+    plugin_config(plugin);
+    name_watch_init();
+    console_init();
     return;
 }
 
@@ -229,12 +395,14 @@ OHM_PLUGIN_DESCRIPTION("signaling",
         OHM_LICENSE_LGPL, plugin_init, plugin_exit,
         NULL);
 
-OHM_PLUGIN_PROVIDES_METHODS(signaling, 5,
+OHM_PLUGIN_PROVIDES_METHODS(signaling, 7,
         OHM_EXPORT(register_internal_enforcement_point, "register_enforcement_point"),
         OHM_EXPORT(unregister_internal_enforcement_point, "unregister_enforcement_point"),
         OHM_EXPORT(signal_changed, "signal_changed"),
         OHM_EXPORT(queue_policy_decision, "queue_policy_decision"),
-        OHM_EXPORT(queue_key_change, "queue_key_change"));
+        OHM_EXPORT(queue_key_change, "queue_key_change"),
+        OHM_EXPORT(queue_statistics, "queue_statistics"),
+        OHM_EXPORT(ep_statistics, "ep_statistics"));
 
 OHM_PLUGIN_DBUS_SIGNALS(
         {NULL, DBUS_INTERFACE_POLICY, SIGNAL_POLICY_ACK,
@@ -105,13 +105,20 @@ typedef struct _Transaction {
     GObject         parent;
     guint           txid;
     gchar          *signal;
+    GQuark          signal_quark; /* interned signal name */
     GSList         *acked;
     GSList         *nacked;
-    GSList         *not_answered;
+    GHashTable     *not_answered; /* set of EnforcementPoint * */
+    guint           n_acked;
+    guint           n_nacked;
     guint           timeout; /* in milliseconds */
     guint           timeout_id; /* g_source */
     gboolean        built_ready;
     GSList         *facts;
+    GSList         *folded; /* superseded transactions completed with us */
+    guint64         queued_at; /* in microseconds */
+    guint64         sent_at;
+    guint           n_skipped; /* slow EPs we did not wait for */
 
 } Transaction;
 
@@ -146,6 +153,28 @@ void            transaction_add_ep(Transaction *t, EnforcementPoint *ep);
 void            transaction_remove_ep(Transaction *t, EnforcementPoint *ep);
 void            transaction_ack_ep(Transaction *t, EnforcementPoint *ep, gboolean ack);
 
+/*
+ * enforcement point acknowledgement statistics
+ */
+
+#define EP_LATENCY_BUCKETS     12    /* < 1, 2, 4, ... 1024 ms, and above */
+#define EP_LATE_ACK_WINDOW     30000 /* ms to wait for a late ack */
+#define EP_STATS_PUBLISH_DELAY 1000  /* ms between fact updates */
+
+typedef struct _ep_stats {
+    guint     acked;
+    guint     nacked;
+    guint     timedout;
+    guint     skipped;      /* transactions completed without us */
+    guint     late;         /* acks after the transaction completed */
+    guint     histogram[EP_LATENCY_BUCKETS];
+    guint64   latency_total; /* in microseconds */
+    guint64   latency_max;
+    guint64   score;        /* running average of the ack latency */
+    gboolean  slow;
+    guint64   published_at;
+} ep_stats;
+
 typedef struct _fact {
     gchar *key;
     GSList *values;
@@ -162,8 +191,11 @@ typedef struct _fact {
 typedef struct _ExternalEPStrategy {
     GObject         parent;
     gchar          *id;
-    GSList         *ongoing_transactions;
+    GHashTable     *ongoing_transactions; /* set of Transaction * */
     GSList         *interested;
+    GHashTable     *interested_quarks;    /* set of signal name GQuarks */
+    ep_stats        stats;
+    GHashTable     *late;                 /* txid -> send time, for late acks */
 
 } ExternalEPStrategy;
 
@@ -187,8 +219,10 @@ GType           external_ep_get_type(void);
 typedef struct _InternalEPStrategy {
     GObject         parent;
     gchar          *id;
-    GSList         *ongoing_transactions;
+    GHashTable     *ongoing_transactions; /* set of Transaction * */
     GSList         *interested;
+    GHashTable     *interested_quarks;    /* set of signal name GQuarks */
+    ep_stats        stats;
 
 } InternalEPStrategy;
 
@@ -198,6 +232,33 @@ typedef struct _InternalEPStrategyClass {
 
 GType           internal_ep_get_type(void);
 
+/*
+ * per-signal transaction queues
+ */
+
+#define DEFAULT_PIPELINE_DEPTH 1
+
+typedef struct _signal_queue {
+    gchar    *signal;
+    GQueue   *pending;      /* transactions not sent out yet */
+    guint     depth;        /* max. number of transactions in flight */
+    gboolean  supersede;    /* fold pending transactions into newer ones */
+    guint     inflight;
+    gboolean  scheduled;
+    gboolean  processing;
+
+    /* statistics */
+    guint     queued;
+    guint     superseded;
+    guint     completed;
+    guint     timedout;
+    guint     max_pending;
+    guint     max_inflight;
+    guint64   wait_total;   /* queued -> sent, in microseconds */
+    guint64   ack_total;    /* sent -> fully acked, in microseconds */
+    guint64   ack_max;
+} signal_queue;
+
 
 /* API functions */
 
@@ -211,6 +272,29 @@ gboolean init_signaling();
 
 gboolean deinit_signaling();
 
+void signaling_set_pipeline_depth(const gchar *signal, guint depth);
+
+void signaling_set_supersede(const gchar *signal, gboolean supersede);
+
+signal_queue * signaling_queue_lookup(const gchar *signal);
+
+gchar * signaling_queue_statistics(void);
+
+void signaling_set_slow_threshold(guint msecs);
+
+void signaling_set_skip_slow(gboolean skip);
+
+ep_stats * signaling_ep_stats_lookup(const gchar *uri);
+
+gchar * signaling_ep_statistics(void);
+
+typedef int (*name_watch_t)(DBusBusType type, const char *name,
+                            void (*handler)(const char *, const char *,
+                                            const char *, void *),
+                            void *data);
+
+void signaling_set_name_watch(name_watch_t add, name_watch_t del);
+
 DBusHandlerResult dbus_ack(DBusConnection * c, DBusMessage * msg, void *data);
 
 DBusHandlerResult register_external_enforcement_point(DBusConnection * c, DBusMessage * msg,
@@ -504,10 +504,13 @@ test_transaction(gpointer data) {
     }
     else {
         int i = 0;
+        GHashTableIter iter;
+        gpointer ep;
         /* Get acks for the EPs */
-        while (test_transaction_object->not_answered) {
+        while (g_hash_table_size(test_transaction_object->not_answered)) {
             i++;
-            EnforcementPoint *ep = test_transaction_object->not_answered->data;
+            g_hash_table_iter_init(&iter, test_transaction_object->not_answered);
+            g_hash_table_iter_next(&iter, &ep, NULL);
             printf(">>> receiving ack from ep %i\n", i);
             enforcement_point_receive_ack(ep, test_transaction_object, i % 3);
         }
@@ -685,6 +688,183 @@ START_TEST (test_signaling_timeout)
 
 END_TEST
 
+/*
+ * test_signaling_supersede
+ *
+ * Test that decisions queued behind each other on a superseding signal
+ * are folded into one transaction and still all get completed.
+ */
+
+int supersede_complete_count = 0;
+
+static gboolean test_supersede_decision(EnforcementPoint *e, Transaction *t, internal_ep_cb_t cb, gpointer data) {
+
+    decision_count++;
+
+    fail_unless(g_slist_length(t->facts) == 3,
+            "Facts not folded: %i", g_slist_length(t->facts));
+
+    cb(G_OBJECT(e), G_OBJECT(t), TRUE);
+    return TRUE;
+}
+
+static void test_supersede_complete(Transaction *t, gpointer data) {
+
+    fail_unless(t->n_acked == 1, "Acked EPs: %u", t->n_acked);
+
+    if (++supersede_complete_count == 3)
+        g_main_loop_quit(loop);
+}
+
+START_TEST (test_signaling_supersede)
+
+    DBusError error;
+    DBusConnection *c;
+    GSList *capabilities = NULL;
+    EnforcementPoint *ep;
+    signal_queue *queue;
+    gchar *facts[] = {"com.nokia.fact_1", "com.nokia.fact_2", "com.nokia.fact_3"};
+    int i;
+
+    dbus_error_init(&error);
+
+    c = dbus_bus_get(DBUS_BUS_SYSTEM, &error);
+    fail_unless(init_signaling(c, 0, 0) == TRUE, "Init failed");
+
+    signaling_set_supersede("actions", TRUE);
+
+    capabilities = g_slist_prepend(capabilities, g_strdup("actions"));
+    ep = register_enforcement_point("internal", NULL, TRUE, capabilities);
+    g_signal_connect(ep, "on-decision", G_CALLBACK(test_supersede_decision), NULL);
+
+    decision_count = 0;
+    supersede_complete_count = 0;
+
+    for (i = 0; i < 3; i++) {
+        test_transaction_object = queue_decision("actions",
+                g_slist_prepend(NULL, g_strdup(facts[i])), 0, TRUE, 2000, TRUE);
+        g_signal_connect(test_transaction_object, "on-transaction-complete",
+                G_CALLBACK(test_supersede_complete), NULL);
+        g_object_unref(test_transaction_object);
+    }
+
+    g_main_loop_run(loop);
+
+    queue = signaling_queue_lookup("actions");
+
+    fail_unless(decision_count == 1, "Decision sent %i times", decision_count);
+    fail_unless(supersede_complete_count == 3,
+            "Completed %i transactions", supersede_complete_count);
+    fail_unless(queue != NULL && queue->superseded == 2,
+            "Superseded %u transactions", queue ? queue->superseded : 0);
+    fail_unless(queue->inflight == 0, "%u transactions in flight", queue->inflight);
+
+    unregister_enforcement_point("internal");
+    deinit_signaling();
+
+END_TEST
+
+/*
+ * test_signaling_slow_ep
+ *
+ * Test that an external EP which lets a transaction time out gets
+ * flagged slow and that the next transaction completes without
+ * waiting for it.
+ */
+
+int slow_complete_count = 0;
+
+static gboolean test_slow_ack(gpointer data) {
+
+    Transaction *t = data;
+    EnforcementPoint *ep;
+
+    if (!t->built_ready)
+        return TRUE;
+
+    /* only the fast EP answers */
+    ep = g_object_get_data(G_OBJECT(t), "fast-ep");
+    enforcement_point_receive_ack(ep, t, 1);
+
+    return FALSE;
+}
+
+static void test_slow_complete(Transaction *t, gpointer data) {
+
+    ep_stats *st = signaling_ep_stats_lookup("external-2");
+
+    fail_unless(st != NULL, "No statistics for the slow EP");
+
+    slow_complete_count++;
+
+    if (slow_complete_count == 1) {
+        /* the first one times out */
+        fail_unless(g_hash_table_size(t->not_answered) == 1,
+                "Not answered EPs: %u", g_hash_table_size(t->not_answered));
+        fail_unless(st->timedout == 1 && st->slow,
+                "Slow EP not detected (%u timeouts)", st->timedout);
+    }
+    else {
+        /* the second one does not wait for the slow EP */
+        fail_unless(g_hash_table_size(t->not_answered) == 0,
+                "Not answered EPs: %u", g_hash_table_size(t->not_answered));
+        fail_unless(t->n_acked == 1 && t->n_skipped == 1,
+                "Acked %u, skipped %u", t->n_acked, t->n_skipped);
+        fail_unless(st->skipped == 1, "Slow EP skipped %u times", st->skipped);
+    }
+
+    g_main_loop_quit(loop);
+}
+
+START_TEST (test_signaling_slow_ep)
+
+    DBusError error;
+    DBusConnection *c;
+    GSList *capabilities = NULL, *capabilities_2 = NULL;
+    EnforcementPoint *fast;
+    Transaction *t;
+    int i;
+
+    dbus_error_init(&error);
+
+    c = dbus_bus_get(DBUS_BUS_SYSTEM, &error);
+    fail_unless(init_signaling(c, 0, 0) == TRUE, "Init failed");
+
+    signaling_set_slow_threshold(50);
+    signaling_set_skip_slow(TRUE);
+
+    /* the EPs take over their capability lists, so each needs its own */
+    capabilities = g_slist_prepend(capabilities, g_strdup("actions"));
+    capabilities_2 = g_slist_prepend(capabilities_2, g_strdup("actions"));
+
+    fast = register_enforcement_point("external", NULL, FALSE, capabilities);
+    register_enforcement_point("external-2", NULL, FALSE, capabilities_2);
+
+    slow_complete_count = 0;
+
+    for (i = 0; i < 2; i++) {
+        t = queue_decision("actions", NULL, 0, TRUE, 200, TRUE);
+        g_object_set_data(G_OBJECT(t), "fast-ep", fast);
+        g_signal_connect(t, "on-transaction-complete",
+                G_CALLBACK(test_slow_complete), NULL);
+        g_idle_add(test_slow_ack, t);
+
+        g_main_loop_run(loop);
+        g_object_unref(t);
+    }
+
+    fail_unless(slow_complete_count == 2,
+            "Completed %i transactions", slow_complete_count);
+
+    signaling_set_slow_threshold(0);
+    signaling_set_skip_slow(FALSE);
+
+    unregister_enforcement_point("external");
+    unregister_enforcement_point("external-2");
+    deinit_signaling();
+
+END_TEST
+
 
 Suite *ohm_signaling_suite(void)
 {
@@ -699,6 +879,8 @@ Suite *ohm_signaling_suite(void)
     tcase_add_test(tc_all, test_signaling_internal_ep_2);
     tcase_add_test(tc_all, test_signaling_internal_ep_gobject);
     tcase_add_test(tc_all, test_signaling_timeout);
+    tcase_add_test(tc_all, test_signaling_supersede);
+    tcase_add_test(tc_all, test_signaling_slow_ep);
     
     tcase_set_timeout(tc_all, 120);
     suite_add_tcase(suite, tc_all);
@@ -0,0 +1,266 @@
+/*************************************************************************
+Copyright (C) 2010 Nokia Corporation.
+
+These OHM Modules are free software; you can redistribute
+it and/or modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation
+version 2.1 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301
+USA.
+*************************************************************************/
+
+
+/**
+ * @file check_signaling_load.c
+ * @brief OHM signaling plugin load test
+ *
+ * Runs thousands of back-to-back transactions against hundreds of
+ * simulated internal and external enforcement points.
+ */
+
+#include <check.h>
+#include "../signaling.h"
+
+#define LOAD_EPS          200
+#define LOAD_TRANSACTIONS 5000
+#define LOAD_TIMEOUT      30000
+
+/**
+ * ohm_log:
+ **/
+void
+ohm_log(OhmLogLevel level, const gchar *format, ...)
+{
+    va_list     ap;
+    FILE       *out;
+    const char *prefix;
+
+    switch (level) {
+    case OHM_LOG_ERROR:   prefix = "E: "; out = stderr; break;
+    case OHM_LOG_WARNING: prefix = "W: "; out = stderr; break;
+    case OHM_LOG_INFO:    prefix = "I: "; out = stdout; break;
+    default:                                           return;
+    }
+
+    va_start(ap, format);
+
+    fputs(prefix, out);
+    vfprintf(out, format, ap);
+    fputs("\n", out);
+
+    va_end(ap);
+}
+
+typedef void (*internal_ep_cb_t) (GObject *ep, GObject *transaction, gboolean success);
+
+extern GHashTable *transactions;
+
+static gchar *load_signals[] = {
+    "actions", "audio_route", "audio_volume", "video_route"
+};
+
+#define LOAD_SIGNALS ((int)G_N_ELEMENTS(load_signals))
+
+GMainLoop *loop;
+
+int completed_count;
+int failed_count;
+
+static void setup(void) {
+    g_type_init();
+    loop = g_main_loop_new(NULL, FALSE);
+}
+
+static void teardown(void) {
+    g_main_loop_unref(loop);
+}
+
+/* internal EPs acknowledge right away */
+static gboolean load_internal_decision(EnforcementPoint *e, Transaction *t,
+        internal_ep_cb_t cb, gpointer data) {
+
+    (void) data;
+
+    cb(G_OBJECT(e), G_OBJECT(t), TRUE);
+
+    return TRUE;
+}
+
+/* external EPs acknowledge from the main loop, as if from the bus */
+static gboolean load_external_ack(gpointer data) {
+
+    GList *pending, *i;
+    GSList *eps, *j;
+    GHashTableIter iter;
+    gpointer ep;
+
+    (void) data;
+
+    pending = g_hash_table_get_values(transactions);
+
+    for (i = pending; i != NULL; i = g_list_next(i))
+        g_object_ref(i->data);
+
+    for (i = pending; i != NULL; i = g_list_next(i)) {
+        Transaction *t = i->data;
+
+        if (!t->built_ready)
+            continue;
+
+        eps = NULL;
+        g_hash_table_iter_init(&iter, t->not_answered);
+        while (g_hash_table_iter_next(&iter, &ep, NULL))
+            eps = g_slist_prepend(eps, ep);
+
+        for (j = eps; j != NULL; j = g_slist_next(j))
+            enforcement_point_receive_ack(j->data, t, 1);
+
+        g_slist_free(eps);
+    }
+
+    for (i = pending; i != NULL; i = g_list_next(i))
+        g_object_unref(i->data);
+
+    g_list_free(pending);
+
+    return completed_count < LOAD_TRANSACTIONS;
+}
+
+static void load_complete(Transaction *t, gpointer data) {
+
+    guint response_count;
+
+    (void) data;
+
+    g_object_get(t, "response_count", &response_count, NULL);
+
+    /* every signal is subscribed to by half of the EPs */
+    if (response_count != LOAD_EPS / 2 || t->n_nacked != 0 ||
+        g_hash_table_size(t->not_answered) != 0)
+        failed_count++;
+
+    if (++completed_count == LOAD_TRANSACTIONS)
+        g_main_loop_quit(loop);
+}
+
+/*
+ * test_signaling_load
+ *
+ * Push LOAD_TRANSACTIONS decisions over LOAD_SIGNALS signals to
+ * LOAD_EPS enforcement points and check that all of them get fully
+ * acknowledged.
+ */
+
+START_TEST (test_signaling_load)
+
+    DBusError error;
+    DBusConnection *c;
+    Transaction *t;
+    GTimer *timer;
+    gdouble elapsed;
+    gchar uri[64];
+    int i;
+
+    dbus_error_init(&error);
+
+    c = dbus_bus_get(DBUS_BUS_SYSTEM, &error);
+    fail_unless(init_signaling(c, 0, 0) == TRUE, "Init failed");
+
+    for (i = 0; i < LOAD_EPS; i++) {
+        GSList *capabilities = NULL;
+        gboolean internal = (i % 2) == 0;
+        EnforcementPoint *ep;
+
+        capabilities = g_slist_prepend(capabilities,
+                g_strdup(load_signals[i % LOAD_SIGNALS]));
+        capabilities = g_slist_prepend(capabilities,
+                g_strdup(load_signals[(i + 1) % LOAD_SIGNALS]));
+
+        snprintf(uri, sizeof(uri), "%s-%d", internal ? "internal" : "external", i);
+
+        ep = register_enforcement_point(uri, NULL, internal, capabilities);
+        fail_unless(ep != NULL, "Failed to register EP '%s'", uri);
+
+        if (internal)
+            g_signal_connect(ep, "on-decision",
+                    G_CALLBACK(load_internal_decision), NULL);
+    }
+
+    completed_count = 0;
+    failed_count = 0;
+
+    timer = g_timer_new();
+
+    for (i = 0; i < LOAD_TRANSACTIONS; i++) {
+        t = queue_decision(load_signals[i % LOAD_SIGNALS], NULL, 0, TRUE,
+                LOAD_TIMEOUT, TRUE);
+        fail_unless(t != NULL, "Failed to queue transaction %d", i);
+
+        g_signal_connect(t, "on-transaction-complete",
+                G_CALLBACK(load_complete), NULL);
+        g_object_unref(t);
+    }
+
+    g_idle_add(load_external_ack, NULL);
+
+    g_main_loop_run(loop);
+
+    elapsed = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+
+    printf("%d transactions, %d enforcement points: %.3f s (%.0f tx/s)\n",
+            LOAD_TRANSACTIONS, LOAD_EPS, elapsed,
+            elapsed > 0 ? LOAD_TRANSACTIONS / elapsed : 0.0);
+
+    fail_unless(completed_count == LOAD_TRANSACTIONS,
+            "Completed %d transactions", completed_count);
+    fail_unless(failed_count == 0,
+            "%d transactions were not fully acknowledged", failed_count);
+
+    for (i = 0; i < LOAD_EPS; i++) {
+        snprintf(uri, sizeof(uri), "%s-%d", (i % 2) ? "external" : "internal", i);
+        fail_unless(unregister_enforcement_point(uri), "Failed to unregister '%s'", uri);
+    }
+
+    fail_unless(deinit_signaling() == TRUE, "Deinit failed");
+
+END_TEST
+
+
+Suite *ohm_signaling_load_suite(void)
+{
+    Suite *suite = suite_create("ohm_signaling_load");
+
+    TCase *tc_all = tcase_create("Load");
+    tcase_add_checked_fixture(tc_all, setup, teardown);
+
+    tcase_add_test(tc_all, test_signaling_load);
+
+    tcase_set_timeout(tc_all, 300);
+    suite_add_tcase(suite, tc_all);
+
+    return suite;
+}
+
+int main (void) {
+
+    int failed = 0;
+    Suite *suite;
+
+    suite = ohm_signaling_load_suite();
+    SRunner *runner = srunner_create(suite);
+    srunner_set_xml(runner, "/tmp/result-load.xml");
+    srunner_run_all(runner, CK_NORMAL);
+
+    failed = srunner_ntests_failed(runner);
+    srunner_free(runner);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -426,8 +426,8 @@ bus_init(const char *address)
     if (!bus_add_match("signal", TP_CONFERENCE, MEMBER_CHANNEL_REMOVED, NULL))
         exit(1);
 
-    bus_query_name(TP_STREAMENGINE_NAME, se_name_query_cb, NULL);
     bus_track_name(TP_STREAMENGINE_NAME, TRUE);
+    bus_query_name(TP_STREAMENGINE_NAME, se_name_query_cb, NULL);
     
     if (!dbus_connection_add_filter(bus, dispatch_signal, NULL, NULL)) {
         OHM_ERROR("Failed to add DBUS filter for signal dispatching.");
@@ -662,8 +662,7 @@ bus_send(DBusMessage *msg, dbus_uint32_t *serial)
 static void
 bus_track_name(const char *name, int track)
 {
-    char       filter[1024];
-    DBusError  error;
+    char filter[1024];
 
     snprintf(filter, sizeof(filter),
              "type='signal',"
@@ -673,26 +672,13 @@ bus_track_name(const char *name, int track)
     
     /*
      * Notes:
-     *   We block when adding filters, to minimize (= eliminate ?) the time
-     *   window for the client to crash after it has let us know about itself
-     *   but before we managed to install the filter. According to the docs
-     *   we do not re-enter the main loop and all other messages than the
-     *   reply to AddMatch will get queued and processed once we're back in the
-     *   main loop. On the watch removal path we do not care about errors and
-     *   we do not want to block either.
+     *   We do not block for the reply to AddMatch. The bus handles our
+     *   requests in order, so an owner query sent after this one reflects
+     *   any owner change that happens before the match rule is in place.
      */
 
-    if (track) {
-        dbus_error_init(&error);
-
-        dbus_bus_add_match(bus, filter, &error);
-
-        if (dbus_error_is_set(&error)) {
-            OHM_ERROR("apptrack: failed to add match rule \"%s\": %s", filter,
-                      error.message);
-            dbus_error_free(&error);
-        }
-    }
+    if (track)
+        dbus_bus_add_match(bus, filter, NULL);
     else
         dbus_bus_remove_match(bus, filter, NULL);
 }
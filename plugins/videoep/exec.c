@@ -26,6 +26,7 @@ USA.
 #include <stdarg.h>
 #include <stdint.h>
 #include <errno.h>
+#include <time.h>
 
 #include "plugin.h"
 #include "exec.h"
@@ -33,6 +34,26 @@ USA.
 
 #define STRDUP(s)    (s) ? strdup(s) : NULL
 
+typedef struct exec_stat_s {
+    struct exec_stat_s  *next;
+    char                *name;
+    exec_type_t          type;
+    uint32_t             nexec;      /* number of executions */
+    uint32_t             nmerged;    /* requests merged with a pending one */
+    uint64_t             usecs;      /* total time spent executing */
+} exec_stat_t;
+
+static exec_inst_t **pending;        /* instances waiting for execution */
+static int           npending;
+static int           pending_dim;
+static guint         pending_srcid;
+static exec_stat_t  *stats;
+
+static int          same_execution(exec_inst_t *, exec_inst_t *);
+static void         cancel_execution(exec_inst_t *);
+static gboolean     pending_execute_cb(gpointer);
+static exec_stat_t *find_statistics(exec_def_t *);
+static uint64_t     usecs_now(void);
 
 
 /*! \addtogroup pubif
@@ -47,10 +68,35 @@ void exec_init(OhmPlugin *plugin)
 
 void exec_exit(OhmPlugin *plugin)
 {
+    exec_stat_t *st, *next;
+
     (void)plugin;
 
     ENTER;
 
+    if (pending_srcid)
+        g_source_remove(pending_srcid);
+
+    free(pending);
+
+    pending       = NULL;
+    npending      = 0;
+    pending_dim   = 0;
+    pending_srcid = 0;
+
+    for (st = stats;  st;  st = next) {
+        next = st->next;
+
+        OHM_INFO("videoep: %s '%s' executed %u times (%u merged), "
+                 "%llu usec total", exec_type_str(st->type), st->name,
+                 st->nexec, st->nmerged, (unsigned long long)st->usecs);
+
+        free(st->name);
+        free(st);
+    }
+
+    stats = NULL;
+
     LEAVE;
 }
 
@@ -289,6 +335,8 @@ void exec_instance_clear(exec_inst_t *inst)
 {
     exec_def_t *def;
 
+    cancel_execution(inst);
+
     if (inst != NULL && (def = inst->exdef) != NULL) {
 
         OHM_DEBUG(DBG_EXEC, "clear exec instance of %s %s",
@@ -321,14 +369,65 @@ void exec_instance_clear(exec_inst_t *inst)
     }
 }
 
+/*
+ * Queue an instance for execution once the main loop is idle. An
+ * instance that is already queued, or one that would resolve the same
+ * goal with the same arguments, is not queued again. The arguments are
+ * references to the tracked values, so the pending execution picks up
+ * the latest values when it eventually runs.
+ */
+int exec_instance_schedule(exec_inst_t *inst)
+{
+    exec_inst_t **p;
+    exec_stat_t  *st;
+    int           dim;
+    int           i;
+
+    if (inst == NULL || inst->exdef == NULL)
+        return FALSE;
+
+    for (i = 0;  i < npending;  i++) {
+        if (pending[i] != NULL && same_execution(pending[i], inst)) {
+            if ((st = find_statistics(inst->exdef)) != NULL)
+                st->nmerged++;
+
+            OHM_DEBUG(DBG_EXEC, "'%s' is already pending",
+                      inst->exdef->name ? inst->exdef->name : "");
+
+            return TRUE;
+        }
+    }
+
+    if (npending >= pending_dim) {
+        dim = pending_dim ? 2 * pending_dim : 16;
+
+        if ((p = realloc(pending, dim * sizeof(exec_inst_t *))) == NULL)
+            return exec_instance_execute(inst);
+
+        pending     = p;
+        pending_dim = dim;
+    }
+
+    pending[npending++] = inst;
+
+    if (!pending_srcid)
+        pending_srcid = g_idle_add(pending_execute_cb, NULL);
+
+    return TRUE;
+}
+
 int exec_instance_execute(exec_inst_t *inst)
 {
     exec_def_t      *def;
+    exec_stat_t     *st;
     argument_inst_t *ai;
+    uint64_t         start;
     int              sts;
     int              retval = FALSE;
 
     if (inst != NULL && (def = inst->exdef) != NULL) {
+        start = usecs_now();
+
         switch (def->type) {
 
         case exec_noexec:
@@ -363,6 +462,11 @@ int exec_instance_execute(exec_inst_t *inst)
             break;
         }
 
+        if ((st = find_statistics(def)) != NULL) {
+            st->nexec++;
+            st->usecs += usecs_now() - start;
+        }
+
         if (def->name == NULL) 
             OHM_DEBUG(DBG_EXEC, "execution %s", retval?"succeeded":"failed");
         else {
@@ -391,6 +495,104 @@ const char *exec_type_str(exec_type_t type)
  * @}
  */
 
+static int same_execution(exec_inst_t *a, exec_inst_t *b)
+{
+    exec_def_t *adef = a->exdef;
+    exec_def_t *bdef = b->exdef;
+    int         i;
+
+    if (a == b)
+        return TRUE;
+
+    if (adef->type != exec_resolver || bdef->type != exec_resolver)
+        return FALSE;
+
+    if (!adef->name || !bdef->name || strcmp(adef->name, bdef->name))
+        return FALSE;
+
+    if (adef->argc != bdef->argc)
+        return FALSE;
+
+    for (i = 0;  i < adef->argc;  i++) {
+        if (a->argv[i] != b->argv[i])
+            return FALSE;
+
+        if (a->argn[i] != b->argn[i] &&
+            (!a->argn[i] || !b->argn[i] || strcmp(a->argn[i], b->argn[i])))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* leaves a hole, as the queue might be being run right now */
+static void cancel_execution(exec_inst_t *inst)
+{
+    int i;
+
+    for (i = 0;  i < npending;  i++) {
+        if (pending[i] == inst)
+            pending[i] = NULL;
+    }
+}
+
+static gboolean pending_execute_cb(gpointer data)
+{
+    exec_inst_t *inst;
+    int          i;
+
+    (void)data;
+
+    /*
+     * executions can schedule further executions, which then get
+     * appended to the queue and run in the same pass
+     */
+    for (i = 0;  i < npending;  i++) {
+        if ((inst = pending[i]) != NULL)
+            exec_instance_execute(inst);
+    }
+
+    npending      = 0;
+    pending_srcid = 0;
+
+    return FALSE;
+}
+
+static exec_stat_t *find_statistics(exec_def_t *def)
+{
+    exec_stat_t *st;
+    const char  *name = def->name ? def->name : "<noexec>";
+
+    for (st = stats;  st;  st = st->next) {
+        if (st->type == def->type && !strcmp(st->name, name))
+            return st;
+    }
+
+    if ((st = malloc(sizeof(exec_stat_t))) != NULL) {
+        memset(st, 0, sizeof(exec_stat_t));
+
+        if ((st->name = strdup(name)) == NULL) {
+            free(st);
+            return NULL;
+        }
+
+        st->type = def->type;
+        st->next = stats;
+        stats    = st;
+    }
+
+    return st;
+}
+
+static uint64_t usecs_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
 
 
 
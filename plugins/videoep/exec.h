@@ -66,6 +66,7 @@ int  exec_instance_setup(exec_inst_t *, exec_def_t *);
 int  exec_instance_finalize(exec_inst_t *, uint32_t *);
 void exec_instance_clear(exec_inst_t *);
 int  exec_instance_execute(exec_inst_t *);
+int  exec_instance_schedule(exec_inst_t *);
 
 const char *exec_type_str(exec_type_t);
 
@@ -0,0 +1,239 @@
+/*************************************************************************
+Copyright (C) 2010 Nokia Corporation.
+
+These OHM Modules are free software; you can redistribute
+it and/or modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation
+version 2.1 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301
+USA.
+*************************************************************************/
+
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+
+#include "videostate.h"
+
+#ifndef TRUE
+#define FALSE 0
+#define TRUE  1
+#endif
+
+#define READ_TRIES  1000        /* attempts before videostate_read gives up */
+
+static size_t map_length(void);
+static int    futex(volatile uint32_t *, int, uint32_t, struct timespec *);
+
+
+videostate_t *videostate_open(const char *name, int writer)
+{
+    int           flags  = writer ? (O_RDWR | O_CREAT) : O_RDONLY;
+    int           prot   = writer ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    mode_t        mode   = S_IRUSR|S_IWUSR | S_IRGRP | S_IROTH; /* 644 */
+    size_t        length = map_length();
+    videostate_t *st     = NULL;
+    struct stat   sb;
+    int           fd;
+    int           err;
+
+    if (name == NULL)
+        name = VIDEOSTATE_SHARED_OBJECT;
+
+    if ((fd = shm_open(name, flags, mode)) < 0)
+        return NULL;
+
+    do { /* not a loop */
+        if (fstat(fd, &sb) < 0)
+            break;
+
+        if (sb.st_size < (off_t)length) {
+            if (!writer) {
+                errno = EINVAL;
+                break;
+            }
+
+            if (ftruncate(fd, length) < 0)
+                break;
+        }
+
+        if ((st = mmap(NULL, length, prot, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+            st = NULL;
+            break;
+        }
+
+        if (st->version != VIDEOSTATE_VERSION ||
+            st->size    != sizeof(videostate_t)  )
+        {
+            if (!writer) {
+                munmap((void *)st, length);
+                st = NULL;
+                errno = EINVAL;
+                break;
+            }
+
+            memset((void *)st, 0, sizeof(videostate_t));
+            st->version = VIDEOSTATE_VERSION;
+            st->size    = sizeof(videostate_t);
+        }
+        else if (writer && (st->seq & 1)) {
+            /* a previous writer died in the middle of an update */
+            st->seq++;
+            futex(&st->seq, FUTEX_WAKE, INT_MAX, NULL);
+        }
+
+    } while (0);
+
+    err = errno;
+    close(fd);
+    errno = err;
+
+    return st;
+}
+
+void videostate_close(videostate_t *st)
+{
+    if (st != NULL)
+        munmap((void *)st, map_length());
+}
+
+void videostate_write_begin(videostate_t *st)
+{
+    st->seq++;
+    __sync_synchronize();
+}
+
+void videostate_write_end(videostate_t *st)
+{
+    __sync_synchronize();
+    st->seq++;
+
+    futex(&st->seq, FUTEX_WAKE, INT_MAX, NULL);
+}
+
+uint32_t videostate_read(videostate_t *st, videostate_data_t *data)
+{
+    uint32_t seq;
+    int      tries;
+
+    for (tries = 0;  tries < READ_TRIES;  tries++) {
+        if ((seq = st->seq) & 1) {
+            sched_yield();
+            continue;
+        }
+
+        __sync_synchronize();
+        memcpy(data, (void *)&st->data, sizeof(videostate_data_t));
+        __sync_synchronize();
+
+        if (st->seq == seq)
+            return seq;
+    }
+
+    /* the writer is stuck in (or died during) an update */
+    errno = EAGAIN;
+
+    return st->seq | 1;
+}
+
+/*
+ * Wait until the sequence moves away from 'seq' (as returned by
+ * videostate_read()) or 'timeout' milliseconds elapse; a negative
+ * timeout waits forever. Wakeups and signals that leave the sequence
+ * unchanged resume the wait for the rest of the timeout. Returns 0 if
+ * there is something new to read, otherwise -1 with errno set to
+ * ETIMEDOUT.
+ */
+int videostate_wait(videostate_t *st, uint32_t seq, int timeout)
+{
+    struct timespec  deadline;
+    struct timespec  now;
+    struct timespec  ts;
+    struct timespec *tsp = NULL;
+
+    if (timeout >= 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+        deadline.tv_sec  += timeout / 1000;
+        deadline.tv_nsec += (timeout % 1000) * 1000000;
+
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        tsp = &ts;
+    }
+
+    while (st->seq == seq) {
+        if (tsp != NULL) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+
+            ts.tv_sec  = deadline.tv_sec  - now.tv_sec;
+            ts.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+
+            if (ts.tv_nsec < 0) {
+                ts.tv_sec--;
+                ts.tv_nsec += 1000000000;
+            }
+
+            if (ts.tv_sec < 0) {
+                errno = ETIMEDOUT;
+                return -1;
+            }
+        }
+
+        if (futex(&st->seq, FUTEX_WAIT, seq, tsp) < 0) {
+            if (errno == EAGAIN)
+                break;
+
+            if (errno != EINTR)
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+static size_t map_length(void)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+
+    return ((sizeof(videostate_t) + page - 1) / page) * page;
+}
+
+static int futex(volatile uint32_t *addr,int op,uint32_t val,struct timespec *ts)
+{
+    /* no FUTEX_PRIVATE_FLAG: the word lives in memory shared by processes */
+    return syscall(SYS_futex, addr, op, val, ts, NULL, 0);
+}
+
+
+/*
+ * Local Variables:
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ * vim:set expandtab shiftwidth=4:
+ */
@@ -0,0 +1,86 @@
+/*************************************************************************
+Copyright (C) 2010 Nokia Corporation.
+
+These OHM Modules are free software; you can redistribute
+it and/or modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation
+version 2.1 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301
+USA.
+*************************************************************************/
+
+/* libvideostate -- lock-free access to the video policy state */
+
+#ifndef __OHM_VIDEOSTATE_H__
+#define __OHM_VIDEOSTATE_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#define VIDEOSTATE_SHARED_OBJECT  "/ohm-videostate"
+#define VIDEOSTATE_VERSION        1
+
+#define VIDEOSTATE_XVIDEO_SECTION 0x01
+#define VIDEOSTATE_MAX_XV_USERS   32
+
+/*
+ * The segment is a seqlock: the writer makes 'seq' odd before it
+ * touches 'data' and even again when it is done. A reader copies 'data'
+ * and retries if 'seq' was odd or changed meanwhile. 'seq' is also the
+ * futex word readers sleep on, so local readers get woken up without
+ * going through the X server. Readers map the segment read-only.
+ */
+
+typedef struct {
+    uint32_t  mask;             /* sections changed by the last update */
+    uint64_t  time;             /* time of the last update in usecs */
+    int32_t   nxvuser;
+    pid_t     xvusers[VIDEOSTATE_MAX_XV_USERS];
+} videostate_data_t;
+
+typedef struct {
+    uint32_t            version;
+    uint32_t            size;    /* sizeof(videostate_t) of the writer */
+    volatile uint32_t   seq;
+    videostate_data_t   data;
+} videostate_t;
+
+
+/* NULL name means VIDEOSTATE_SHARED_OBJECT */
+videostate_t *videostate_open(const char *name, int writer);
+void          videostate_close(videostate_t *);
+
+/* writer side */
+void videostate_write_begin(videostate_t *);
+void videostate_write_end(videostate_t *);
+
+/*
+ * reader side: videostate_read() returns the (even) sequence of the
+ * copied data. If the writer stays in the middle of an update, eg. it
+ * died there, it gives up after a bounded number of attempts and returns
+ * an odd sequence with errno set to EAGAIN; the copy is not valid then.
+ * The odd sequence can be passed to videostate_wait() to sleep until a
+ * restarted writer completes the next update. videostate_wait() returns
+ * 0 when the sequence has moved on, or -1 with errno ETIMEDOUT.
+ */
+uint32_t videostate_read(videostate_t *, videostate_data_t *);
+int      videostate_wait(videostate_t *, uint32_t, int);
+
+
+#endif /* __OHM_VIDEOSTATE_H__ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ * vim:set expandtab shiftwidth=4:
+ */
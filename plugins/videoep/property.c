@@ -42,6 +42,8 @@ USA.
 #define PROPINST_BYTES_MAX     (PROPINST_ARRAY_MAX * sizeof(uint32_t))
 #define PROPINST_STRING_MAX    (PROPINST_ARRAY_MAX * sizeof(uint32_t))
 
+#define PROPINST_CHUNK         32     /* instances allocated at a time */
+
 typedef struct prop_inst_s {
     struct prop_inst_s  *next;
     struct prop_inst_s  *prev;
@@ -61,6 +63,7 @@ typedef struct prop_inst_s {
     }                    value;
     uint32_t             dim;
     uint32_t             hasvalue;
+    uint32_t             pending;       /* update query is scheduled */
     property_readycb_t   readycb;
     property_updatecb_t  updatecb;
 } prop_inst_t;
@@ -70,6 +73,11 @@ typedef struct {
     prop_inst_t         *last;
 } prop_insthd_t;
 
+typedef struct prop_chunk_s {
+    struct prop_chunk_s *next;
+    prop_inst_t          insts[PROPINST_CHUNK];
+} prop_chunk_t;
+
 typedef struct prop_def_s {
     uint32_t             index;
     const char          *id;            /* ie. the id of associated the atom */
@@ -85,6 +93,15 @@ static prop_def_t  *pids[PROPERTY_MAX]; /* definitions indexed by properies */
 static prop_inst_t *ihash[PROPINST_HASH_DIM]; /* instances */
 static uint32_t     ndef;
 static uint32_t     ninst;
+static prop_chunk_t *chunks;            /* instance arena */
+static prop_inst_t  *freeinst;          /* free instances in the arena */
+
+static uint32_t    *pending;            /* instances to be updated */
+static uint32_t     npending;
+static uint32_t     pending_dim;
+static guint        pending_srcid;
+static uint32_t     ncoalesced;         /* notifications merged */
+static uint32_t     nsuppressed;        /* updates with unchanged value */
 
 
 static void connection_state(int, void *);
@@ -100,9 +117,14 @@ static prop_def_t *find_property_definition_by_index(uint32_t);
 static prop_inst_t *create_instance(prop_def_t *, uint32_t,
                                     property_readycb_t, property_updatecb_t);
 static void         destroy_instance(prop_inst_t *);
+static prop_inst_t *alloc_instance(void);
+static void         free_instance(prop_inst_t *);
+static void         free_all_instances(void);
 static int          query_instance_value(prop_inst_t *);
 static prop_inst_t *find_instance_by_index(uint32_t);
 static void         print_instance_value(prop_inst_t *);
+static int          schedule_instance_update(prop_inst_t *);
+static gboolean     pending_update_cb(gpointer);
 
 static void update_xid(uint32_t, const char *, uint32_t, void *);
 static void update_value(uint32_t, uint32_t, videoep_value_type_t,
@@ -131,7 +153,22 @@ void property_exit(OhmPlugin *plugin)
 
     xif_remove_connection_callback(connection_state, NULL);
 
+    if (pending_srcid)
+        g_source_remove(pending_srcid);
+
+    free(pending);
+
+    pending       = NULL;
+    npending      = 0;
+    pending_dim   = 0;
+    pending_srcid = 0;
+
+    OHM_INFO("videoep: %u property change notifications coalesced, "
+             "%u updates with unchanged value suppressed",
+             ncoalesced, nsuppressed);
+
     destroy_all_property_definitions();
+    free_all_instances();
 }
 
 uint32_t property_definition_create(const char *id, videoep_value_type_t type)
@@ -202,8 +239,10 @@ uint32_t property_instance_create(uint32_t            index,
     if ((def = find_property_definition_by_index(index)) == NULL)
         idx = PROPERTY_INVALID_INDEX;
     else {
-        inst = create_instance(def, window, readycb, updatecb);
-        idx  = inst->index;
+        if ((inst = create_instance(def, window, readycb, updatecb)) == NULL)
+            return PROPERTY_INVALID_INDEX;
+
+        idx = inst->index;
 
         OHM_DEBUG(DBG_PROP, "property instance '%s' created for window 0x%x",
                   def->id, window);
@@ -214,6 +253,11 @@ uint32_t property_instance_create(uint32_t            index,
     return idx;
 }
 
+size_t property_instance_footprint(void)
+{
+    return sizeof(prop_inst_t);
+}
+
 void property_instance_destroy(uint32_t index)
 {
     prop_inst_t *inst;
@@ -252,7 +296,7 @@ int property_instance_update_value(uint32_t index)
     if ((inst = find_instance_by_index(index)) == NULL)
         status = -1;
     else
-        status = query_instance_value(inst);
+        status = schedule_instance_update(inst);
 
     return status;
 }
@@ -428,7 +472,7 @@ static prop_inst_t *create_instance(prop_def_t         *def,
     uint32_t     index;
     uint32_t     hidx;
 
-    if ((inst = malloc(sizeof(prop_inst_t))) != NULL) {
+    if ((inst = alloc_instance()) != NULL) {
         index = ninst++;
         hidx  = PROPINST_HASH_INDEX(index);
 
@@ -473,7 +517,54 @@ static void destroy_instance(prop_inst_t *inst)
         }
     }
 
-    free(inst);
+    free_instance(inst);
+}
+
+/*
+ * Instances live in chunks so that a window with a dozen tracked
+ * properties does not cost a dozen separate heap blocks.
+ */
+static prop_inst_t *alloc_instance(void)
+{
+    prop_chunk_t *chunk;
+    prop_inst_t  *inst;
+    int           i;
+
+    if (freeinst == NULL) {
+        if ((chunk = malloc(sizeof(prop_chunk_t))) == NULL)
+            return NULL;
+
+        chunk->next = chunks;
+        chunks = chunk;
+
+        for (i = PROPINST_CHUNK - 1;  i >= 0;  i--) {
+            chunk->insts[i].next = freeinst;
+            freeinst = chunk->insts + i;
+        }
+    }
+
+    inst = freeinst;
+    freeinst = inst->next;
+
+    return inst;
+}
+
+static void free_instance(prop_inst_t *inst)
+{
+    inst->next = freeinst;
+    freeinst = inst;
+}
+
+static void free_all_instances(void)
+{
+    prop_chunk_t *chunk;
+
+    while ((chunk = chunks) != NULL) {
+        chunks = chunk->next;
+        free(chunk);
+    }
+
+    freeinst = NULL;
 }
 
 static int query_instance_value(prop_inst_t *inst)
@@ -499,6 +590,63 @@ static int query_instance_value(prop_inst_t *inst)
     return sts;
 }
 
+/*
+ * Property notifications carry no value so the property needs to be
+ * queried. Notifications arriving within the same main loop iteration
+ * are merged into a single query.
+ */
+static int schedule_instance_update(prop_inst_t *inst)
+{
+    uint32_t *p;
+    uint32_t  dim;
+
+    if (inst->pending) {
+        ncoalesced++;
+        return 0;
+    }
+
+    if (npending >= pending_dim) {
+        dim = pending_dim ? 2 * pending_dim : 32;
+
+        if ((p = realloc(pending, dim * sizeof(uint32_t))) == NULL)
+            return query_instance_value(inst);
+
+        pending     = p;
+        pending_dim = dim;
+    }
+
+    pending[npending++] = inst->index;
+    inst->pending = TRUE;
+
+    if (!pending_srcid)
+        pending_srcid = g_idle_add_full(G_PRIORITY_HIGH, pending_update_cb,
+                                        NULL, NULL);
+
+    return 0;
+}
+
+static gboolean pending_update_cb(gpointer data)
+{
+    prop_inst_t *inst;
+    uint32_t     i;
+
+    (void)data;
+
+    pending_srcid = 0;
+
+    for (i = 0;  i < npending;  i++) {
+        /* instances might have been destroyed in the meantime */
+        if ((inst = find_instance_by_index(pending[i])) != NULL) {
+            inst->pending = FALSE;
+            query_instance_value(inst);
+        }
+    }
+
+    npending = 0;
+
+    return FALSE;
+}
+
 static prop_inst_t *find_instance_by_index(uint32_t index)
 {
     prop_inst_t *inst = NULL;
@@ -595,6 +743,7 @@ static void update_value(uint32_t              window,
     prop_def_t      *def  = inst->def;
     int              max  = sizeof(inst->value.string) - 1;
     size_t           count;
+    int              unchanged;
     videoep_value_t  pval;
     
     (void)property;
@@ -613,6 +762,25 @@ static void update_value(uint32_t              window,
     default:               /* illegal type */                           return;
     }
 
+    if (inst->hasvalue) {
+        if (type == videoep_string) {
+            unchanged = !strncmp(inst->value.string, value, count) &&
+                        inst->value.string[count] == '\0';
+        }
+        else {
+            unchanged = inst->dim == (uint32_t)length &&
+                        !memcmp(inst->value.bytes, value, count);
+        }
+
+        if (unchanged) {
+            nsuppressed++;
+
+            OHM_DEBUG(DBG_PROP, "window 0x%x property '%s' did not change",
+                      inst->window, def->id);
+            return;
+        }
+    }
+
     memcpy(inst->value.bytes, value, count);
 
     if (type != videoep_string)
@@ -22,6 +22,7 @@ USA.
 #define __OHM_VIDEOEP_PROPERTY_H__
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include "data-types.h"
 
@@ -54,6 +55,7 @@ uint32_t    property_definition_xid(uint32_t);
 uint32_t property_instance_create(uint32_t, uint32_t, property_readycb_t,
                                   property_updatecb_t);
 void     property_instance_destroy(uint32_t);
+size_t   property_instance_footprint(void);
 int      property_instance_get_value(uint32_t, videoep_value_type_t *,
                                      videoep_value_t *, uint32_t *);
 int      property_instance_update_value(uint32_t);
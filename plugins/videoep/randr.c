@@ -54,6 +54,8 @@ static randr_outprop_def_t *outprops;
 static statecb_slot_t      *statecbs;
 static int32_t              crtc_x;
 static int32_t              crtc_y;
+static uint32_t             nconfig;
+static uint32_t             nskipped;
 
 static void connection_state(int, void *);
 
@@ -81,6 +83,9 @@ static int             crtc_check_if_ready(randr_crtc_t *);
 static void            crtc_synchronize(randr_crtc_t *, int);
 static uint32_t        crtc_horizontal_position(randr_crtc_t *);
 static uint32_t        crtc_vertical_position(randr_crtc_t *);
+static int             crtc_state_differs(randr_crtc_t *, int32_t, int32_t);
+static void            crtc_state_save(randr_crtc_t *, int32_t, int32_t,
+                                       uint32_t, uint32_t, int, uint32_t *);
 static randr_crtc_t   *crtc_find_by_id(randr_screen_t *, uint32_t);
 
 static randr_output_t *output_register(randr_screen_t *, uint32_t);
@@ -89,6 +94,8 @@ static void            output_reset(randr_output_t *);
 static void            output_query(uint32_t, uint32_t, uint32_t);
 static void            output_query_finish(xif_output_t *, void *);
 static void            output_changed(xif_output_t *, void *);
+static void            output_property_changed(uint32_t, uint32_t, uint32_t,
+                                               void *);
 static void            output_update(xif_output_t *, void *);
 static int             output_check_if_ready(randr_output_t *);
 static void            output_synchronize(randr_output_t *);
@@ -108,6 +115,8 @@ static void                  outprop_instance_update_value(uint32_t, uint32_t,
                                                            uint32_t,
                                                           videoep_value_type_t,
                                                            void *,int, void *);
+static int                   outprop_value_equal(videoep_value_type_t,
+                                                 void *, void *);
 static randr_outprop_inst_t *outprop_instance_find_by_name(randr_output_t *,
                                                            char *);
 
@@ -137,6 +146,7 @@ void randr_init(OhmPlugin *plugin)
     xif_add_connection_callback(connection_state, NULL);
     xif_add_randr_crtc_change_callback(crtc_changed, NULL);
     xif_add_randr_output_change_callback(output_changed, NULL);
+    xif_add_randr_outprop_change_callback(output_property_changed, NULL);
 
     LEAVE;
 }
@@ -148,6 +158,10 @@ void randr_exit(OhmPlugin *plugin)
     xif_remove_connection_callback(connection_state, NULL);
     xif_remove_randr_crtc_change_callback(crtc_changed, NULL);
     xif_remove_randr_output_change_callback(output_changed, NULL);
+    xif_remove_randr_outprop_change_callback(output_property_changed, NULL);
+
+    OHM_INFO("videoep: randr requested %u changes, skipped %u unchanged ones",
+             nconfig, nskipped);
 }
 
 int randr_add_state_callback(randr_statecb_t cb, void *data)
@@ -367,6 +381,15 @@ void randr_output_change_property(char *outnam, char *propnam, void *value)
             if ((inst = outprop_instance_find_by_name(output, propnam))) {
                 def = inst->def;
 
+                if (inst->known &&
+                    outprop_value_equal(def->type, &inst->value, value))
+                {
+                    OHM_DEBUG(DBG_RANDR, "output 0x%x property '%s' value "
+                              "is unchanged", output->xid, def->id);
+                    nskipped++;
+                    continue;
+                }
+
                 switch (def->type) {
                 case videoep_atom:
                     inst->value.atom = *(uint32_t *)value;
@@ -389,7 +412,12 @@ void randr_output_change_property(char *outnam, char *propnam, void *value)
                           print_propval(def->type, &inst->value,
                                         buf, sizeof(buf)));
 
+                /*
+                 * the server might still reject the change; the value is
+                 * known again when a query reply reports it
+                 */
                 inst->hasvalue = TRUE;
+                inst->known    = FALSE;
                 inst->sync     = TRUE;
 
                 output->sync = TRUE;
@@ -732,6 +760,7 @@ static void crtc_reset(randr_crtc_t *crtc)
         screen = crtc->screen;
 
         free(crtc->possibles);
+        free(crtc->applied.outputs);
 
         memset(crtc, 0, sizeof(randr_crtc_t));
 
@@ -755,6 +784,8 @@ static void crtc_disable(randr_crtc_t *randr_crtc)
 
     xif_crtc_config(screen->tstamp, &xif_crtc);
 
+    randr_crtc->applied.valid = FALSE;
+
     if (randr_crtc->width && randr_crtc->height &&
         randr_crtc->mode  && randr_crtc->noutput)
     {
@@ -832,6 +863,8 @@ static void crtc_query_finish(xif_crtc_t *xif_crtc, void *usrdata)
     randr_crtc->npossible = xif_crtc->npossible;
     randr_crtc->possibles = possibles;
 
+    crtc_state_save(randr_crtc, xif_crtc->x, xif_crtc->y, xif_crtc->mode,
+                    xif_crtc->rotation, xif_crtc->noutput, xif_crtc->outputs);
 
     OHM_DEBUG(DBG_RANDR, "crtc 0x%x query complete for rootwin 0x%x "
               "position %d,%d size %ux%u outputs %s/%s",
@@ -864,6 +897,9 @@ static void crtc_changed(xif_crtc_t *xif_crtc, void *usrdata)
         randr_crtc->mode      = xif_crtc->mode;
         randr_crtc->rotation  = xif_crtc->rotation;
 
+        /* outputs arrive with the update; until then the state is unknown */
+        randr_crtc->applied.valid = FALSE;
+
         OHM_DEBUG(DBG_RANDR, "crtc 0x%x changed rootwin 0x%x "
                   "position %d,%d size %ux%u", xif_crtc->xid, xif_crtc->window,
                   xif_crtc->x, xif_crtc->y, xif_crtc->width, xif_crtc->height);
@@ -935,6 +971,9 @@ static void crtc_update(xif_crtc_t *xif_crtc, void *usrdata)
     randr_crtc->npossible = xif_crtc->npossible;
     randr_crtc->possibles = possibles;
 
+    crtc_state_save(randr_crtc, xif_crtc->x, xif_crtc->y, xif_crtc->mode,
+                    xif_crtc->rotation, xif_crtc->noutput, xif_crtc->outputs);
+
     OHM_DEBUG(DBG_RANDR, "crtc 0x%x updated for rootwin 0x%x outputs %s/%s",
               xif_crtc->xid, xif_crtc->window,
               print_xids(xif_crtc->noutput,xif_crtc->outputs,ob,sizeof(ob)),
@@ -957,6 +996,14 @@ static void crtc_synchronize(randr_crtc_t *randr_crtc, int dryrun)
     x = crtc_horizontal_position(randr_crtc);
     y = crtc_vertical_position(randr_crtc);
 
+    if (randr_crtc->sync && !dryrun && !crtc_state_differs(randr_crtc,x,y)) {
+        OHM_DEBUG(DBG_RANDR, "crtc 0x%x is already in the requested state",
+                  randr_crtc->xid);
+
+        randr_crtc->sync = FALSE;
+        nskipped++;
+    }
+
     if (randr_crtc->sync && !dryrun) {
         
         OHM_DEBUG(DBG_RANDR, "synchronizing crtc 0x%x on root window 0x%x "
@@ -980,7 +1027,15 @@ static void crtc_synchronize(randr_crtc_t *randr_crtc, int dryrun)
         xif_crtc.noutput  = randr_crtc->noutput;
         xif_crtc.outputs  = randr_crtc->outputs;
 
-        xif_crtc_config(screen->tstamp, &xif_crtc);
+        /*
+         * the request is only queued here and the server might still
+         * reject it; the applied state is saved again by crtc_update()
+         * once the server reports the new configuration
+         */
+        randr_crtc->applied.valid = FALSE;
+
+        if (xif_crtc_config(screen->tstamp, &xif_crtc) == 0)
+            nconfig++;
 
         randr_crtc->sync = FALSE;
     }
@@ -1015,6 +1070,62 @@ static uint32_t crtc_vertical_position(randr_crtc_t *crtc)
     return y;
 }
 
+static int crtc_state_differs(randr_crtc_t *crtc, int32_t x, int32_t y)
+{
+    randr_crtc_state_t *applied = &crtc->applied;
+    size_t              size;
+
+    if (!applied->valid                      ||
+        applied->x        != x               ||
+        applied->y        != y               ||
+        applied->mode     != crtc->mode      ||
+        applied->rotation != crtc->rotation  ||
+        applied->noutput  != crtc->noutput     )
+    {
+        return TRUE;
+    }
+
+    size = sizeof(uint32_t) * crtc->noutput;
+
+    if (size && memcmp(applied->outputs, crtc->outputs, size))
+        return TRUE;
+
+    return FALSE;
+}
+
+static void crtc_state_save(randr_crtc_t *crtc,
+                            int32_t       x,
+                            int32_t       y,
+                            uint32_t      mode,
+                            uint32_t      rotation,
+                            int           noutput,
+                            uint32_t     *outputs)
+{
+    randr_crtc_state_t *applied = &crtc->applied;
+    uint32_t           *copy;
+    size_t              size;
+
+    applied->valid = FALSE;
+
+    if (noutput < 0 || (noutput > 0 && outputs == NULL))
+        return;
+
+    if ((size = sizeof(uint32_t) * noutput) > 0) {
+        if ((copy = realloc(applied->outputs, size)) == NULL)
+            return;
+
+        memcpy(copy, outputs, size);
+        applied->outputs = copy;
+    }
+
+    applied->valid    = TRUE;
+    applied->x        = x;
+    applied->y        = y;
+    applied->mode     = mode;
+    applied->rotation = rotation;
+    applied->noutput  = noutput;
+}
+
 static randr_crtc_t *crtc_find_by_id(randr_screen_t *screen,uint32_t xid)
 {
     randr_crtc_t *crtc;
@@ -1200,6 +1311,36 @@ static void output_changed(xif_output_t *xif_output, void *usrdata)
     }
 }
 
+/*
+ * Someone, possibly us, changed an output property. Whatever value was
+ * known before is stale, so it is read again from the server.
+ */
+static void output_property_changed(uint32_t  rootwin,
+                                    uint32_t  output,
+                                    uint32_t  property,
+                                    void     *usrdata)
+{
+    randr_screen_t       *screen;
+    randr_output_t       *randr_output;
+    randr_outprop_inst_t *inst;
+
+    (void)usrdata;
+
+    if ((screen       = screen_find_by_rootwin(rootwin))   != NULL &&
+        (randr_output = output_find_by_id(screen, output)) != NULL   )
+    {
+        for (inst = randr_output->props;  inst;  inst = inst->next) {
+            if (inst->def->xid == property) {
+                OHM_DEBUG(DBG_RANDR, "output 0x%x property '%s' changed",
+                          output, inst->def->id);
+
+                inst->known = FALSE;
+                outprop_instance_query(inst);
+            }
+        }
+    }
+}
+
 static void output_update(xif_output_t *xif_output, void *usrdata)
 {
     randr_screen_t *screen;
@@ -1555,12 +1696,26 @@ static void outprop_instance_update_value(uint32_t              rootwin,
             return;              /* we should never got here */
         }
 
+        prop->known = TRUE;
+
         OHM_DEBUG(DBG_RANDR, "output 0x%x property '%s' value updated to %s",
                   prop->output->xid, def->id,
                   print_propval(def->type,&prop->value, buf,sizeof(buf)));
     }
 }
 
+static int outprop_value_equal(videoep_value_type_t type,
+                               void                *current,
+                               void                *value)
+{
+    switch (type) {
+    case videoep_atom:   return *(uint32_t *)current == *(uint32_t *)value;
+    case videoep_card:   return *(int32_t *)current == *(int32_t *)value;
+    case videoep_string: return !strcmp((char *)current, *(char **)value);
+    default:             return FALSE;
+    }
+}
+
 static randr_outprop_inst_t *
 outprop_instance_find_by_name(randr_output_t *output, char *propname)
 {
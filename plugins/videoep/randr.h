@@ -62,6 +62,16 @@ typedef struct randr_outprop_def_s {
     char                      **outputs;
 } randr_outprop_def_t;
 
+typedef struct {
+    int                    valid;
+    int32_t                x;
+    int32_t                y;
+    uint32_t               mode;
+    uint32_t               rotation;
+    int                    noutput;
+    uint32_t              *outputs;
+} randr_crtc_state_t;           /* last configuration known to the server */
+
 typedef struct {
     struct randr_screen_s *screen;
     int                    ready;
@@ -79,6 +89,7 @@ typedef struct {
     uint32_t              *outputs;
     int                    npossible;
     uint32_t              *possibles;
+    randr_crtc_state_t     applied;
 } randr_crtc_t;
 
 typedef struct {
@@ -121,6 +132,7 @@ typedef struct randr_outprop_inst_s {
         char     string[256];
     }                            value;
     int                          hasvalue;
+    int                          known;  /* value was read from the server */
 } randr_outprop_inst_t;
 
 typedef struct randr_output_s {
@@ -102,6 +102,7 @@ static char       *ratio;
 static int32_t     cards[CARD_MAX];
 static uint32_t    atoms[ATOM_MAX];
 static sequence_t *sequences[router_seq_max];
+static sequence_t *selected[router_seq_max];
 
 static void randr_state(int, void *);
 
@@ -111,7 +112,8 @@ static void config_ratio(char *);
 
 static void update_atom_value(uint32_t, const char *, uint32_t, void *);
 
-static void execute_sequence(router_seq_type_t, const char *);
+static sequence_t *select_sequence(router_seq_type_t, const char *);
+static void        execute_sequence(router_seq_type_t);
 
 static function_type_t function_name_to_type(const char *);
 
@@ -361,26 +363,40 @@ static void randr_state(int ready, void *data)
     if (ready) {
         OHM_DEBUG(DBG_ROUTE, "randr is ready");
 
-        config_device(device);
-        config_tvstd(tvstd);
-        config_ratio(ratio);
+        /*
+         * sequences are defined by the configuration after router_init(),
+         * so resolve whatever was not resolved yet
+         */
+        if (!selected[router_seq_device])
+            select_sequence(router_seq_device, device);
+        if (!selected[router_seq_signal])
+            select_sequence(router_seq_signal, tvstd);
+        if (!selected[router_seq_ratio])
+            select_sequence(router_seq_ratio, ratio);
+
+        execute_sequence(router_seq_device);
+        execute_sequence(router_seq_signal);
+        execute_sequence(router_seq_ratio);
         randr_synchronize();
     }
 }
 
 static void config_device(char *device)
 {
-    execute_sequence(router_seq_device, device);
+    select_sequence(router_seq_device, device);
+    execute_sequence(router_seq_device);
 }
 
 static void config_tvstd(char *tvstd)
 {
-    execute_sequence(router_seq_signal, tvstd);
+    select_sequence(router_seq_signal, tvstd);
+    execute_sequence(router_seq_signal);
 }
 
 static void config_ratio(char *ratio)
 {
-    execute_sequence(router_seq_ratio, ratio);
+    select_sequence(router_seq_ratio, ratio);
+    execute_sequence(router_seq_ratio);
 }
 
 static void update_atom_value(uint32_t    idx,
@@ -395,7 +411,30 @@ static void update_atom_value(uint32_t    idx,
     OHM_DEBUG(DBG_RANDR, "atom '%s' value set to 0x%x", id, value);
 }
 
-static void execute_sequence(router_seq_type_t type, const char *id)
+static sequence_t *select_sequence(router_seq_type_t type, const char *id)
+{
+    sequence_t *seq = NULL;
+
+    if (type >= 0 && type < router_seq_max) {
+        if (id != NULL) {
+            for (seq = sequences[type];   seq;   seq = seq->next) {
+                if (!strcmp(id, seq->id))
+                    break;
+            }
+        }
+
+        if (seq == NULL) {
+            OHM_DEBUG(DBG_ROUTE, "no %s sequence for '%s'",
+                      sequence_type_str(type), id ? id : "<null>");
+        }
+
+        selected[type] = seq;
+    }
+
+    return seq;
+}
+
+static void execute_sequence(router_seq_type_t type)
 {
     sequence_t               *seq;
     function_t               *func;
@@ -405,66 +444,60 @@ static void execute_sequence(router_seq_type_t type, const char *id)
     output_change_property_t *chprop;
     char                      buf[256];
 
-    if (type >= 0 && type < router_seq_max && id != NULL) {
-        for (seq = sequences[type];   seq;   seq = seq->next) {
-            if (!strcmp(id, seq->id)) {
-                OHM_DEBUG(DBG_ROUTE, "executing sequence '%s'", id);
-
-                for (func = seq->funcs;  func;  func = func->any.next) {
-                    switch (func->any.type) {
-
-                    case function_crtc_set_position:
-                        cpos = &func->crtc_set_position;
-                        OHM_DEBUG(DBG_ROUTE, "   randr_crtc_set_position("
-                                  "%d, %d, %lu,%lu)", cpos->screen_id,
-                                  cpos->crtc_id, cpos->x, cpos->y);
-                        randr_crtc_set_position(cpos->screen_id, cpos->crtc_id,
-                                                cpos->x, cpos->y);
-                        break;
-
-                    case function_crtc_set_mode:
-                        cmode = &func->crtc_set_mode;
-                        OHM_DEBUG(DBG_ROUTE, "   randr_crtc_set_mode("
-                                  "%d, %d, '%s')", cmode->screen_id,
-                                  cmode->crtc_id, cmode->modname);
-                        randr_crtc_set_mode(cmode->screen_id, cmode->crtc_id,
-                                            cmode->modname);
-                        break;
-
-                    case function_crtc_set_outputs:
-                        cout = &func->crtc_set_outputs_t;
-                        print_string_array(cout->noutput, cout->outnames,
-                                           buf, sizeof(buf));
-                        OHM_DEBUG(DBG_ROUTE, "  randr_crtc_set_outputs("
-                                  "%d, %d, %d, %s)", cout->screen_id,
-                                  cout->crtc_id, cout->noutput, buf);
-                        randr_crtc_set_outputs(cout->screen_id, cout->crtc_id,
-                                               cout->noutput, cout->outnames);
-                        break;
-
-                    case function_output_change_property:
-                        chprop = &func->output_change_property;
-                        print_value(chprop->valtyp, chprop->value,
-                                    ", ", buf,sizeof(buf));
-                        OHM_DEBUG(DBG_ROUTE, "  randr_output_change_property("
-                                  "'%s', '%s', %s)",
-                                  chprop->outnam, chprop->propnam, buf);
-                        randr_output_change_property(chprop->outnam,
-                                                     chprop->propnam,
-                                                     chprop->value.generic);
-                        break;
-
-                    default:
-                        OHM_DEBUG(DBG_ROUTE, "invalid function type in "
-                                  "sequence '%s'", id);
-                        break;
-                    }
-                }
-
-                return;
+    if (type >= 0 && type < router_seq_max && (seq = selected[type]) != NULL) {
+        OHM_DEBUG(DBG_ROUTE, "executing sequence '%s'", seq->id);
+
+        for (func = seq->funcs;  func;  func = func->any.next) {
+            switch (func->any.type) {
+
+            case function_crtc_set_position:
+                cpos = &func->crtc_set_position;
+                OHM_DEBUG(DBG_ROUTE, "   randr_crtc_set_position("
+                          "%d, %d, %lu,%lu)", cpos->screen_id,
+                          cpos->crtc_id, cpos->x, cpos->y);
+                randr_crtc_set_position(cpos->screen_id, cpos->crtc_id,
+                                        cpos->x, cpos->y);
+                break;
+
+            case function_crtc_set_mode:
+                cmode = &func->crtc_set_mode;
+                OHM_DEBUG(DBG_ROUTE, "   randr_crtc_set_mode("
+                          "%d, %d, '%s')", cmode->screen_id,
+                          cmode->crtc_id, cmode->modname);
+                randr_crtc_set_mode(cmode->screen_id, cmode->crtc_id,
+                                    cmode->modname);
+                break;
+
+            case function_crtc_set_outputs:
+                cout = &func->crtc_set_outputs_t;
+                print_string_array(cout->noutput, cout->outnames,
+                                   buf, sizeof(buf));
+                OHM_DEBUG(DBG_ROUTE, "  randr_crtc_set_outputs("
+                          "%d, %d, %d, %s)", cout->screen_id,
+                          cout->crtc_id, cout->noutput, buf);
+                randr_crtc_set_outputs(cout->screen_id, cout->crtc_id,
+                                       cout->noutput, cout->outnames);
+                break;
+
+            case function_output_change_property:
+                chprop = &func->output_change_property;
+                print_value(chprop->valtyp, chprop->value,
+                            ", ", buf,sizeof(buf));
+                OHM_DEBUG(DBG_ROUTE, "  randr_output_change_property("
+                          "'%s', '%s', %s)",
+                          chprop->outnam, chprop->propnam, buf);
+                randr_output_change_property(chprop->outnam,
+                                             chprop->propnam,
+                                             chprop->value.generic);
+                break;
+
+            default:
+                OHM_DEBUG(DBG_ROUTE, "invalid function type in "
+                          "sequence '%s'", seq->id);
+                break;
             }
         }
-    }    
+    }
 }
 
 static function_type_t function_name_to_type(const char *name)
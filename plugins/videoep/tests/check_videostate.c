@@ -0,0 +1,294 @@
+/*************************************************************************
+Copyright (C) 2010 Nokia Corporation.
+
+These OHM Modules are free software; you can redistribute
+it and/or modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation
+version 2.1 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301
+USA.
+*************************************************************************/
+
+
+/**
+ * @file check_videostate.c
+ * @brief videoep shared state seqlock test
+ *
+ * Hammers the shared video state with back-to-back updates while
+ * several readers, each with a mapping of its own, check that every
+ * snapshot they get is consistent.
+ */
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "videostate.h"
+
+#ifndef TRUE
+#define FALSE 0
+#define TRUE  1
+#endif
+
+#define TEST_OBJECT   "/ohm-videostate-test"
+#define TEST_UPDATES  200000
+#define TEST_READERS  4
+
+typedef struct {
+    pthread_t  thread;
+    int        nread;
+    int        ntorn;
+} reader_t;
+
+static videostate_t *writer;
+static volatile int  done;
+
+
+static void fill(videostate_data_t *data, uint64_t n)
+{
+    int i;
+
+    data->mask    = VIDEOSTATE_XVIDEO_SECTION;
+    data->time    = n;
+    data->nxvuser = 1 + (n % VIDEOSTATE_MAX_XV_USERS);
+
+    for (i = 0;  i < data->nxvuser;  i++)
+        data->xvusers[i] = (pid_t)(n + i);
+}
+
+static int consistent(videostate_data_t *data)
+{
+    int i;
+
+    if (data->nxvuser != (int32_t)(1 + (data->time % VIDEOSTATE_MAX_XV_USERS)))
+        return FALSE;
+
+    for (i = 0;  i < data->nxvuser;  i++) {
+        if (data->xvusers[i] != (pid_t)(data->time + i))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void *read_loop(void *arg)
+{
+    reader_t          *reader = arg;
+    videostate_t      *st;
+    videostate_data_t  data;
+
+    if ((st = videostate_open(TEST_OBJECT, FALSE)) == NULL) {
+        reader->ntorn = -1;
+        return NULL;
+    }
+
+    while (!done) {
+        if (videostate_read(st, &data) & 1)
+            continue;           /* gave up on a busy writer, no snapshot */
+
+        if (!consistent(&data))
+            reader->ntorn++;
+
+        reader->nread++;
+    }
+
+    videostate_close(st);
+
+    return NULL;
+}
+
+static void setup(void)
+{
+    videostate_data_t data;
+
+    shm_unlink(TEST_OBJECT);
+
+    writer = videostate_open(TEST_OBJECT, TRUE);
+    fail_unless(writer != NULL, "Can't create '%s': %s",
+                TEST_OBJECT, strerror(errno));
+
+    fill(&data, 0);
+
+    videostate_write_begin(writer);
+    writer->data = data;
+    videostate_write_end(writer);
+}
+
+static void teardown(void)
+{
+    videostate_close(writer);
+    shm_unlink(TEST_OBJECT);
+}
+
+/*
+ * test_videostate_snapshot
+ *
+ * A single update must be seen by a reader as a whole, with an even
+ * sequence number that moved on from the previous one.
+ */
+
+START_TEST (test_videostate_snapshot)
+
+    videostate_t      *st;
+    videostate_data_t  data;
+    uint32_t           seq, next;
+
+    st = videostate_open(TEST_OBJECT, FALSE);
+    fail_unless(st != NULL, "Can't open '%s'", TEST_OBJECT);
+
+    seq = videostate_read(st, &data);
+    fail_unless((seq & 1) == 0, "Odd sequence %u after update", seq);
+    fail_unless(consistent(&data) && data.time == 0, "Bad initial snapshot");
+
+    videostate_write_begin(writer);
+    fill(&writer->data, 42);
+    videostate_write_end(writer);
+
+    fail_unless(videostate_wait(st, seq, 0) == 0, "Update was not noticed");
+
+    next = videostate_read(st, &data);
+    fail_unless(next == seq + 2, "Sequence %u after %u", next, seq);
+    fail_unless(consistent(&data) && data.time == 42, "Bad snapshot");
+
+    fail_unless(videostate_wait(st, next, 10) < 0 && errno == ETIMEDOUT,
+                "Wait without update did not time out");
+
+    videostate_close(st);
+
+END_TEST
+
+/*
+ * test_videostate_stuck_writer
+ *
+ * A writer that never finishes its update must not block the readers
+ * forever: the read gives up with an odd sequence, and the wait on it
+ * returns once a new writer has repaired the segment.
+ */
+
+START_TEST (test_videostate_stuck_writer)
+
+    videostate_t      *st;
+    videostate_t      *restarted;
+    videostate_data_t  data;
+    uint32_t           seq;
+
+    st = videostate_open(TEST_OBJECT, FALSE);
+    fail_unless(st != NULL, "Can't open '%s'", TEST_OBJECT);
+
+    videostate_write_begin(writer);
+
+    seq = videostate_read(st, &data);
+    fail_unless((seq & 1) && errno == EAGAIN,
+                "Read with a stuck writer returned sequence %u", seq);
+
+    restarted = videostate_open(TEST_OBJECT, TRUE);
+    fail_unless(restarted != NULL, "Can't reopen '%s' for writing",
+                TEST_OBJECT);
+
+    fail_unless(videostate_wait(st, seq, 0) == 0,
+                "Repaired segment was not noticed");
+    fail_unless((videostate_read(st, &data) & 1) == 0,
+                "Odd sequence after the segment was repaired");
+
+    videostate_close(restarted);
+    videostate_close(st);
+
+END_TEST
+
+/*
+ * test_videostate_hammer
+ *
+ * Do TEST_UPDATES updates as fast as possible with TEST_READERS
+ * concurrent readers and check that none of them got a torn snapshot.
+ */
+
+START_TEST (test_videostate_hammer)
+
+    reader_t  readers[TEST_READERS];
+    uint64_t  n;
+    int       nread;
+    int       i;
+
+    memset(readers, 0, sizeof(readers));
+    done = FALSE;
+
+    for (i = 0;  i < TEST_READERS;  i++) {
+        fail_unless(pthread_create(&readers[i].thread, NULL,
+                                   read_loop, readers + i) == 0,
+                    "Can't create reader %d", i);
+    }
+
+    for (n = 1;  n <= TEST_UPDATES;  n++) {
+        videostate_write_begin(writer);
+        fill(&writer->data, n);
+        videostate_write_end(writer);
+    }
+
+    done = TRUE;
+
+    for (i = 0, nread = 0;  i < TEST_READERS;  i++) {
+        pthread_join(readers[i].thread, NULL);
+
+        fail_unless(readers[i].ntorn == 0, "Reader %d saw %d torn snapshots",
+                    i, readers[i].ntorn);
+
+        nread += readers[i].nread;
+    }
+
+    printf("%d updates, %d readers: %d consistent snapshots\n",
+           TEST_UPDATES, TEST_READERS, nread);
+
+END_TEST
+
+
+Suite *ohm_videostate_suite(void)
+{
+    Suite *suite = suite_create("ohm_videostate");
+
+    TCase *tc_all = tcase_create("Videostate");
+    tcase_add_checked_fixture(tc_all, setup, teardown);
+
+    tcase_add_test(tc_all, test_videostate_snapshot);
+    tcase_add_test(tc_all, test_videostate_stuck_writer);
+    tcase_add_test(tc_all, test_videostate_hammer);
+
+    tcase_set_timeout(tc_all, 120);
+    suite_add_tcase(suite, tc_all);
+
+    return suite;
+}
+
+int main (void) {
+
+    int failed = 0;
+    Suite *suite;
+
+    suite = ohm_videostate_suite();
+    SRunner *runner = srunner_create(suite);
+    srunner_set_xml(runner, "/tmp/result-videostate.xml");
+    srunner_run_all(runner, CK_NORMAL);
+
+    failed = srunner_ntests_failed(runner);
+    srunner_free(runner);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ * vim:set expandtab shiftwidth=4:
+ */
@@ -0,0 +1,268 @@
+/*************************************************************************
+Copyright (C) 2010 Nokia Corporation.
+
+These OHM Modules are free software; you can redistribute
+it and/or modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation
+version 2.1 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301
+USA.
+*************************************************************************/
+
+
+/**
+ * @file xvfb-bench.c
+ * @brief window and property churn for benchmarking videoep
+ *
+ * Plays a window manager against a (virtual) X server: creates a number
+ * of top level windows, publishes them in _NET_CLIENT_LIST and then keeps
+ * switching _NET_ACTIVE_WINDOW between them while also touching properties
+ * videoep is not interested in. The plugin side of the numbers is in the
+ * statistics videoep logs when ohmd exits; see xvfb-bench.sh.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <xcb/xcb.h>
+#include <xcb/xproto.h>
+
+#define DEFAULT_WINDOWS  16
+#define DEFAULT_ROUNDS   5000
+#define SYNC_INTERVAL    50     /* changes between round trips */
+
+enum {
+    NET_CLIENT_LIST = 0,
+    NET_ACTIVE_WINDOW,
+    NET_WM_PID,
+    WM_CLASS,
+    NOISE,
+    NATOM
+};
+
+static const char *atom_names[NATOM] = {
+    "_NET_CLIENT_LIST",
+    "_NET_ACTIVE_WINDOW",
+    "_NET_WM_PID",
+    "WM_CLASS",
+    "_VIDEOEP_BENCH_NOISE"
+};
+
+static xcb_connection_t *xconn;
+static xcb_window_t      root;
+static xcb_atom_t        atoms[NATOM];
+
+static uint32_t nsync;          /* round trips done */
+static double   synctime;       /* time spent in round trips */
+static double   syncmax;        /* longest round trip */
+
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void sync_with_server(void)
+{
+    xcb_get_input_focus_reply_t *reply;
+    double start, elapsed;
+
+    start = now();
+
+    reply = xcb_get_input_focus_reply(xconn, xcb_get_input_focus(xconn), NULL);
+    free(reply);
+
+    elapsed = now() - start;
+
+    nsync++;
+    synctime += elapsed;
+
+    if (elapsed > syncmax)
+        syncmax = elapsed;
+}
+
+static int intern_atoms(void)
+{
+    xcb_intern_atom_cookie_t  cookies[NATOM];
+    xcb_intern_atom_reply_t  *reply;
+    int i;
+
+    for (i = 0;  i < NATOM;  i++) {
+        cookies[i] = xcb_intern_atom(xconn, 0, strlen(atom_names[i]),
+                                     atom_names[i]);
+    }
+
+    for (i = 0;  i < NATOM;  i++) {
+        if ((reply = xcb_intern_atom_reply(xconn, cookies[i], NULL)) == NULL) {
+            fprintf(stderr, "can't intern atom '%s'\n", atom_names[i]);
+            return -1;
+        }
+
+        atoms[i] = reply->atom;
+        free(reply);
+    }
+
+    return 0;
+}
+
+static void set_cardinal(xcb_window_t win, xcb_atom_t prop, uint32_t value)
+{
+    xcb_change_property(xconn, XCB_PROP_MODE_REPLACE, win, prop,
+                        XCB_ATOM_CARDINAL, 32, 1, &value);
+}
+
+static void set_window(xcb_window_t win, xcb_atom_t prop,
+                       xcb_window_t *list, uint32_t length)
+{
+    xcb_change_property(xconn, XCB_PROP_MODE_REPLACE, win, prop,
+                        XCB_ATOM_WINDOW, 32, length, list);
+}
+
+static xcb_window_t create_window(uint32_t idx)
+{
+    static const char class[] = "application-window";
+
+    xcb_window_t win = xcb_generate_id(xconn);
+
+    xcb_create_window(xconn, XCB_COPY_FROM_PARENT, win, root,
+                      0, 0, 64, 64, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      XCB_COPY_FROM_PARENT, 0, NULL);
+
+    set_cardinal(win, atoms[NET_WM_PID], getpid() + idx);
+
+    xcb_change_property(xconn, XCB_PROP_MODE_REPLACE, win, atoms[WM_CLASS],
+                        XCB_ATOM_STRING, 8, sizeof(class) - 1, class);
+
+    xcb_map_window(xconn, win);
+
+    return win;
+}
+
+static void usage(const char *prog)
+{
+    printf("usage: %s [-d display] [-w windows] [-r rounds]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    const char         *display = NULL;
+    uint32_t            nwindow = DEFAULT_WINDOWS;
+    uint32_t            nround  = DEFAULT_ROUNDS;
+    xcb_window_t       *windows;
+    xcb_screen_t       *screen;
+    uint32_t            nchange;
+    uint32_t            i;
+    double              start, setup, churn, destroy;
+    int                 opt;
+
+    while ((opt = getopt(argc, argv, "d:w:r:h")) != -1) {
+        switch (opt) {
+        case 'd': display = optarg;                         break;
+        case 'w': nwindow = strtoul(optarg, NULL, 10);      break;
+        case 'r': nround  = strtoul(optarg, NULL, 10);      break;
+        default:  usage(argv[0]);                           break;
+        }
+    }
+
+    if (nwindow < 1)
+        usage(argv[0]);
+
+    xconn = xcb_connect(display, NULL);
+
+    if (xcb_connection_has_error(xconn)) {
+        fprintf(stderr, "can't connect to X server '%s'\n",
+                display ? display : "$DISPLAY");
+        return 1;
+    }
+
+    screen = xcb_setup_roots_iterator(xcb_get_setup(xconn)).data;
+    root   = screen->root;
+
+    if ((windows = calloc(nwindow, sizeof(xcb_window_t))) == NULL ||
+        intern_atoms() < 0)
+    {
+        xcb_disconnect(xconn);
+        return 1;
+    }
+
+    nchange = 0;
+
+    /* window creation, ie. what videoep sees at application startup */
+    start = now();
+
+    for (i = 0;  i < nwindow;  i++) {
+        windows[i] = create_window(i);
+        set_window(root, atoms[NET_CLIENT_LIST], windows, i + 1);
+        nchange += 3;
+    }
+
+    sync_with_server();
+    setup = now() - start;
+
+    /* active window switches mixed with changes videoep should ignore */
+    start = now();
+
+    for (i = 0;  i < nround;  i++) {
+        set_window(root, atoms[NET_ACTIVE_WINDOW], windows + (i % nwindow), 1);
+        set_cardinal(windows[i % nwindow], atoms[NOISE], i);
+        nchange += 2;
+
+        if ((i + 1) % SYNC_INTERVAL == 0)
+            sync_with_server();
+    }
+
+    sync_with_server();
+    churn = now() - start;
+
+    /* tear down, one client list update per window */
+    start = now();
+
+    for (i = nwindow;  i > 0;  i--) {
+        xcb_destroy_window(xconn, windows[i - 1]);
+        set_window(root, atoms[NET_CLIENT_LIST], windows, i - 1);
+        nchange++;
+    }
+
+    sync_with_server();
+    destroy = now() - start;
+
+    printf("windows           : %u\n", nwindow);
+    printf("rounds            : %u\n", nround);
+    printf("property changes  : %u\n", nchange);
+    printf("setup             : %.3f ms\n", setup * 1e3);
+    printf("churn             : %.3f ms (%.2f usecs per round)\n",
+           churn * 1e3, nround ? churn * 1e6 / nround : 0.0);
+    printf("teardown          : %.3f ms\n", destroy * 1e3);
+    printf("round trips       : %u (%.1f usecs on average, %.1f at most)\n",
+           nsync, nsync ? synctime * 1e6 / nsync : 0.0,
+           syncmax * 1e6);
+
+    free(windows);
+    xcb_disconnect(xconn);
+
+    return 0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ * vim:set expandtab shiftwidth=4:
+ */
@@ -0,0 +1,84 @@
+#!/bin/sh
+
+#
+# Benchmark videoep against a virtual X server.
+#
+# Starts Xvfb with RandR, runs ohmd with the videoep plugin connected to
+# it, drives window and property churn with xvfb-bench and finally prints
+# what both sides measured: the client side timings from xvfb-bench and
+# the X event dispatch time, X round trips and function/resolver
+# executions videoep logs when ohmd exits. The dispatch time does not
+# include the property updates and executions deferred to idle time; the
+# cost of the executions is in their own statistics.
+#
+# ohmd must load xvfb-bench.ini as its videoep.ini (ie. install it as
+# /etc/ohm/plugins.d/videoep.ini, or point VIDEOEP_INI to where ohmd
+# reads it from) so that the plugin connects to the display given here
+# and uses xvfb-bench.conf. The script refuses to run otherwise.
+#
+
+DISPLAY_NUM=${DISPLAY_NUM:-:99}
+WINDOWS=${WINDOWS:-16}
+ROUNDS=${ROUNDS:-5000}
+OHMD=${OHMD:-ohmd --no-daemon}
+BENCH=${BENCH:-$(dirname $0)/xvfb-bench}
+LOG=${LOG:-/tmp/xvfb-bench-ohmd.log}
+BENCH_INI=$(dirname $0)/xvfb-bench.ini
+VIDEOEP_INI=${VIDEOEP_INI:-/etc/ohm/plugins.d/videoep.ini}
+
+XVFB_PID=""
+OHMD_PID=""
+
+cleanup() {
+    [ -n "$OHMD_PID" ] && kill $OHMD_PID 2>/dev/null
+    [ -n "$XVFB_PID" ] && kill $XVFB_PID 2>/dev/null
+}
+
+if ! cmp -s $BENCH_INI $VIDEOEP_INI; then
+    echo "$VIDEOEP_INI differs from $BENCH_INI;" \
+         "install $BENCH_INI as $VIDEOEP_INI first" 1>&2
+    exit 1
+fi
+
+if ! grep -q "^x-display *= *$DISPLAY_NUM *\$" $BENCH_INI; then
+    echo "$BENCH_INI does not connect videoep to $DISPLAY_NUM" 1>&2
+    exit 1
+fi
+
+trap cleanup EXIT INT TERM
+
+Xvfb $DISPLAY_NUM -screen 0 800x480x16 +extension RANDR -nolisten tcp &
+XVFB_PID=$!
+
+# wait for the server to accept connections
+for i in 1 2 3 4 5 6 7 8 9 10; do
+    xdpyinfo -display $DISPLAY_NUM >/dev/null 2>&1 && break
+    sleep 0.5
+done
+
+if ! kill -0 $XVFB_PID 2>/dev/null; then
+    echo "failed to start Xvfb on $DISPLAY_NUM" 1>&2
+    exit 1
+fi
+
+$OHMD >$LOG 2>&1 &
+OHMD_PID=$!
+
+# give videoep time to connect and do its startup discovery
+sleep 2
+
+echo "client side:"
+$BENCH -d $DISPLAY_NUM -w $WINDOWS -r $ROUNDS || exit 1
+
+# let ohmd drain the events before asking it to exit
+sleep 1
+
+kill -TERM $OHMD_PID
+wait $OHMD_PID
+OHMD_PID=""
+
+echo
+echo "videoep side:"
+grep -E "videoep: .*(X events|round trips|executed|notifications|startup|randr requested)" $LOG
+
+exit 0
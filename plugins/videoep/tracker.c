@@ -26,6 +26,7 @@ USA.
 #include <stdarg.h>
 #include <stdint.h>
 #include <errno.h>
+#include <time.h>
 
 #include "plugin.h"
 #include "tracker.h"
@@ -39,7 +40,12 @@ USA.
 #define APPPROP_MAX          10
 #define DIALPROP_MAX         10
 
-#define INVALID_INDEX        (~((uint32_t)0))
+#define INVALID_SLOT         ((uint8_t)0xff)  /* in def2idx tables */
+
+#define VALUE_INLINE_MAX     16    /* values up to this size are not malloced */
+#define WINDOW_CHUNK         32    /* windows allocated at a time */
+#define STARTUP_POLL         10    /* msecs between startup completion checks */
+#define STARTUP_TIMEOUT      5000  /* msecs to wait for the startup replies */
 
 #define WINDOW_HASH_BITS     8
 #define WINDOW_HASH_DIM      (1 << WINDOW_HASH_BITS)
@@ -62,6 +68,7 @@ typedef struct tracker_propinst_s {
     videoep_arg_t      arg;       /* property value as argument for functions*/
     uint32_t           size;      /* value storage size */
     exec_inst_t        exinst;    /* executable arguments */
+    uint32_t           inl[VALUE_INLINE_MAX / sizeof(uint32_t)];
 } tracker_propinst_t;
 
 #define TRACK_WINDOW_COMMON(t)      \
@@ -75,14 +82,14 @@ typedef struct tracker_anywin_s {
 
 typedef struct tracker_newwin_s {
     TRACK_WINDOW_COMMON(newwin);
-    uint32_t            def2idx[PROPERTY_MAX];  /* prop. def.idx => inst.idx */
+    uint8_t             def2idx[PROPERTY_MAX];  /* prop. def.idx => inst.idx */
     uint32_t            nprinst;                /* # of property values  */
     tracker_propinst_t  prinsts[0];             /* property values */
 } tracker_newwin_t;
 
 typedef struct tracker_appwin_s {
     TRACK_WINDOW_COMMON(appwin);
-    uint32_t            def2idx[PROPERTY_MAX];  /* prop. def.idx => inst.idx */
+    uint8_t             def2idx[PROPERTY_MAX];  /* prop. def.idx => inst.idx */
     uint32_t            nprinst;                /* # of property values  */
     tracker_propinst_t  prinsts[0];             /* property values */
 } tracker_appwin_t;
@@ -94,13 +101,23 @@ typedef union tracker_window_u {
     tracker_appwin_t        app;
 } tracker_window_t;
 
+typedef struct tracker_chunk_s {
+    struct tracker_chunk_s *next;
+    uint64_t                slots[0];    /* WINDOW_CHUNK * winslot bytes */
+} tracker_chunk_t;
+
+typedef struct {
+    uint64_t                begin;       /* when the connection came up */
+    guint                   srcid;       /* completion check timer */
+} tracker_startup_t;
+
 
 static uint32_t            atomval[ATOM_MAX];
 
 static tracker_window_t   *winhash[WINDOW_HASH_DIM];
 
 static uint32_t            rootwinxid;
-static uint32_t            rootdef2idx[PROPERTY_MAX];
+static uint8_t             rootdef2idx[PROPERTY_MAX];
 static tracker_propdef_t   rootprdefs[ROOTPROP_MAX];
 static tracker_propinst_t  rootprinsts[ROOTPROP_MAX];
 static uint32_t            nrootprop;
@@ -116,12 +133,29 @@ static tracker_propinst_t  appwprinsts[APPPROP_MAX];
 static uint32_t            nappwprop;
 static uint32_t            appwprdim = APPPROP_MAX;
 
+static tracker_chunk_t    *winchunks;     /* window arena */
+static tracker_window_t   *winfree;       /* free slots in the arena */
+static size_t              winslot;       /* size of a slot in the arena */
+static uint32_t            nwinchunk;
+static size_t              valheap;       /* bytes of malloced values */
+static tracker_startup_t   startup;
+
 static void connection_state(int, void *);
 
 static int               add_to_winhash(tracker_window_t *);
 static tracker_window_t *delete_from_winhash(uint32_t);
 static tracker_window_t *find_in_winhash(uint32_t);
 
+static tracker_window_t *alloc_window(void);
+static void              free_window(tracker_window_t *);
+static void              free_all_windows(void);
+
+static int               set_value(tracker_propinst_t *, void *, size_t);
+static void              clear_value(tracker_propinst_t *);
+
+static gboolean          startup_check(gpointer);
+static uint64_t          usecs_now(void);
+
 static tracker_newwin_t *create_newwin(uint32_t);
 static void              destroy_newwin(tracker_newwin_t *);
 static tracker_newwin_t *find_newwin(uint32_t);
@@ -143,7 +177,7 @@ static void rootwin_property_changed(uint32_t, uint32_t, videoep_value_type_t,
                                      videoep_value_t, uint32_t, void *);
 static void window_property_changed(uint32_t, uint32_t, videoep_value_type_t,
                                     videoep_value_t, uint32_t, void *);
-static void property_changed(uint32_t*, tracker_propinst_t*, uint32_t,uint32_t,
+static void property_changed(uint8_t*, tracker_propinst_t*, uint32_t,uint32_t,
                              videoep_value_type_t, videoep_value_t, uint32_t);
 
 static argument_inst_t *find_property_argument(const char *,
@@ -167,7 +201,7 @@ void tracker_init(OhmPlugin *plugin)
     ENTER;
 
     for (def = 0;  def < PROPERTY_MAX;  def++)
-        rootdef2idx[def] = INVALID_INDEX;
+        rootdef2idx[def] = INVALID_SLOT;
 
     xif_add_connection_callback(connection_state, NULL);
 
@@ -179,6 +213,16 @@ void tracker_exit(OhmPlugin *plugin)
     (void)plugin;
 
     xif_remove_connection_callback(connection_state, NULL);
+
+    if (startup.srcid)
+        g_source_remove(startup.srcid);
+
+    startup.srcid = 0;
+
+    OHM_INFO("videoep: tracker used %u window chunk(s) of %u bytes",
+             nwinchunk, (unsigned)(WINDOW_CHUNK * winslot));
+
+    free_all_windows();
 }
 
 int tracker_add_atom(const char *id, const char *name)
@@ -217,7 +261,7 @@ int tracker_add_rootwin_property(const char     *id,
             break;
         }
 
-        if (rootdef2idx[def] != INVALID_INDEX) {
+        if (rootdef2idx[def] != INVALID_SLOT) {
             OHM_ERROR("videoep: re-definition of rootwin property '%s'", id);
             break;
         }
@@ -527,12 +571,31 @@ static void connection_state(int connection_is_up, void *data)
     (void)data;
 
     if (connection_is_up) {
+        startup.begin = usecs_now();
+
         rootwinxid = window_create(WINDOW_ROOT_ID, NULL,NULL);
 
         for (i = 0;  i < nrootprop;  i++) {
             window_add_property(rootwinxid, rootprdefs[i].def,
                                 rootwin_property_changed, NULL);
         }
+
+        /*
+         * The root window properties list the existing windows, and the
+         * queries of all their tracked properties are issued right when
+         * the lists arrive, so they are flushed together. Startup is
+         * over when every reply has been processed.
+         */
+        if (!startup.srcid) {
+            startup.srcid = g_timeout_add_full(G_PRIORITY_LOW, STARTUP_POLL,
+                                               startup_check, NULL, NULL);
+        }
+    }
+    else {
+        if (startup.srcid)
+            g_source_remove(startup.srcid);
+
+        startup.srcid = 0;
     }
 }
 
@@ -596,6 +659,91 @@ static tracker_window_t *find_in_winhash(uint32_t xid)
     return NULL;
 } 
 
+/*
+ * Windows are allocated from an arena of fixed size slots that fit
+ * either window type; the slot size is settled by the first allocation,
+ * which happens after the configuration is complete.
+ */
+static tracker_window_t *alloc_window(void)
+{
+    tracker_chunk_t  *chunk;
+    tracker_window_t *win;
+    size_t            newsize;
+    size_t            appsize;
+    int               i;
+
+    if (winfree == NULL) {
+        if (!winslot) {
+            newsize = sizeof(tracker_newwin_t) +
+                      sizeof(tracker_propinst_t) * nnewwprop;
+            appsize = sizeof(tracker_appwin_t) +
+                      sizeof(tracker_propinst_t) * nappwprop;
+
+            winslot = newsize > appsize ? newsize : appsize;
+            winslot = (winslot + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t)-1);
+        }
+
+        if (!(chunk = malloc(sizeof(tracker_chunk_t) + WINDOW_CHUNK*winslot)))
+            return NULL;
+
+        chunk->next = winchunks;
+        winchunks = chunk;
+        nwinchunk++;
+
+        for (i = WINDOW_CHUNK - 1;  i >= 0;  i--) {
+            win = (tracker_window_t *)((char *)chunk->slots + i * winslot);
+            win->next = winfree;
+            winfree = win;
+        }
+    }
+
+    win = winfree;
+    winfree = win->next;
+
+    return win;
+}
+
+static void free_window(tracker_window_t *win)
+{
+    win->next = winfree;
+    winfree = win;
+}
+
+static void free_all_windows(void)
+{
+    tracker_chunk_t    *chunk;
+    tracker_window_t   *win;
+    tracker_propinst_t *prinsts;
+    uint32_t            nprop;
+    uint32_t            i, j;
+
+    for (i = 0;  i < WINDOW_HASH_DIM;  i++) {
+        for (win = winhash[i];  win;  win = win->next) {
+            if (win->any.type == tracker_newwin) {
+                prinsts = win->new.prinsts;
+                nprop   = win->new.nprinst;
+            }
+            else {
+                prinsts = win->app.prinsts;
+                nprop   = win->app.nprinst;
+            }
+
+            for (j = 0;  j < nprop;  j++)
+                clear_value(prinsts + j);
+        }
+    }
+
+    memset(winhash, 0, sizeof(winhash));
+
+    while ((chunk = winchunks) != NULL) {
+        winchunks = chunk->next;
+        free(chunk);
+    }
+
+    winfree   = NULL;
+    nwinchunk = 0;
+}
+
 static tracker_newwin_t *create_newwin(uint32_t xid)
 {
     tracker_window_t   *win;
@@ -608,7 +756,7 @@ static tracker_newwin_t *create_newwin(uint32_t xid)
 
     size = sizeof(tracker_newwin_t) + sizeof(tracker_propinst_t) * nnewwprop;
 
-    win = malloc(size);
+    win = alloc_window();
     if (!win) {
         OHM_ERROR("videoep: can't allocate memory for tracker window");
         return NULL;
@@ -623,8 +771,7 @@ static tracker_newwin_t *create_newwin(uint32_t xid)
     neww->xid    = xid;
     neww->nprinst = nnewwprop;
 
-    for (i = 0;   i < PROPERTY_MAX;   i++)
-        neww->def2idx[i] = INVALID_INDEX;
+    memset(neww->def2idx, INVALID_SLOT, sizeof(neww->def2idx));
 
     add_to_winhash(win);
 
@@ -673,9 +820,10 @@ static void destroy_newwin(tracker_newwin_t *neww)
         for (i = 0;  i < neww->nprinst;  i++) {
             tpi = neww->prinsts + i;
             exec_instance_clear(&tpi->exinst);
+            clear_value(tpi);
         }
         
-        free(neww);
+        free_window((tracker_window_t *)neww);
     } 
 }
 
@@ -702,7 +850,7 @@ static tracker_appwin_t *create_appwin(uint32_t xid)
 
     size = sizeof(tracker_appwin_t) + sizeof(tracker_propinst_t) * nappwprop;
 
-    win = malloc(size);
+    win = alloc_window();
     if (!win) {
         OHM_ERROR("videoep: can't allocate memory for tracker window");
         return NULL;
@@ -717,8 +865,7 @@ static tracker_appwin_t *create_appwin(uint32_t xid)
     appw->xid     = xid;
     appw->nprinst = nappwprop;
 
-    for (i = 0; i < PROPERTY_MAX; i++)
-        appw->def2idx[i] = INVALID_INDEX;
+    memset(appw->def2idx, INVALID_SLOT, sizeof(appw->def2idx));
 
     add_to_winhash(win);
 
@@ -756,33 +903,46 @@ static tracker_appwin_t *create_appwin(uint32_t xid)
     return appw;
 }
 
+/*
+ * The slots of the arena fit both window types, so the appwin simply
+ * takes over the slot of the newwin.
+ */
 static int change_newwin_to_appwin(tracker_newwin_t *neww)
 {
     tracker_window_t   *win;
     tracker_appwin_t   *appw;
     tracker_propdef_t  *tpd;
     tracker_propinst_t *tpi;
+    uint8_t             def2idx[PROPERTY_MAX];
+    uint32_t            xid;
     size_t              size;
     int                 err = 0;
     uint32_t            i;
 
     size = sizeof(tracker_appwin_t) + sizeof(tracker_propinst_t) * nappwprop;
 
-    win = malloc(size);
-    if (!win)
-        return 0;
+    xid = neww->xid;
+    memcpy(def2idx, neww->def2idx, sizeof(def2idx));
+
+    win = (tracker_window_t *)neww;
+    delete_from_winhash(xid);
+
+    OHM_DEBUG(DBG_TRACK, "clearing newwin 0x%x", xid);
+
+    for (i = 0;  i < neww->nprinst;  i++) {
+        tpi = neww->prinsts + i;
+        exec_instance_clear(&tpi->exinst);
+        clear_value(tpi);
+    }
 
     appw = &win->app;
 
     memset(appw, 0, size);
     appw->type    = tracker_appwin;
-    appw->xid     = neww->xid;
+    appw->xid     = xid;
     appw->nprinst = nappwprop;
 
-    memcpy(appw->def2idx, neww->def2idx, sizeof(appw->def2idx));
-
-    delete_from_winhash(neww->xid);
-    destroy_newwin(neww);
+    memcpy(appw->def2idx, def2idx, sizeof(appw->def2idx));
 
     add_to_winhash(win);
 
@@ -808,7 +968,7 @@ static int change_newwin_to_appwin(tracker_newwin_t *neww)
         OHM_ERROR("videoep: failed to setup %d exec.values", err);
 
         delete_from_winhash(appw->xid);
-        free(win);
+        destroy_appwin(appw);
 
         return -1;
     }
@@ -834,9 +994,10 @@ static void destroy_appwin(tracker_appwin_t *appw)
         for (i = 0;  i < appw->nprinst;  i++) {
             tpi = appw->prinsts + i;
             exec_instance_clear(&tpi->exinst);
+            clear_value(tpi);
         }
             
-        free(appw);
+        free_window((tracker_window_t *)appw);
     } 
 }
 
@@ -1049,7 +1210,7 @@ static void window_property_changed(uint32_t             winxid,
     tracker_window_t   *win;
     tracker_appwin_t   *appw;
     tracker_newwin_t   *neww;
-    uint32_t           *def2idx;
+    uint8_t            *def2idx;
     tracker_propinst_t *prinsts;
     uint32_t            nprinst;
     const char         *wintyp;
@@ -1088,7 +1249,7 @@ static void window_property_changed(uint32_t             winxid,
     }
 }
 
-static void property_changed(uint32_t            *def2idx,
+static void property_changed(uint8_t             *def2idx,
                              tracker_propinst_t  *prinsts,
                              uint32_t             nprop,
                              uint32_t             def,
@@ -1110,7 +1271,7 @@ static void property_changed(uint32_t            *def2idx,
     if (type == videoep_link)
         return;
 
-    if ((idx = def2idx[def]) == INVALID_INDEX) {
+    if ((idx = def2idx[def]) == INVALID_SLOT) {
         OHM_DEBUG(DBG_TRACK, "can't find property");
         return;
     }
@@ -1148,23 +1309,107 @@ static void property_changed(uint32_t            *def2idx,
               memcmp(value.generic, tpi->arg.value.pointer, size);
 
     if (changed) {
-#if 0
-        free(tpi->arg.value.pointer);
-#endif
-            
-        if ((tpi->arg.value.pointer = malloc(size)) == NULL)
+        if (set_value(tpi, value.generic, size) < 0)
             return;
 
-        memcpy(tpi->arg.value.pointer, value.generic, size);
         tpi->arg.type = type;
         tpi->arg.dim  = dim;
-        tpi->size     = size;
+
+        exec_instance_schedule(exi);
+    }
+}
+
+
+/*
+ * Small values are kept inside the property instance, only the bigger
+ * ones go to the heap.
+ */
+static int set_value(tracker_propinst_t *tpi, void *data, size_t size)
+{
+    void *buf;
+
+    if (size <= sizeof(tpi->inl))
+        buf = tpi->inl;
+    else {
+        if ((buf = malloc(size)) == NULL)
+            return -1;
+
+        valheap += size;
+    }
+
+    clear_value(tpi);
+
+    memcpy(buf, data, size);
+
+    tpi->arg.value.pointer = buf;
+    tpi->size = size;
+
+    return 0;
+}
+
+static void clear_value(tracker_propinst_t *tpi)
+{
+    void *buf = tpi->arg.value.pointer;
+
+    if (buf != NULL && buf != (void *)tpi->inl) {
+        valheap -= tpi->size;
+        free(buf);
+    }
+
+    tpi->arg.value.pointer = NULL;
+    tpi->size = 0;
+}
+
+static gboolean startup_check(gpointer data)
+{
+    tracker_window_t *win;
+    uint64_t          usecs;
+    uint32_t          nwin;
+    uint32_t          nprop;
+    uint32_t          npending;
+    size_t            bytes;
+    uint32_t          i;
+
+    (void)data;
+
+    usecs = usecs_now() - startup.begin;
+
+    if ((npending = xif_pending_replies()) > 0) {
+        if (usecs < STARTUP_TIMEOUT * 1000ULL)
+            return TRUE;
+
+        OHM_INFO("videoep: tracker stopped waiting for startup with %u "
+                 "replies still pending", npending);
     }
 
-    if (changed)
-        exec_instance_execute(exi);
+    for (i = 0, nwin = 0, bytes = valheap;  i < WINDOW_HASH_DIM;  i++) {
+        for (win = winhash[i];  win;  win = win->next) {
+            nprop  = win->any.type == tracker_newwin ? win->new.nprinst :
+                                                       win->app.nprinst;
+            bytes += winslot + window_footprint(nprop) +
+                     nprop * property_instance_footprint();
+            nwin++;
+        }
+    }
+
+    OHM_INFO("videoep: tracker startup took %u.%03u ms, %u window(s) tracked "
+             "using %u bytes per window", (unsigned)(usecs / 1000),
+             (unsigned)(usecs % 1000), nwin,
+             nwin ? (unsigned)(bytes / nwin) : 0);
+
+    startup.srcid = 0;
+
+    return FALSE;
 }
 
+static uint64_t usecs_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
 
 static argument_inst_t *find_property_argument(const char         *id,
                                                tracker_propinst_t *prinsts,
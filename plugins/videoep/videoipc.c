@@ -35,6 +35,7 @@ USA.
 #include <X11/Xatom.h>
 
 #include <policy/videoipc.h>
+#include <videostate.h>
 
 #include "plugin.h"
 #include "videoipc.h"
@@ -52,12 +53,18 @@ static int         length;      /* length of the shared memory */
 static videoipc_t *ipc;         /* shared memory data */
 static uint32_t    mtatomidx;   /* index of the message type atom */
 static update_t    update;
+static videostate_t      *state;  /* seqlocked state for local readers */
+static videostate_data_t  staged; /* what goes to 'state' at update end */
 
 
 static int  init_shmem(void);
 static void exit_shmem(void);
 static int  init_shfile(int, size_t);
 
+static int  init_state(void);
+static void exit_state(void);
+static void write_state(void);
+
 static int  init_message(void);
 static void exit_message(void);
 static int  send_message(uint32_t);
@@ -73,6 +80,7 @@ void videoipc_init(OhmPlugin *plugin)
     (void)plugin;
 
     init_shmem();
+    init_state();
     init_message();
 }
 
@@ -81,6 +89,7 @@ void videoipc_exit(OhmPlugin *plugin)
     (void)plugin;
 
     exit_shmem();
+    exit_state();
     exit_message();
 }
 
@@ -96,6 +105,7 @@ void videoipc_update_start(void)
 
 void videoipc_update_end(void)
 {
+    write_state();
     send_message(update.mask);
 }
 
@@ -145,6 +155,15 @@ void videoipc_update_section(uint32_t mask, pid_t *pids, int npid)
             *idxptr = newidx;
 
             update.mask |= mask;
+
+            if (mask == VIDEOIPC_XVIDEO_SECTION) {
+                if (npid > VIDEOSTATE_MAX_XV_USERS)
+                    npid = VIDEOSTATE_MAX_XV_USERS;
+
+                staged.mask   |= VIDEOSTATE_XVIDEO_SECTION;
+                staged.nxvuser = npid;
+                memcpy(staged.xvusers, pids, npid * sizeof(pid_t));
+            }
         }
     }
 
@@ -280,6 +299,42 @@ static int init_shfile(int fd, size_t size)
     return TRUE;
 }
 
+static int init_state(void)
+{
+    if ((state = videostate_open(NULL, TRUE)) == NULL) {
+        OHM_ERROR("videoep: can't create shared state object '%s': %s",
+                  VIDEOSTATE_SHARED_OBJECT, strerror(errno));
+        return FALSE;
+    }
+
+    OHM_INFO("videoep: shared state '%s' is OK (version %d)",
+             VIDEOSTATE_SHARED_OBJECT, VIDEOSTATE_VERSION);
+
+    return TRUE;
+}
+
+static void exit_state(void)
+{
+    videostate_close(state);
+    state = NULL;
+}
+
+static void write_state(void)
+{
+    if (state != NULL && staged.mask) {
+        staged.time = update.time;
+
+        videostate_write_begin(state);
+        state->data = staged;
+        videostate_write_end(state);
+
+        OHM_DEBUG(DBG_IPC, "shared state updated (mask 0x%x, sequence %u)",
+                  staged.mask, state->seq);
+
+        staged.mask = 0;
+    }
+}
+
 static int init_message(void)
 {
     mtatomidx = atom_create("videoipcmt", VIDEOIPC_CLIENT_MESSAGE);
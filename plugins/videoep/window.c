@@ -38,7 +38,7 @@ USA.
 #define WINDOW_HASH_MASK        (WINDOW_HASH_DIM - 1)
 #define WINDOW_HASH_INDEX(i)    ((i) & WINDOW_HASH_MASK)
 
-#define PROPERTY_HASH_BITS      8
+#define PROPERTY_HASH_BITS      3     /* a window has only a few of them */
 #define PROPERTY_HASH_DIM       (1 << PROPERTY_HASH_BITS)
 #define PROPERTY_HASH_MASK      (PROPERTY_HASH_DIM - 1)
 #define PROPERTY_HASH_INDEX(i)  ((i) & PROPERTY_HASH_MASK)
@@ -69,6 +69,7 @@ typedef struct win_def_s {
 
 
 static win_def_t  *winhash[WINDOW_HASH_DIM];
+static uint32_t    nwindow;      /* number of non-root windows created */
 
 static void connection_state(int, void *);
 
@@ -113,8 +114,19 @@ void window_init(OhmPlugin *plugin)
 
 void window_exit(OhmPlugin *plugin)
 {
+    uint32_t requests;
+    uint32_t flushes;
+
     (void)plugin;
 
+    xif_get_statistics(&requests, &flushes);
+
+    if (nwindow > 0) {
+        OHM_INFO("videoep: %u X requests in %u round trips for %u windows "
+                 "(%.1f round trips per window)", requests, flushes, nwindow,
+                 (double)flushes / (double)nwindow);
+    }
+
     xif_remove_connection_callback(connection_state, NULL);
     xif_remove_destruction_callback(window_destroyed, NULL);
     xif_remove_property_change_callback(property_changed, NULL);
@@ -190,6 +202,11 @@ int window_update_property_values(uint32_t xid)
     return sts;
 }
 
+size_t window_footprint(uint32_t nprop)
+{
+    return sizeof(win_def_t) + nprop * sizeof(win_prop_t);
+}
+
 int window_get_event_mask(uint32_t xid, uint32_t *evmask)
 {
     win_def_t *win;
@@ -254,8 +271,10 @@ static win_def_t *create_window(uint32_t        id,
 
             winhash[idx] = win;
 
-            if (!root)
+            if (!root) {
                 xif_track_destruction_on_window(xid, XIF_START);
+                nwindow++;
+            }
 
             OHM_DEBUG(DBG_WIN, "added window 0x%x/0x%x", id, xid);
         }
@@ -433,6 +452,8 @@ static void add_to_property_hash(win_prop_t *prop)
         prop->hash = NULL;
     }
 
+    xif_route_property_changes(win->xid, prop->xid, XIF_START);
+
     OHM_DEBUG(DBG_WIN, "property added to window hash table");
 }
 
@@ -452,15 +473,20 @@ static void remove_from_property_hash(win_prop_t *prop)
         win->hash[hidx] = prop->hash;
     else {
         for (prev = win->hash[hidx];  prev->hash;  prev = prev->hash) {
-            if (prev->hash == prop) {
-                prev->hash = prop->hash;
+            if (prev->hash == prop)
                 break;
-            }
         }
+
+        if (prev->hash == NULL)
+            return;             /* it was not in the hash */
+
+        prev->hash = prop->hash;
     }
     
     prop->hash = NULL;
 
+    xif_route_property_changes(win->xid, prop->xid, XIF_STOP);
+
     OHM_DEBUG(DBG_WIN, "property removed from window hash table");
 }
 
@@ -22,6 +22,7 @@ USA.
 #define __OHM_VIDEOEP_WINDOW_H__
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include "data-types.h"
 
@@ -42,6 +43,7 @@ uint32_t window_create(uint32_t, window_destcb_t, void *);
 
 int window_add_property(uint32_t, uint32_t, window_propcb_t, void *);
 int window_update_property_values(uint32_t);
+size_t window_footprint(uint32_t);
 
 int window_get_event_mask(uint32_t, uint32_t *);
 int window_set_event_mask(uint32_t, uint32_t);
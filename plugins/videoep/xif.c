@@ -27,6 +27,7 @@ USA.
 #include <netinet/in.h>
 #include <errno.h>
 #include <signal.h>
+#include <time.h>
 
 #include <xcb/xcb.h>
 #include <xcb/xproto.h>
@@ -44,21 +45,15 @@ USA.
 #define SCREEN_MAX 4
 
 #define QUEUE_BITS               5
-#define QUEUE_DIM                (1 << QUEUE_BITS)
-#define QUEUE_MASK               (QUEUE_DIM - 1)
-#define QUEUE_INDEX(i)           ((i) & QUEUE_MASK)
+#define QUEUE_DIM                (1 << QUEUE_BITS) /* initial queue size */
 
-#define ATOM_QUERY_DIM           QUEUE_DIM
-#define ATOM_QUERY_INDEX(i)      QUEUE_INDEX(i)
+#define QUERY_POOL_MAX           64    /* max. number of cached queries */
 
-#define PROPERTY_QUERY_DIM       QUEUE_DIM
-#define PROPERTY_QUERY_INDEX(i)  QUEUE_INDEX(i)
-
-#define MODE_CREATE_DIM          QUEUE_DIM
-#define MODE_CREATE_INDEX(i)     QUEUE_INDEX(i)
-
-#define RANDR_QUERY_DIM          QUEUE_DIM
-#define RANDR_QUERY_INDEX(i)     QUEUE_INDEX(i)
+#define ROUTE_BITS               8
+#define ROUTE_DIM                (1 << ROUTE_BITS)
+#define ROUTE_MASK               (ROUTE_DIM - 1)
+#define ROUTE_INDEX(w,a)         (((w) ^ ((w) >> ROUTE_BITS) ^ ((a) << 3)) & \
+                                  ROUTE_MASK)
 
 struct xif_s;
 
@@ -70,9 +65,18 @@ typedef struct {
     void               *data;
 } request_t;
 
+/*
+ * XCB delivers the replies in request order, so the pending requests
+ * are kept in a FIFO ring that grows on demand and only its head needs
+ * to be polled.
+ */
 typedef struct {
-    int                 length;
-    request_t           requests[QUEUE_DIM];
+    request_t          *requests;
+    uint32_t            dim;       /* size of the ring, power of 2 */
+    uint32_t            head;      /* index of the oldest request */
+    uint32_t            length;    /* number of pending requests */
+    uint32_t            peak;      /* maximum length seen so far */
+    uint32_t            rejected;  /* requests we could not queue */
 } rque_t;
 
 typedef struct conncb_s {
@@ -93,6 +97,17 @@ typedef struct propcb_s {
     void               *usrdata;
 } propcb_t;
 
+/*
+ * property notifications are only delivered for the (window, property)
+ * pairs somebody has asked for; the rest is dropped right in xevent_cb()
+ */
+typedef struct route_s {
+    struct route_s     *next;
+    uint32_t            window;
+    uint32_t            property;
+    int                 refcnt;
+} route_t;
+
 typedef struct crtccb_s {
     struct crtccb_s     *next;
     xif_crtc_notifycb_t  callback;
@@ -105,6 +120,12 @@ typedef struct outpcb_s {
     void                  *usrdata;
 } outpcb_t;
 
+typedef struct oprocb_s {
+    struct oprocb_s        *next;
+    xif_outprop_notifycb_t  callback;
+    void                   *usrdata;
+} oprocb_t;
+
 
 typedef struct xif_s {
     char               *display;
@@ -121,22 +142,30 @@ typedef struct xif_s {
         uint16_t height;
     }                   screen[SCREEN_MAX];
     rque_t              rque;      /* que for the pending requests */
+    guint               flush;     /* idle source of the pending flush */
+    uint32_t            nrequest;  /* number of requests sent */
+    uint32_t            nflush;    /* number of flushes, ie. writes */
     conncb_t           *conncb;    /* connection callbacks */
     structcb_t         *destcb;    /* window destroy callbacks */
     propcb_t           *propcb;    /* property change callbacks */
+    route_t            *routes[ROUTE_DIM]; /* routed property changes */
+    uint32_t            nfiltered; /* property notifications dropped */
+    uint32_t            ndelivered;/* property notifications delivered */
+    uint32_t            nevent;    /* events dispatched */
+    uint64_t            evusecs;   /* time spent dispatching events */
+    uint32_t            evmax;     /* longest event dispatch in usecs */
     crtccb_t           *crtccb;    /* RandR crtc change callbacks */
     outpcb_t           *outpcb;    /* RandR output change callbacks */
+    oprocb_t           *oprocb;    /* RandR output property callbacks */
 } xif_t;
 
 typedef struct {
-    int                busy;
     const char        *name;
     xif_atom_replycb_t replycb;
     void              *usrdata;
 } atom_query_t;
 
 typedef struct {
-    int                   busy;
     uint32_t              window;
     uint32_t              property;
     videoep_value_type_t  type;
@@ -146,7 +175,6 @@ typedef struct {
 
 
 typedef struct {
-    int          busy;
     const char  *name;
 } mode_create_t;
 
@@ -159,7 +187,6 @@ typedef enum {
 } randr_query_type_t;
 
 #define RANDR_QUERY_COMMON      \
-    int                   busy; \
     randr_query_type_t    type
 
 typedef struct {
@@ -206,6 +233,14 @@ typedef union {
     randr_query_outprop_t outprop;
 } randr_query_t;
 
+typedef union query_u {
+    union query_u        *next;    /* link while on the free list */
+    atom_query_t          atom;
+    prop_query_t          prop;
+    mode_create_t         mode;
+    randr_query_t         randr;
+} query_t;
+
 typedef enum {
     eevent_unknown = 0,
     event_property,
@@ -222,14 +257,9 @@ typedef struct {
 static uint32_t       polltime = 1000; /* 1 sec */
 static xif_t         *xiface;
 static extension_t    randr;
-static atom_query_t   atom_qry[ATOM_QUERY_DIM];
-static uint32_t       atom_idx;
-static prop_query_t   prop_qry[PROPERTY_QUERY_DIM];
-static uint32_t       prop_idx;
-static mode_create_t  mode_creat[MODE_CREATE_DIM];
-static uint32_t       mode_idx;
-static randr_query_t  randr_qry[RANDR_QUERY_DIM];
-static uint32_t       randr_idx;
+static int            batching = TRUE; /* flush once per loop iteration */
+static query_t       *query_pool;     /* free list of query contexts */
+static int            query_nfree;
 static int            conn_warn = TRUE;
 
 
@@ -238,9 +268,14 @@ static void     xif_destroy(xif_t *);
 static int      connect_to_xserver(xif_t *);
 static void     disconnect_from_xserver(xif_t *);
 static gboolean timeout_handler(gpointer);
+static void     flush_requests(xif_t *);
+static gboolean flush_cb(gpointer);
 
 static int  event_select(xif_t *, uint32_t, uint32_t *, event_t, int);
 
+static route_t *find_route(xif_t *, uint32_t, uint32_t);
+static void     destroy_routes(xif_t *);
+
 static int  atom_query(xif_t *, const char *, xif_atom_replycb_t, void *);
 static void atom_query_finish(xif_t *, void *, void *);
 
@@ -272,13 +307,19 @@ static xif_connstate_t randr_connection_to_state(uint8_t);
 
 static int  check_version(uint32_t, uint32_t, uint32_t, uint32_t);
 
-static int  rque_is_full(rque_t *);
-static int  rque_append_request(rque_t *, unsigned int, reply_handler_t,void*);
+static int  rque_append_request(xif_t *, unsigned int, reply_handler_t,void*);
 static int  rque_poll_reply(xcb_connection_t *, rque_t *,
                             void **, reply_handler_t *, void **);
+static void rque_flush(xif_t *);
+static void rque_destroy(rque_t *);
+
+static void *query_alloc(void);
+static void  query_free(void *);
+static void  query_pool_flush(void);
 
 static gboolean xio_cb(GIOChannel *, GIOCondition, gpointer);
 static void xevent_cb(xif_t *, xcb_generic_event_t *);
+static uint64_t usecs_now(void);
 
 static void sigpipe_init();
 static void sigpipe_exit();
@@ -290,11 +331,27 @@ static void sigpipe_exit();
 
 void xif_init(OhmPlugin *plugin)
 {
-    (void)plugin;
+    const char *batching_str;
+    const char *display;
 
     ENTER;
 
-    xiface = xif_create(":0");
+    if ((display = ohm_plugin_get_param(plugin, "x-display")) == NULL)
+        display = ":0";
+
+    if ((batching_str = ohm_plugin_get_param(plugin, "x-request-batching"))) {
+        if (!strcmp(batching_str, "no"))
+            batching = FALSE;
+        else if (strcmp(batching_str, "yes")) {
+            OHM_ERROR("videoep: invalid value '%s' for 'x-request-batching'",
+                      batching_str);
+        }
+    }
+
+    OHM_INFO("videoep: X requests are flushed %s", batching ?
+             "once per main loop iteration" : "one by one");
+
+    xiface = xif_create(display);
     sigpipe_init();
 
     LEAVE;
@@ -305,6 +362,7 @@ void xif_exit(OhmPlugin *plugin)
     (void)plugin;
 
     xif_destroy(xiface);
+    query_pool_flush();
     sigpipe_exit();
 }
 
@@ -493,6 +551,57 @@ int xif_track_property_changes_on_window(uint32_t window, int track)
     return status;
 }
 
+int xif_route_property_changes(uint32_t window, uint32_t property, int route)
+{
+    route_t  *rt;
+    route_t  *prev;
+    uint32_t  idx;
+
+    if (!xiface)
+        return -1;
+
+    idx = ROUTE_INDEX(window, property);
+
+    if (route) {
+        if ((rt = find_route(xiface, window, property)) != NULL)
+            rt->refcnt++;
+        else {
+            if ((rt = malloc(sizeof(route_t))) == NULL)
+                return -1;
+
+            rt->next     = xiface->routes[idx];
+            rt->window   = window;
+            rt->property = property;
+            rt->refcnt   = 1;
+
+            xiface->routes[idx] = rt;
+
+            OHM_DEBUG(DBG_XCB, "routing changes of property 0x%x on "
+                      "window 0x%x", property, window);
+        }
+
+        return 0;
+    }
+
+    for (prev = (route_t *)&xiface->routes[idx]; prev->next; prev = prev->next) {
+        rt = prev->next;
+
+        if (rt->window == window && rt->property == property) {
+            if (--rt->refcnt <= 0) {
+                prev->next = rt->next;
+                free(rt);
+
+                OHM_DEBUG(DBG_XCB, "stopped routing changes of property 0x%x "
+                          "on window 0x%x", property, window);
+            }
+
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
 int xif_add_destruction_callback(xif_structurecb_t destcb, void *usrdata)
 {
     structcb_t *scb;
@@ -642,6 +751,39 @@ int xif_add_randr_output_change_callback(xif_output_notifycb_t  outpcb,
     return -1;
 }
 
+int xif_add_randr_outprop_change_callback(xif_outprop_notifycb_t  oprocb,
+                                          void                   *usrdata)
+{
+    oprocb_t  *pcb;
+    oprocb_t  *cur;
+    oprocb_t  *last;
+
+    if (!oprocb || !xiface)
+        return -1;
+
+    for (last = (oprocb_t*)&xiface->oprocb;  last->next;  last = last->next) {
+        cur = last->next;
+
+        if (oprocb == cur->callback && usrdata == cur->usrdata)
+            return 0;
+    }
+
+    if ((pcb = malloc(sizeof(oprocb_t))) != NULL) {
+        memset(pcb, 0, sizeof(oprocb_t));
+        pcb->callback = oprocb;
+        pcb->usrdata  = usrdata;
+    
+        last->next = pcb;
+
+        OHM_DEBUG(DBG_XCB, "added RandR output property change callback "
+                  "%p/%p", oprocb,usrdata);
+
+        return 0;
+    }
+
+    return -1;
+}
+
 int xif_remove_randr_crtc_change_callback(xif_crtc_notifycb_t  crtccb,
                                           void                *usrdata)
 {
@@ -696,6 +838,33 @@ int xif_remove_randr_output_change_callback(xif_output_notifycb_t  outpcb,
     return -1;
 }
 
+int xif_remove_randr_outprop_change_callback(xif_outprop_notifycb_t  oprocb,
+                                             void                   *usrdata)
+{
+    oprocb_t *pcb;
+    oprocb_t *prev;
+
+    for (prev = (oprocb_t *)&xiface->oprocb;  prev->next;  prev = prev->next) {
+        pcb = prev->next;
+
+        if (oprocb == pcb->callback && usrdata == pcb->usrdata) {
+
+            OHM_DEBUG(DBG_XCB, "removed RandR output property change "
+                      "callback %p/%p", oprocb, usrdata);
+
+            prev->next = pcb->next;
+            free(pcb);
+
+            return 0;
+        }
+    }
+
+    OHM_DEBUG(DBG_XCB, "can't remove RandR output property change callback "
+              "%p/%p: no matching callback registration", oprocb, usrdata);
+
+    return -1;
+}
+
 int xif_track_randr_changes_on_window(uint32_t window, int track)
 {
     static int        mask = XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE  |
@@ -723,7 +892,7 @@ int xif_track_randr_changes_on_window(uint32_t window, int track)
                 OHM_DEBUG(DBG_XCB, "%s tracking RandR changes on "
                           "window 0x%x", track_str, window);
 
-                xcb_flush(xiface->xconn);
+                flush_requests(xiface);
             }
         }
     }
@@ -920,7 +1089,7 @@ int xif_output_property_change(uint32_t                output,
                     OHM_DEBUG(DBG_XCB, "changing RandR output 0x%x property "
                               "0x%x (num_units %u)", output, property, length);
 
-                    xcb_flush(xiface->xconn);
+                    flush_requests(xiface);
                 }
             }
         }
@@ -994,7 +1163,7 @@ int xif_send_client_message(uint32_t              window,
                     OHM_DEBUG(DBG_XCB, "sent client message to "
                               "window 0x%x", window);
 
-                    xcb_flush(xiface->xconn);
+                    flush_requests(xiface);
                 }
 
             } 
@@ -1007,6 +1176,20 @@ int xif_send_client_message(uint32_t              window,
 }                            
 
 
+void xif_get_statistics(uint32_t *requests, uint32_t *flushes)
+{
+    if (requests != NULL)
+        *requests = xiface ? xiface->nrequest : 0;
+
+    if (flushes != NULL)
+        *flushes = xiface ? xiface->nflush : 0;
+}
+
+uint32_t xif_pending_replies(void)
+{
+    return xiface ? xiface->rque.length : 0;
+}
+
 int xif_crtc_config(uint32_t cfgtime, xif_crtc_t *crtc)
 {
     int status;
@@ -1052,6 +1235,26 @@ static void xif_destroy(xif_t *xif)
             free(ccb);
         }
 
+        OHM_INFO("videoep: at most %u X requests were pending, "
+                 "%u requests were rejected", xif->rque.peak,
+                 xif->rque.rejected);
+        OHM_INFO("videoep: %u property notifications delivered, "
+                 "%u filtered", xif->ndelivered, xif->nfiltered);
+
+        /*
+         * this is the dispatch time only; the property updates and the
+         * executions the events trigger are deferred to idle callbacks
+         */
+        if (xif->nevent > 0) {
+            OHM_INFO("videoep: %u X events dispatched in %.3f ms "
+                     "(%.1f usecs on average, %u usecs at most)",
+                     xif->nevent, (double)xif->evusecs / 1000.0,
+                     (double)xif->evusecs / (double)xif->nevent, xif->evmax);
+        }
+
+        destroy_routes(xif);
+
+        rque_destroy(&xif->rque);
         free(xif->display);
 
         free(xif);
@@ -1181,19 +1384,24 @@ static void disconnect_from_xserver(xif_t *xif)
         if (xif->timeout)
             g_source_remove(xif->timeout);
 
+        if (xif->flush)
+            g_source_remove(xif->flush);
+
         if (xif->evsrc) 
             g_source_remove(xif->evsrc);
 
         if (xif->chan != NULL)
             g_io_channel_unref(xif->chan);
 
+        rque_flush(xif);
+
         if (xif->xconn != NULL)
             xcb_disconnect(xif->xconn);
 
-        memset(&xif->rque, 0, sizeof(xif->rque));
         memset( xif->root, 0, sizeof(xif->root));
 
         xif->propcb  = NULL;
+        xif->flush   = 0;
         xif->nscreen = 0;
         xif->evsrc   = 0;
         xif->chan    = NULL;
@@ -1257,29 +1465,57 @@ static int event_select(xif_t    *xif,
 
     *mask = evmask;
 
-    xcb_flush(xif->xconn);
+    flush_requests(xif);
 
     return 0;
 }
 
+/*
+ * Requests are written to the X server in one go once the current main
+ * loop iteration is over, so eg. all the property queries of a newly
+ * mapped window share a single round trip. The blocking XCB calls flush
+ * by themselves.
+ */
+static void flush_requests(xif_t *xif)
+{
+    xif->nrequest++;
+
+    if (!batching) {
+        xcb_flush(xif->xconn);
+        xif->nflush++;
+    }
+    else if (!xif->flush)
+        xif->flush = g_idle_add_full(G_PRIORITY_HIGH, flush_cb, xif, NULL);
+}
+
+static gboolean flush_cb(gpointer data)
+{
+    xif_t *xif = (xif_t *)data;
+
+    xif->flush = 0;
+
+    if (xif->xconn != NULL) {
+        xcb_flush(xif->xconn);
+        xif->nflush++;
+    }
+
+    return FALSE;
+}
+
 static int atom_query(xif_t              *xif,
                       const char         *name,
                       xif_atom_replycb_t  replycb,
                       void               *usrdata)
 {
-    atom_query_t             *aq = atom_qry + atom_idx;
+    atom_query_t             *aq;
     xcb_intern_atom_cookie_t  ckie;
 
     if (xif->xconn == NULL || xcb_connection_has_error(xif->xconn))
         return -1;
 
-    if (rque_is_full(&xif->rque)) {
-        OHM_ERROR("videoep: xif request queue is full");
-        return -1;
-    }
-
-    if (aq->busy) {
-        OHM_ERROR("videoep: maximum number of pending atom queries reached");
+    if ((aq = query_alloc()) == NULL) {
+        xif->rque.rejected++;
+        OHM_ERROR("videoep: can't allocate atom query");
         return -1;
     }
 
@@ -1287,21 +1523,19 @@ static int atom_query(xif_t              *xif,
 
     if (xcb_connection_has_error(xif->xconn)) {
         OHM_ERROR("videoep: failed to query attribute def '%s'", name);
+        query_free(aq);
         return -1;
     }
 
     OHM_DEBUG(DBG_XCB, "querying atom '%s'", name);
 
-    aq->busy    = TRUE;
     aq->name    = strdup(name);
     aq->replycb = replycb;
     aq->usrdata = usrdata;
 
-    atom_idx = ATOM_QUERY_INDEX(atom_idx + 1);
-
-    rque_append_request(&xif->rque, ckie.sequence, atom_query_finish, aq);
+    rque_append_request(xif, ckie.sequence, atom_query_finish, aq);
 
-    xcb_flush(xif->xconn);
+    flush_requests(xif);
 
     return 0;
 }
@@ -1319,11 +1553,10 @@ static void atom_query_finish(xif_t *xif, void *reply_data, void *data)
         OHM_DEBUG(DBG_XCB, "atom '%s' queried: %u", aq->name, reply->atom);
 
         aq->replycb(aq->name, reply->atom, aq->usrdata);
-
-        free((void *)aq->name);
     }
 
-    memset(aq, 0, sizeof(atom_query_t));
+    free((void *)aq->name);
+    query_free(aq);
 }
 
 
@@ -1335,20 +1568,15 @@ static int property_query(xif_t                *xif,
                           xif_prop_replycb_t    replycb,
                           void                 *usrdata)
 {
-    prop_query_t              *pq = prop_qry + prop_idx;
+    prop_query_t              *pq;
     xcb_get_property_cookie_t  ckie;
 
     if (xif->xconn == NULL || xcb_connection_has_error(xif->xconn))
         return -1;
 
-    if (rque_is_full(&xif->rque)) {
-        OHM_ERROR("videoep: xif request queue is full");
-        return -1;
-    }
-
-    if (pq->busy) {
-        OHM_ERROR("videoep: maximum number of pending property "
-                  "queries reached");
+    if ((pq = query_alloc()) == NULL) {
+        xif->rque.rejected++;
+        OHM_ERROR("videoep: can't allocate property query");
         return -1;
     }
 
@@ -1356,23 +1584,21 @@ static int property_query(xif_t                *xif,
 
     if (xcb_connection_has_error(xif->xconn)) {
         OHM_ERROR("videoep: failed to query property");
+        query_free(pq);
         return -1;
     }
 
     OHM_DEBUG(DBG_XCB, "querying property");
 
-    pq->busy     = TRUE;
     pq->window   = window;
     pq->property = property;
     pq->type     = type;
     pq->replycb  = replycb;
     pq->usrdata  = usrdata;
 
-    prop_idx = PROPERTY_QUERY_INDEX(prop_idx + 1);
-
-    rque_append_request(&xif->rque, ckie.sequence, property_query_finish, pq);
+    rque_append_request(xif, ckie.sequence, property_query_finish, pq);
 
-    xcb_flush(xif->xconn);
+    flush_requests(xif);
 
     return 0;
 }
@@ -1410,9 +1636,37 @@ static void property_query_finish(xif_t *xif, void *reply_data, void *data)
 
     }
 
-    memset(pq, 0, sizeof(prop_query_t));
+    query_free(pq);
+}
+
+
+static route_t *find_route(xif_t *xif, uint32_t window, uint32_t property)
+{
+    route_t *rt;
+
+    for (rt = xif->routes[ROUTE_INDEX(window, property)];  rt;  rt = rt->next){
+        if (rt->window == window && rt->property == property)
+            return rt;
+    }
+
+    return NULL;
 }
 
+static void destroy_routes(xif_t *xif)
+{
+    route_t  *rt;
+    route_t  *next;
+    uint32_t  i;
+
+    for (i = 0;  i < ROUTE_DIM;  i++) {
+        for (rt = xif->routes[i];  rt;  rt = next) {
+            next = rt->next;
+            free(rt);
+        }
+
+        xif->routes[i] = NULL;
+    }
+}
 
 static int randr_check(xif_t *xif, extension_t *ext)
 {
@@ -1520,14 +1774,14 @@ static int randr_set_screen_size(xif_t        *xif,
     OHM_DEBUG(DBG_XCB, "setting screen of rootwin 0x%x size %ux%u pixels "
               "(%lux%lu mm)", rootwin, width,height, mm_width,mm_height);
 
-    xcb_flush(xif->xconn);
+    flush_requests(xif);
 
     return 0;    
 }
 
 static int randr_create_mode(xif_t *xif, xcb_window_t rwin, xif_mode_t *mode)
 {
-    mode_create_t                  *mc = mode_creat + mode_idx;
+    mode_create_t                  *mc;
     xcb_randr_create_mode_cookie_t  ckie;
     xcb_randr_mode_info_t           info;
     size_t                          namlen;
@@ -1535,13 +1789,9 @@ static int randr_create_mode(xif_t *xif, xcb_window_t rwin, xif_mode_t *mode)
     if (xif->xconn == NULL || xcb_connection_has_error(xif->xconn))
         return -1;
 
-    if (rque_is_full(&xif->rque)) {
-        OHM_ERROR("videoep: xif request queue is full");
-        return -1;
-    }
-
-    if (mc->busy) {
-        OHM_ERROR("videoep: maximum number of pending mode cretation reached");
+    if ((mc = query_alloc()) == NULL) {
+        xif->rque.rejected++;
+        OHM_ERROR("videoep: can't allocate mode creation query");
         return -1;
     }
 
@@ -1565,18 +1815,16 @@ static int randr_create_mode(xif_t *xif, xcb_window_t rwin, xif_mode_t *mode)
 
     if (xcb_connection_has_error(xif->xconn)) {
         OHM_ERROR("videoep: failed to create new mode '%s'", mode->name);
+        query_free(mc);
         return -1;
     }
 
-    mc->busy = TRUE;
     mc->name = strdup(mode->name);
 
-    mode_idx = MODE_CREATE_INDEX(mode_idx + 1);
-
-    rque_append_request(&xif->rque, ckie.sequence,
+    rque_append_request(xif, ckie.sequence,
                         randr_create_mode_finish, mc);
 
-    xcb_flush(xif->xconn);
+    flush_requests(xif);
 
     return 0;    
 
@@ -1596,12 +1844,10 @@ static void randr_create_mode_finish(xif_t *xif, void *reply_data, void *data)
     else {
         OHM_INFO("videoep: '%s' mode (0x%x) successfuly created",
                  mc->name, reply->mode);
-
-        free((void *)mc->name);
-        mc->name = NULL;
     }
 
-    memset(mc, 0, sizeof(mode_create_t));
+    free((void *)mc->name);
+    query_free(mc);
 }
 
 static int randr_query_screen(xif_t                *xif,
@@ -1609,7 +1855,7 @@ static int randr_query_screen(xif_t                *xif,
                               xif_screen_replycb_t  replycb,
                               void                 *usrdata)
 {
-    randr_query_t                           *rq = randr_qry + randr_idx;
+    randr_query_t                           *rq;
     xcb_randr_get_screen_resources_cookie_t  ckie;
 
     (void)xif;
@@ -1617,13 +1863,9 @@ static int randr_query_screen(xif_t                *xif,
     if (xif->xconn == NULL || xcb_connection_has_error(xif->xconn))
         return -1;
 
-    if (rque_is_full(&xif->rque)) {
-        OHM_ERROR("videoep: xif request queue is full");
-        return -1;
-    }
-
-    if (rq->any.busy) {
-        OHM_ERROR("videoep: maximum number of pending RandR queries reached");
+    if ((rq = query_alloc()) == NULL) {
+        xif->rque.rejected++;
+        OHM_ERROR("videoep: can't allocate RandR query");
         return -1;
     }
 
@@ -1631,22 +1873,20 @@ static int randr_query_screen(xif_t                *xif,
 
     if (xcb_connection_has_error(xif->xconn)) {
         OHM_ERROR("videoep: failed to query RandR screen resources");
+        query_free(rq);
         return -1;
     }
 
     OHM_DEBUG(DBG_XCB, "querying RandR screen resources");
 
-    rq->screen.busy    = TRUE;
     rq->screen.type    = query_screen;
     rq->screen.window  = window;
     rq->screen.replycb = replycb;
     rq->screen.usrdata = usrdata;
 
-    randr_idx = RANDR_QUERY_INDEX(randr_idx + 1);
-
-    rque_append_request(&xif->rque, ckie.sequence,
+    rque_append_request(xif, ckie.sequence,
                         randr_query_screen_finish, rq);
-    xcb_flush(xif->xconn);
+    flush_requests(xif);
 
     return 0;
 }
@@ -1741,7 +1981,7 @@ static void randr_query_screen_finish(xif_t *xif, void *reply_data, void *data)
         sq->replycb(&st, sq->usrdata);
     }
 
-    memset(rq, 0, sizeof(randr_query_t));
+    query_free(rq);
 
 #undef MAX_MODES
 #undef NAME_LENGTH
@@ -1754,19 +1994,15 @@ static int randr_query_crtc(xif_t              *xif,
                             xif_crtc_replycb_t  replycb,
                             void               *usrdata)
 {
-    randr_query_t                    *rq = randr_qry + randr_idx;
+    randr_query_t                    *rq;
     xcb_randr_get_crtc_info_cookie_t  ckie;
 
     if (xif->xconn == NULL || xcb_connection_has_error(xif->xconn))
         return -1;
 
-    if (rque_is_full(&xif->rque)) {
-        OHM_ERROR("videoep: xif request queue is full");
-        return -1;
-    }
-
-    if (rq->any.busy) {
-        OHM_ERROR("videoep: maximum number of pending RandR queries reached");
+    if ((rq = query_alloc()) == NULL) {
+        xif->rque.rejected++;
+        OHM_ERROR("videoep: can't allocate RandR query");
         return -1;
     }
 
@@ -1774,23 +2010,21 @@ static int randr_query_crtc(xif_t              *xif,
 
     if (xcb_connection_has_error(xif->xconn)) {
         OHM_ERROR("videoep: failed to query RandR crtc");
+        query_free(rq);
         return -1;
     }
 
     OHM_DEBUG(DBG_XCB, "querying RandR crtc 0x%x", crtc);
 
-    rq->crtc.busy    = TRUE;
     rq->crtc.type    = query_crtc;
     rq->crtc.window  = window;
     rq->crtc.xid     = crtc;
     rq->crtc.replycb = replycb;
     rq->crtc.usrdata = usrdata;
 
-    randr_idx = RANDR_QUERY_INDEX(randr_idx + 1);
-
-    rque_append_request(&xif->rque, ckie.sequence,
+    rque_append_request(xif, ckie.sequence,
                         randr_query_crtc_finish, rq);
-    xcb_flush(xif->xconn);
+    flush_requests(xif);
 
     return 0;
 }
@@ -1826,7 +2060,7 @@ static void randr_query_crtc_finish(xif_t *xif, void *reply_data, void *data)
         cq->replycb(&ct, cq->usrdata);
     }
 
-    memset(rq, 0, sizeof(randr_query_t));
+    query_free(rq);
 }
 
 static int randr_config_crtc(xif_t      *xif,
@@ -1856,7 +2090,7 @@ static int randr_config_crtc(xif_t      *xif,
 
     OHM_DEBUG(DBG_XCB, "configuring RandR crtc 0x%x", crtc->xid);
 
-    xcb_flush(xif->xconn);
+    flush_requests(xif);
 
     return 0;    
 }
@@ -1869,19 +2103,15 @@ static int randr_query_output(xif_t                *xif,
                               xif_output_replycb_t  replycb,
                               void                 *usrdata)
 {
-    randr_query_t                      *rq = randr_qry + randr_idx;
+    randr_query_t                      *rq;
     xcb_randr_get_output_info_cookie_t  ckie;
 
     if (xif->xconn == NULL || xcb_connection_has_error(xif->xconn))
         return -1;
 
-    if (rque_is_full(&xif->rque)) {
-        OHM_ERROR("videoep: xif request queue is full");
-        return -1;
-    }
-
-    if (rq->any.busy) {
-        OHM_ERROR("videoep: maximum number of pending RandR queries reached");
+    if ((rq = query_alloc()) == NULL) {
+        xif->rque.rejected++;
+        OHM_ERROR("videoep: can't allocate RandR query");
         return -1;
     }
 
@@ -1889,23 +2119,21 @@ static int randr_query_output(xif_t                *xif,
 
     if (xcb_connection_has_error(xif->xconn)) {
         OHM_ERROR("videoep: failed to query RandR output");
+        query_free(rq);
         return -1;
     }
 
     OHM_DEBUG(DBG_XCB, "querying RandR output 0x%x", output);
 
-    rq->output.busy    = TRUE;
     rq->output.type    = query_output;
     rq->output.window  = window;
     rq->output.xid     = output;
     rq->output.replycb = replycb;
     rq->output.usrdata = usrdata;
 
-    randr_idx = RANDR_QUERY_INDEX(randr_idx + 1);
-
-    rque_append_request(&xif->rque, ckie.sequence,
+    rque_append_request(xif, ckie.sequence,
                         randr_query_output_finish, rq);
-    xcb_flush(xif->xconn);
+    flush_requests(xif);
 
     return 0;
 }
@@ -1952,7 +2180,7 @@ static void randr_query_output_finish(xif_t *xif, void *reply_data, void *data)
         oq->replycb(&ot, oq->usrdata);
     }
 
-    memset(rq, 0, sizeof(randr_query_t));
+    query_free(rq);
 
 #undef NAME_MAX_LENGTH
 }
@@ -1966,19 +2194,15 @@ static int randr_query_output_property(xif_t                  *xif,
                                        xif_outprop_replycb_t   replycb,
                                        void                   *usrdata)
 {
-    randr_query_t                          *rq = randr_qry + randr_idx;
+    randr_query_t                          *rq;
     xcb_randr_get_output_property_cookie_t  ckie;
 
     if (xif->xconn == NULL || xcb_connection_has_error(xif->xconn))
         return -1;
 
-    if (rque_is_full(&xif->rque)) {
-        OHM_ERROR("videoep: xif request queue is full");
-        return -1;
-    }
-
-    if (rq->any.busy) {
-        OHM_ERROR("videoep: maximum number of pending RandR queries reached");
+    if ((rq = query_alloc()) == NULL) {
+        xif->rque.rejected++;
+        OHM_ERROR("videoep: can't allocate RandR query");
         return -1;
     }
 
@@ -1987,13 +2211,13 @@ static int randr_query_output_property(xif_t                  *xif,
 
     if (xcb_connection_has_error(xif->xconn)) {
         OHM_ERROR("videoep: failed to query RandR output property");
+        query_free(rq);
         return -1;
     }
 
     OHM_DEBUG(DBG_XCB, "querying RandR output property 0x%x/0x%x",
               output, property);
 
-    rq->outprop.busy    = TRUE;
     rq->outprop.type    = query_outprop;
     rq->outprop.window  = window;
     rq->outprop.output  = output;
@@ -2001,11 +2225,9 @@ static int randr_query_output_property(xif_t                  *xif,
     rq->outprop.replycb = replycb;
     rq->outprop.usrdata = usrdata;
 
-    randr_idx = RANDR_QUERY_INDEX(randr_idx + 1);
-
-    rque_append_request(&xif->rque, ckie.sequence,
+    rque_append_request(xif, ckie.sequence,
                         randr_query_output_property_finish, rq);
-    xcb_flush(xif->xconn);
+    flush_requests(xif);
 
     return 0;
 }
@@ -2041,7 +2263,7 @@ static void randr_query_output_property_finish(xif_t *xif,
                     value, length, pq->usrdata);
     }
 
-    memset(rq, 0, sizeof(randr_query_t));
+    query_free(rq);
 }
 
 
@@ -2056,6 +2278,7 @@ static int  randr_event_handler(xif_t *xif, xcb_generic_event_t *ev)
     xif_crtc_t                              crtc;
     crtccb_t                               *ccb;
     outpcb_t                               *ocb;
+    oprocb_t                               *pcb;
     int                                     i;
     int                                     handled = FALSE;
 
@@ -2127,7 +2350,16 @@ static int  randr_event_handler(xif_t *xif, xcb_generic_event_t *ev)
 
         case XCB_RANDR_NOTIFY_OUTPUT_PROPERTY:
             oproev = &rndrev->u.op;
-            OHM_DEBUG(DBG_XCB, "RandR output property change event");
+
+            OHM_DEBUG(DBG_XCB, "RandR output 0x%x property 0x%x change event "
+                      "on window 0x%x", oproev->output, oproev->atom,
+                      oproev->window);
+
+            for (pcb = xif->oprocb;   pcb;   pcb = pcb->next) {
+                pcb->callback(oproev->window, oproev->output, oproev->atom,
+                              pcb->usrdata);
+            }
+
             break;
             
         default:
@@ -2168,30 +2400,60 @@ static int check_version(uint32_t required_major_version,
 }
 
 
-static int rque_is_full(rque_t *rque)
-{
-    return (rque->length >= QUEUE_DIM);
-}
-
-static int rque_append_request(rque_t          *rque,
+static int rque_append_request(xif_t           *xif,
                                unsigned int     seq,
                                reply_handler_t  hlr,
                                void            *data)
 {
+    rque_t    *rque = &xif->rque;
+    request_t *requests;
     request_t *req;
+    uint32_t   dim;
+    uint32_t   i;
 
-    if (rque_is_full(rque))
-        return -1;
-    
-    req = rque->requests + rque->length++;
+    if (rque->length >= rque->dim) {
+        dim = rque->dim ? 2 * rque->dim : QUEUE_DIM;
+
+        if ((requests = malloc(dim * sizeof(request_t))) == NULL) {
+            OHM_ERROR("videoep: can't grow X request queue to %u entries",
+                      dim);
+
+            rque->rejected++;
+
+            xcb_discard_reply(xif->xconn, seq);
+            hlr(xif, NULL, data);
+
+            return -1;
+        }
+
+        for (i = 0;  i < rque->length;  i++)
+            requests[i] = rque->requests[(rque->head + i) & (rque->dim - 1)];
+
+        free(rque->requests);
+
+        rque->requests = requests;
+        rque->dim      = dim;
+        rque->head     = 0;
+
+        OHM_DEBUG(DBG_XCB, "X request queue grown to %u entries", dim);
+    }
+
+    req = rque->requests + ((rque->head + rque->length) & (rque->dim - 1));
 
     req->sequence = seq;
     req->handler  = hlr;
     req->data     = data;
 
+    if (++rque->length > rque->peak)
+        rque->peak = rque->length;
+
     return 0;
 }
 
+/*
+ * Replies come in request order. If the oldest request is still
+ * unanswered so are all the others, so only the head is polled.
+ */
 static int rque_poll_reply(xcb_connection_t *xconn,
                            rque_t           *rque,
                            void            **reply,
@@ -2199,37 +2461,103 @@ static int rque_poll_reply(xcb_connection_t *xconn,
                            void             **data_ret)
 {
     xcb_generic_error_t *e;
-    int i, j;
+    request_t           *req;
 
-    if (!reply || !hlr_ret || !data_ret)
+    if (!reply || !hlr_ret || !data_ret || !rque->length)
         return 0;
 
-    for (i = 0;  i < rque->length;  i++) {
-        e = NULL;
+    req = rque->requests + rque->head;
+    e   = NULL;
 
-        if (xcb_poll_for_reply(xconn, rque->requests[i].sequence, reply, &e)) {
+    if (!xcb_poll_for_reply(xconn, req->sequence, reply, &e))
+        return 0;
 
-            *hlr_ret  = rque->requests[i].handler;
-            *data_ret = rque->requests[i].data;
- 
-            for (j = i+1;  j < rque->length;  j++) 
-                rque->requests[j-1] = rque->requests[j];
+    *hlr_ret  = req->handler;
+    *data_ret = req->data;
 
-            rque->length--;
+    rque->head = (rque->head + 1) & (rque->dim - 1);
+    rque->length--;
 
-            if (e == NULL && *reply != NULL) {
-                return 1;
-            }
+    if (e != NULL) {
+        free(e);
+        *reply = NULL;
+    }
 
-            if (e != NULL) {
-                free(e);
-                *reply = NULL;
-                return 1;
-            }
+    return 1;
+}
+
+/*
+ * Complete all pending requests with a NULL reply, eg. when the
+ * connection goes down, so that their query contexts get released.
+ */
+static void rque_flush(xif_t *xif)
+{
+    rque_t    *rque = &xif->rque;
+    request_t *req;
+
+    while (rque->length > 0) {
+        req = rque->requests + rque->head;
+
+        rque->head = (rque->head + 1) & (rque->dim - 1);
+        rque->length--;
+
+        req->handler(xif, NULL, req->data);
+    }
+
+    rque->head = 0;
+}
+
+static void rque_destroy(rque_t *rque)
+{
+    free(rque->requests);
+
+    rque->requests = NULL;
+    rque->dim      = 0;
+    rque->head     = 0;
+    rque->length   = 0;
+}
+
+static void *query_alloc(void)
+{
+    query_t *query;
+
+    if ((query = query_pool) != NULL) {
+        query_pool = query->next;
+        query_nfree--;
+    }
+    else if ((query = malloc(sizeof(query_t))) == NULL)
+        return NULL;
+
+    memset(query, 0, sizeof(query_t));
+
+    return query;
+}
+
+static void query_free(void *ptr)
+{
+    query_t *query = ptr;
+
+    if (query != NULL) {
+        if (query_nfree >= QUERY_POOL_MAX)
+            free(query);
+        else {
+            query->next = query_pool;
+            query_pool  = query;
+            query_nfree++;
         }
     }
+}
 
-    return 0;
+static void query_pool_flush(void)
+{
+    query_t *query;
+
+    while ((query = query_pool) != NULL) {
+        query_pool = query->next;
+        free(query);
+    }
+
+    query_nfree = 0;
 }
 
 static gboolean xio_cb(GIOChannel *ch, GIOCondition cond, gpointer data)
@@ -2240,6 +2568,8 @@ static gboolean xio_cb(GIOChannel *ch, GIOCondition cond, gpointer data)
     void                *reply;
     reply_handler_t      hlr;
     void                *ud;
+    uint64_t             start;
+    uint32_t             usecs;
     gboolean             retval;
 
     if (ch != xif->chan) {
@@ -2259,8 +2589,18 @@ static gboolean xio_cb(GIOChannel *ch, GIOCondition cond, gpointer data)
         else {
 
             while ((ev = xcb_poll_for_event(xconn)) != NULL) {
+                start = usecs_now();
+
                 xevent_cb(xif, ev);
                 free(ev);
+
+                usecs = (uint32_t)(usecs_now() - start);
+
+                xif->nevent++;
+                xif->evusecs += usecs;
+
+                if (usecs > xif->evmax)
+                    xif->evmax = usecs;
             }
 
             while (rque_poll_reply(xconn, &xif->rque, &reply, &hlr, &ud)) {
@@ -2303,6 +2643,13 @@ static void xevent_cb(xif_t *xif, xcb_generic_event_t *ev)
         window = propev->window;
         id     = propev->atom;
 
+        if (find_route(xif, window, id) == NULL) {
+            xif->nfiltered++;
+            break;
+        }
+
+        xif->ndelivered++;
+
         OHM_DEBUG(DBG_XCB, "got property notify event on window 0x%x "
                   "(property %d 0x%x)", window, id, id);
 
@@ -2320,6 +2667,15 @@ static void xevent_cb(xif_t *xif, xcb_generic_event_t *ev)
     }
 }
 
+static uint64_t usecs_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
 
 /*
  * Notes:
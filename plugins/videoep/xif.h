@@ -119,6 +119,7 @@ typedef void (*xif_outprop_replycb_t)(uint32_t, uint32_t, uint32_t,
 typedef void (*xif_crtc_notifycb_t)(xif_crtc_t *, void *);
 typedef void (*xif_output_replycb_t)(xif_output_t *, void *);
 typedef void (*xif_output_notifycb_t)(xif_output_t *, void *);
+typedef void (*xif_outprop_notifycb_t)(uint32_t, uint32_t, uint32_t, void *);
 
 
 void xif_init(OhmPlugin *);
@@ -132,6 +133,7 @@ int  xif_is_connected_to_xserver(void);
 int  xif_add_property_change_callback(xif_propertycb_t, void *);
 int  xif_remove_property_change_callback(xif_propertycb_t, void *);
 int  xif_track_property_changes_on_window(uint32_t, int);
+int  xif_route_property_changes(uint32_t, uint32_t, int);
 
 int  xif_add_destruction_callback(xif_structurecb_t, void *);
 int  xif_remove_destruction_callback(xif_structurecb_t, void *);
@@ -141,6 +143,8 @@ int xif_add_randr_crtc_change_callback(xif_crtc_notifycb_t, void *);
 int xif_add_randr_output_change_callback(xif_output_notifycb_t, void *);
 int xif_remove_randr_crtc_change_callback(xif_crtc_notifycb_t, void *);
 int xif_remove_randr_output_change_callback(xif_output_notifycb_t, void *);
+int xif_add_randr_outprop_change_callback(xif_outprop_notifycb_t, void *);
+int xif_remove_randr_outprop_change_callback(xif_outprop_notifycb_t, void *);
 int xif_track_randr_changes_on_window(uint32_t, int);
 
 uint32_t xif_root_window_query(uint32_t *, uint32_t);
@@ -164,6 +168,9 @@ int      xif_send_client_message(uint32_t, uint32_t, int, videoep_value_type_t,
 
 int xif_crtc_config(uint32_t, xif_crtc_t *);
 
+void xif_get_statistics(uint32_t *, uint32_t *);
+uint32_t xif_pending_replies(void);
+
 #endif /* __OHM_VIDEOEP_XIF_H__ */
 
 /* 
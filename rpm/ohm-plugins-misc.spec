@@ -172,6 +172,7 @@ rm -rf %{buildroot}
 rm -f -- $RPM_BUILD_ROOT%{_sysconfdir}/X11/Xsession.post/55ohm-session-agent
 rm -f -- $RPM_BUILD_ROOT%{_libdir}/ohm/*.la
 rm -f -- $RPM_BUILD_ROOT%{_libdir}/ohm/libohm_call_test.so
+rm -f -- $RPM_BUILD_ROOT%{_libdir}/ohm/libohm_resource_bench.so
 rm -f -- $RPM_BUILD_ROOT%{_datadir}/ohm-session-agent/start-session-agent.sh
 
 install -d %{buildroot}%{_sysconfdir}/dbus-1/session.d
@@ -252,6 +253,7 @@ fi
 %defattr(-,root,root,-)
 # >> files ohm-plugin-signaling
 %{_libdir}/ohm/libohm_signaling.so
+%config %{_sysconfdir}/ohm/plugins.d/signaling.ini
 # << files ohm-plugin-signaling
 
 %files -n ohm-plugin-media